@@ -0,0 +1,51 @@
+#include "BootCache.h"
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+static uint32_t checksum(const BootSnapshot &snapshot) {
+  const uint8_t *bytes = (const uint8_t *)&snapshot;
+  uint32_t hash = FNV_OFFSET_BASIS;
+
+  for (size_t i = 0; i < offsetof(BootSnapshot, checksum); i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+
+  return hash;
+}
+
+void bootCacheSeal(BootSnapshot &snapshot) {
+  snapshot.version = BOOT_CACHE_VERSION;
+  snapshot.checksum = checksum(snapshot);
+}
+
+bool bootCacheValid(const BootSnapshot &snapshot) {
+  return snapshot.version == BOOT_CACHE_VERSION &&
+         snapshot.checksum == checksum(snapshot);
+}
+
+bool bootCacheSameContent(const BootSnapshot &a, const BootSnapshot &b) {
+  return a.insideAt == b.insideAt &&
+         a.outsideAt == b.outsideAt &&
+         a.insideReading == b.insideReading &&
+         a.outsideReading == b.outsideReading;
+}
+
+bool bootCacheSave(BootSnapshot &snapshot, BootCacheWriteCb write, void *ctx) {
+  bootCacheSeal(snapshot);
+
+  return write(ctx, (const uint8_t *)&snapshot, sizeof(snapshot)) ==
+         sizeof(snapshot);
+}
+
+bool bootCacheLoad(BootSnapshot &snapshot, BootCacheReadCb read, void *ctx) {
+  BootSnapshot loaded;
+
+  if (read(ctx, (uint8_t *)&loaded, sizeof(loaded)) != sizeof(loaded) ||
+      !bootCacheValid(loaded)) {
+    return false;
+  }
+
+  snapshot = loaded;
+  return true;
+}
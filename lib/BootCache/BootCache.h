@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// bumped whenever BootSnapshot changes, older records are ignored
+#define BOOT_CACHE_VERSION 2
+
+/**
+ * What the main screen needs to be drawn right after power-on, before WiFi,
+ * NTP and the first sensor requests are done. Kept in RTC memory, which
+ * survives deep sleep, and in flash for everything else.
+ */
+struct BootSnapshot {
+  uint32_t version;
+  // UTC of the last NTP synced second when the snapshot was taken
+  uint32_t utcEpoch;
+  // UTC when the readings were fetched, 0 when there is none
+  uint32_t insideAt;
+  uint32_t outsideAt;
+  // fixed point like the live readings, SENSOR_NO_VALUE when there is none
+  int16_t  insideReading;
+  int16_t  outsideReading;
+  uint32_t checksum;
+};
+
+typedef size_t (*BootCacheWriteCb)(void *ctx, const uint8_t *data, size_t length);
+typedef size_t (*BootCacheReadCb)(void *ctx, uint8_t *data, size_t length);
+
+/**
+ * Stamps the version and checksum, done by bootCacheSave() as well
+ */
+void bootCacheSeal(BootSnapshot &snapshot);
+
+/**
+ * @return true for a sealed snapshot of the current version, false for
+ *         uninitialized memory, a torn write or an older layout
+ */
+bool bootCacheValid(const BootSnapshot &snapshot);
+
+/**
+ * @return true when a and b hold the same readings, fetched at the same
+ *         time, so a flash write can be skipped. utcEpoch moves on every
+ *         second and is not compared.
+ */
+bool bootCacheSameContent(const BootSnapshot &a, const BootSnapshot &b);
+
+/**
+ * Seals snapshot and writes it through write
+ *
+ * @return true when everything was written
+ */
+bool bootCacheSave(BootSnapshot &snapshot, BootCacheWriteCb write, void *ctx);
+
+/**
+ * Reads a snapshot written by bootCacheSave() through read
+ *
+ * @return true when a complete, valid snapshot was read
+ */
+bool bootCacheLoad(BootSnapshot &snapshot, BootCacheReadCb read, void *ctx);
@@ -0,0 +1,460 @@
+#include "DeskApp.h"
+
+#include <string.h>
+
+#include "HaSensor.h"
+#include "Hal.h"
+#include "Logger.h"
+#include "Screens.h"
+#include "Widgets.h"
+
+static const HaEntityFormat *const SENSOR_FORMATS[] = {&HA_SENSOR_TEMPERATURE,
+                                                       &HA_WEATHER_TEMPERATURE};
+
+// everything the main screen shows, a frame is only drawn when this changes
+struct FrameContent {
+  uint32_t second;
+  int16_t  insideReading;
+  int16_t  outsideReading;
+  bool     connected;
+  bool     activity;
+  uint8_t  step;
+  uint8_t  wifiBars;
+  uint8_t  page;
+  uint32_t stockUpdates;
+  uint32_t historySamples;
+  bool     stale;
+};
+
+// everything an extra panel shows, it is only drawn when this changes
+struct ExtraPanelContent {
+  uint8_t  page;
+  uint32_t mainFrame;
+  uint32_t stockUpdates;
+  uint32_t historySamples;
+  bool     stale;
+};
+
+static void copyFrame(const uint8_t *frame, void *ctx) {
+  memcpy(ctx, frame, FRAMEBUFFER_SIZE);
+}
+
+DeskApp::DeskApp(Framebuffer &screen, DisplayPipeline &pipeline,
+                 PanelFanout &fanout, TimerWheel &scheduler,
+                 StockTicker &stocks, TimeSeries &insideHistory,
+                 TimeSeries &outsideHistory)
+    : _screen(screen), _pipeline(pipeline), _fanout(fanout),
+      _scheduler(scheduler), _stocks(stocks), _insideHistory(insideHistory),
+      _outsideHistory(outsideHistory) {
+  this->_readings[DESK_APP_INSIDE] = SENSOR_NO_VALUE;
+  this->_readings[DESK_APP_OUTSIDE] = SENSOR_NO_VALUE;
+  memset(this->_panelPages, 0, sizeof(this->_panelPages));
+  memset(&this->_liveState, 0, sizeof(this->_liveState));
+}
+
+void DeskApp::setHooks(const DeskAppHooks &hooks) {
+  this->_hooks = hooks;
+}
+
+void DeskApp::setMainJob(int8_t job) {
+  this->_mainJob = job;
+}
+
+void DeskApp::setPanelPage(uint8_t panel, uint8_t page) {
+  if (panel < PANEL_FANOUT_MAX_PANELS) this->_panelPages[panel] = page;
+}
+
+void DeskApp::setShowWiFiIcon(bool show) {
+  this->_showWiFiIcon = show;
+}
+
+void DeskApp::setTimeSynced() {
+  this->_timeSynced = true;
+}
+
+bool DeskApp::timeSynced() const {
+  return this->_timeSynced;
+}
+
+bool DeskApp::handleSensorResponse(DeskAppSensor sensor, int status,
+                                   const uint8_t *body, size_t length) {
+  if (status != 200) return false;
+
+  DeserializationError error = haParseReading(
+      body, length, *SENSOR_FORMATS[sensor], this->_readings[sensor]);
+  if (error) {
+    LOG_WARN("Sensor response not understood: %s", error.c_str());
+    return false;
+  }
+
+  this->_fresh[sensor] = true;
+  this->_readingAt[sensor] = this->_hooks.utcEpoch();
+  return true;
+}
+
+void DeskApp::setStockSymbols(const char *list) {
+  this->_stocks.setSymbols(list);
+  this->_symbolList++;
+}
+
+uint8_t DeskApp::nextStockFetch() {
+  this->_fetchSymbolList = this->_symbolList;
+  return this->_stocks.nextFetch();
+}
+
+bool DeskApp::handleStockResponse(uint8_t index, int status,
+                                  const uint8_t *body, size_t length) {
+  if (status != 200 || index >= STOCK_TICKER_MAX_SYMBOLS) return false;
+
+  int32_t price, previousClose;
+  DeserializationError error =
+      stockParseQuote(body, length, price, previousClose);
+  if (error) {
+    LOG_WARN("deserializeJson() failed: %s", error.c_str());
+    return false;
+  }
+
+  // quotes for a symbol come minutes apart, the last one is never that late
+  if (this->_quotePending[index].load(std::memory_order_acquire)) {
+    LOG_WARN("Quote dropped, the last one wasn't recorded yet");
+    return false;
+  }
+
+  PendingQuote &quote = this->_quotes[index];
+  quote.price = price;
+  quote.previousClose = previousClose;
+  quote.symbolList = this->_fetchSymbolList;
+  this->_quotePending[index].store(true, std::memory_order_release);
+  return true;
+}
+
+void DeskApp::recordStockQuotes() {
+  for (uint8_t index = 0; index < STOCK_TICKER_MAX_SYMBOLS; index++) {
+    if (!this->_quotePending[index].load(std::memory_order_acquire)) continue;
+
+    const PendingQuote &quote = this->_quotes[index];
+    if (quote.symbolList == this->_symbolList) {
+      this->_stocks.record(index, quote.price, quote.previousClose);
+    }
+    this->_quotePending[index].store(false, std::memory_order_release);
+  }
+}
+
+void DeskApp::recordHistory() {
+  uint32_t now = this->_hooks.utcEpoch();
+
+  if (this->_readings[DESK_APP_INSIDE] != SENSOR_NO_VALUE) {
+    this->_insideHistory.append(now, this->_readings[DESK_APP_INSIDE]);
+  }
+  if (this->_readings[DESK_APP_OUTSIDE] != SENSOR_NO_VALUE) {
+    this->_outsideHistory.append(now, this->_readings[DESK_APP_OUTSIDE]);
+  }
+}
+
+void DeskApp::restoreSnapshot(const BootSnapshot &snapshot) {
+  this->_readings[DESK_APP_INSIDE] = snapshot.insideReading;
+  this->_readings[DESK_APP_OUTSIDE] = snapshot.outsideReading;
+}
+
+void DeskApp::updateSnapshot(BootSnapshot &snapshot) {
+  if (this->_timeSynced) snapshot.utcEpoch = this->_hooks.utcEpoch();
+  if (this->_fresh[DESK_APP_INSIDE]) {
+    snapshot.insideAt = this->_readingAt[DESK_APP_INSIDE];
+    snapshot.insideReading = this->_readings[DESK_APP_INSIDE];
+  }
+  if (this->_fresh[DESK_APP_OUTSIDE]) {
+    snapshot.outsideAt = this->_readingAt[DESK_APP_OUTSIDE];
+    snapshot.outsideReading = this->_readings[DESK_APP_OUTSIDE];
+  }
+}
+
+void DeskApp::handleTouchEvent(const TouchEvent &event) {
+  switch (event.type) {
+  case TOUCH_EVENT_PRESS:
+    this->_activity = true;
+    this->_step = 0;
+    // start the animation now instead of on the next second
+    this->_scheduler.trigger(this->_mainJob);
+    break;
+  case TOUCH_EVENT_RELEASE:
+    this->_activity = false;
+    break;
+  case TOUCH_EVENT_TAP:
+    this->showNextPage();
+    break;
+  case TOUCH_EVENT_DOUBLE_TAP:
+    if (this->_hooks.doubleTap) this->_hooks.doubleTap();
+    break;
+  case TOUCH_EVENT_LONG_PRESS:
+    if (this->_hooks.longPress) this->_hooks.longPress();
+    break;
+  }
+}
+
+void DeskApp::setActivity(bool on) {
+  this->_activity = on;
+}
+
+bool DeskApp::activity() const {
+  return this->_activity;
+}
+
+uint8_t DeskApp::step() const {
+  return this->_step;
+}
+
+void DeskApp::nextStep() {
+  this->_step =
+      (this->_step > 0 && this->_step % MAX_STEPS == 0) ? 0 : this->_step + 1;
+}
+
+uint8_t DeskApp::page() const {
+  return this->_page;
+}
+
+uint8_t DeskApp::historyPage() {
+  return this->_stocks.symbolCount() + 1;
+}
+
+void DeskApp::showNextPage() {
+  this->_page = (this->_page + 1) % (this->historyPage() + 1);
+  this->_pageShownAt = halMillis();
+  this->_scheduler.trigger(this->_mainJob);
+}
+
+int16_t DeskApp::reading(DeskAppSensor sensor) const {
+  return this->_readings[sensor];
+}
+
+bool DeskApp::dataStale() {
+  return !this->_timeSynced || !this->_fresh[DESK_APP_INSIDE] ||
+         !this->_fresh[DESK_APP_OUTSIDE];
+}
+
+// the min/max column per pixel of the last day, nothing before the first
+// sample
+void DeskApp::drawHistoryGraph(TimeSeries &history, uint8_t graph) {
+  uint32_t now = this->_hooks.utcEpoch();
+  uint32_t from = now - HISTORY_GRAPH_SECONDS;
+  const LayoutCommand &box = HISTORY_SCREEN[graph];
+  TimeSeriesStats stats;
+  int16_t min[FRAMEBUFFER_WIDTH], max[FRAMEBUFFER_WIDTH];
+
+  if (!history.stats(from, now + 1, stats)) return;
+
+  history.downsample(from, now + 1, min, max, box.w);
+  drawRangeGraph(this->_screen, box.x, box.y, box.w, box.h, min, max, box.w);
+}
+
+void DeskApp::drawPage(uint8_t page) {
+  if (this->_hooks.drawText) this->_hooks.drawText(page);
+
+  if (page == this->historyPage()) {
+    this->drawHistoryGraph(this->_insideHistory, HISTORY_IN_GRAPH);
+    this->drawHistoryGraph(this->_outsideHistory, HISTORY_OUT_GRAPH);
+  } else if (page > 0) {
+    int32_t history[STOCK_HISTORY_SIZE];
+    uint8_t count = this->_stocks.copyHistory(page - 1, history);
+    const LayoutCommand &sparkline = STOCK_SCREEN[STOCK_SPARKLINE];
+
+    if (count > 0) {
+      drawSparkline(this->_screen, sparkline.x, sparkline.y, sparkline.w,
+                    sparkline.h, history, count);
+    }
+  } else {
+    drawLayoutRules(this->_screen, MAIN_SCREEN);
+
+    if (this->dataStale()) {
+      drawStaleMarker(this->_screen, MAIN_SCREEN[MAIN_STALE_MARKER].x,
+                      MAIN_SCREEN[MAIN_STALE_MARKER].y);
+    }
+  }
+}
+
+bool DeskApp::mainFrameChanged(bool connected) {
+  FrameContent content;
+  // zeroed so padding and unused bytes never count as a change
+  memset(&content, 0, sizeof(content));
+
+  // only the clock page changes with every second
+  if (this->_page == 0) content.second = this->_hooks.utcEpoch();
+  content.insideReading = this->_readings[DESK_APP_INSIDE];
+  content.outsideReading = this->_readings[DESK_APP_OUTSIDE];
+  content.connected = connected;
+  content.activity = this->_activity;
+  if (this->_activity || !connected) content.step = this->_step;
+  if (connected && this->_showWiFiIcon) {
+    content.wifiBars = wifiBarsForRSSI(halWiFiRSSI());
+  }
+  content.page = this->_page;
+  content.stockUpdates = this->_stocks.updates();
+  content.historySamples =
+      this->_insideHistory.samples() + this->_outsideHistory.samples();
+  content.stale = this->dataStale();
+
+  return this->_pacer.contentChanged(&content, sizeof(content));
+}
+
+void DeskApp::renderMainFrame(bool connected) {
+  this->_screen.clear();
+  this->drawPage(this->_page);
+
+  if (this->_activity && this->_page == 0) {
+    drawSideLines(this->_screen, this->_step, MAIN_SCREEN[MAIN_SIDE_LEFT].x,
+                  MAIN_SCREEN[MAIN_SIDE_RIGHT].x,
+                  MAIN_SCREEN[MAIN_SIDE_LEFT].y);
+  }
+
+  this->nextStep();
+
+  // the stock sparkline and history graphs run where the icon would be
+  const LayoutCommand &icon = MAIN_SCREEN[MAIN_WIFI_ICON];
+  if (!connected) {
+    drawWiFiIcon(this->_screen, this->_step, icon.x, icon.y);
+  } else if (!this->_activity && this->_page == 0 && this->_showWiFiIcon) {
+    drawWiFiIcon(this->_screen, wifiBarsForRSSI(halWiFiRSSI()), icon.x,
+                 icon.y);
+  }
+
+  this->_hooks.presentFrame();
+
+  // halMillis() counts from power-on, so these include the boot itself
+  if (this->_firstFrameMs == UINT32_MAX) {
+    this->_firstFrameMs = halMillis();
+    LOG_INFO("First frame after %lums", (unsigned long)this->_firstFrameMs);
+  }
+  if (this->_freshFrameMs == UINT32_MAX && !this->dataStale()) {
+    this->_freshFrameMs = halMillis();
+    LOG_INFO("Fresh frame after %lums", (unsigned long)this->_freshFrameMs);
+  }
+}
+
+uint8_t DeskApp::panelPage(uint8_t panel) {
+  uint8_t page = this->_panelPages[panel];
+
+  return page == DESK_APP_HISTORY_PAGE ? this->historyPage() : page;
+}
+
+// a page is drawn once for all panels showing it, the others get a copy
+bool DeskApp::renderExtraPanels() {
+  int8_t drawnFor[PANEL_FANOUT_MAX_PANELS];
+  memset(drawnFor, -1, sizeof(drawnFor));
+
+  for (uint8_t panel = 0; panel < this->_fanout.count(); panel++) {
+    ExtraPanelContent content;
+    memset(&content, 0, sizeof(content));
+
+    content.page = this->panelPage(panel);
+    // a stock that isn't configured, nothing to show
+    if (content.page > this->historyPage()) continue;
+
+    if (content.page == 0) {
+      content.mainFrame = this->_pipeline.framesQueued();
+    } else {
+      content.stockUpdates = this->_stocks.updates();
+      content.historySamples =
+          this->_insideHistory.samples() + this->_outsideHistory.samples();
+      content.stale = this->dataStale();
+    }
+    if (!this->_panelPacers[panel].contentChanged(&content, sizeof(content))) {
+      continue;
+    }
+
+    uint8_t *back = this->_fanout.backBuffer(panel);
+    int8_t drawn = -1;
+    for (uint8_t other = 0; other < panel; other++) {
+      if (drawnFor[other] == content.page) drawn = other;
+    }
+
+    if (content.page == 0) {
+      uint32_t frame;
+      // only this task swaps the main pipeline, the copy can't be torn
+      this->_pipeline.readFront(copyFrame, back, frame);
+    } else if (drawn >= 0) {
+      memcpy(back, this->_fanout.backBuffer(drawn), FRAMEBUFFER_SIZE);
+    } else {
+      this->_hooks.attachFrame(back);
+      this->_screen.clear();
+      this->drawPage(content.page);
+      this->_hooks.attachFrame(this->_pipeline.backBuffer());
+    }
+    drawnFor[panel] = content.page;
+
+    bool pending = this->_fanout.pending(panel);
+    bool accepted = this->_fanout.submit(panel);
+    if (this->_hooks.panelSubmitted) {
+      this->_hooks.panelSubmitted(panel, pending, accepted);
+    }
+  }
+
+  return this->_fanout.flush(halMillis(), this->_hooks.msUntilNextSecond()) >
+         0;
+}
+
+LiveState DeskApp::liveState(bool connected) {
+  LiveState state;
+  memset(&state, 0, sizeof(state));
+
+  state.insideReading = this->_readings[DESK_APP_INSIDE];
+  state.outsideReading = this->_readings[DESK_APP_OUTSIDE];
+  state.stale = this->dataStale();
+  state.timeSynced = this->_timeSynced;
+  if (this->_hooks.utcOffset) state.utcOffset = this->_hooks.utcOffset();
+  state.wifiConnected = connected;
+  if (connected) {
+    int32_t rssi = halWiFiRSSI();
+    state.wifiBars = wifiBarsForRSSI(rssi);
+    state.rssi = rssi;
+  }
+
+  return state;
+}
+
+void DeskApp::publishLiveState(bool connected) {
+  LiveState state = this->liveState(connected);
+  uint8_t changes = liveStateChanges(this->_liveState, state);
+
+  this->_liveState = state;
+  if (this->_hooks.liveStateUpdated) {
+    this->_hooks.liveStateUpdated(state, changes);
+  }
+}
+
+bool DeskApp::update(bool connected) {
+  this->recordStockQuotes();
+
+  if (this->_page > 0 &&
+      (this->_page > this->historyPage() ||
+       halMillis() - this->_pageShownAt > PAGE_TIMEOUT_MS)) {
+    this->_page = 0;
+  }
+
+  if (this->mainFrameChanged(connected)) this->renderMainFrame(connected);
+  bool panelsQueued = this->renderExtraPanels();
+  this->publishLiveState(connected);
+
+  return panelsQueued;
+}
+
+void DeskApp::scheduleNextFrame(bool animating) {
+  this->_scheduler.setNextRun(
+      this->_mainJob,
+      this->_pacer.nextFrameDelay(this->_hooks.msUntilNextSecond(),
+                                  animating));
+}
+
+void DeskApp::invalidateFrame() {
+  this->_pacer.invalidate();
+}
+
+const FramePacer &DeskApp::framePacer() const {
+  return this->_pacer;
+}
+
+uint32_t DeskApp::firstFrameMs() const {
+  return this->_firstFrameMs;
+}
+
+uint32_t DeskApp::freshFrameMs() const {
+  return this->_freshFrameMs;
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "BootCache.h"
+#include "DisplayPipeline.h"
+#include "FramePacer.h"
+#include "Framebuffer.h"
+#include "LiveEvents.h"
+#include "PanelFanout.h"
+#include "StockTicker.h"
+#include "TimeSeries.h"
+#include "TimerWheel.h"
+#include "TouchGestures.h"
+
+// sensor readings are fetched once a minute
+#define HTTP_REQUEST_INTERVAL_MS 60000
+// frames are re-timed to the second boundary by FramePacer after every run,
+// the period only covers the first one
+#define MAIN_EVENT_LOOP_INTERVAL_MS FRAME_PACER_IDLE_INTERVAL_MS
+// how far each job may be pushed back to share a wakeup with another one
+#define HTTP_REQUEST_COALESCE_MS 5000
+#define TOUCH_SAMPLE_COALESCE_MS 5
+// quote fetches follow stockFetchIntervalMs(), spread over the symbols
+#define STOCK_REQUEST_COALESCE_MS 5000
+// frames must not be pushed past the second they show
+#define MAIN_EVENT_LOOP_COALESCE_MS 0
+// untouched readings drift with temperature and humidity, sampled whenever
+// another job wakes the device anyway
+#define TOUCH_BASELINE_INTERVAL_MS 5000
+#define TOUCH_BASELINE_COALESCE_MS 4000
+
+// back to the clock after a while on another page
+#define PAGE_TIMEOUT_MS 15000
+// the animation counts from 0 to 3 and starts over
+#define MAX_STEPS 3
+// touch interactivity thresholds
+#define SLEEP_TOUCH_THRESHOLD_LONG 5900
+#define SLEEP_TOUCH_THRESHOLD_MEDIUM 4400
+#define SLEEP_TOUCH_THRESHOLD_SHORT 1400
+
+// a day of both readings at one sample a minute, in RAM before spilling
+#define HISTORY_RAM_SIZE (12 * TIME_SERIES_BLOCK_SIZE)
+#define HISTORY_SAMPLE_INTERVAL_MS 60000
+#define HISTORY_SAMPLE_COALESCE_MS 5000
+#define HISTORY_GRAPH_SECONDS (24 * 60 * 60)
+
+// an extra panel's page that follows the history page wherever the stock
+// symbols put it
+#define DESK_APP_HISTORY_PAGE 0xFF
+
+enum DeskAppSensor : uint8_t { DESK_APP_INSIDE = 0, DESK_APP_OUTSIDE = 1 };
+
+/**
+ * What the firmware and the simulator do differently. Every hook but the
+ * clock and the frame ones may be left null.
+ */
+struct DeskAppHooks {
+  // UTC of the current second and the time left in it, 1 to 1000 ms
+  uint32_t (*utcEpoch)(void);
+  uint32_t (*msUntilNextSecond)(void);
+  // seconds local time is ahead of UTC
+  int32_t (*utcOffset)(void);
+
+  // points the screen (and on the device the OLED driver) at frame
+  void (*attachFrame)(uint8_t *frame);
+  // queues the main panel's back buffer, which is attached again after
+  void (*presentFrame)(void);
+  // text of a page, drawn by the OLED driver's fonts on the device
+  void (*drawText)(uint8_t page);
+
+  void (*doubleTap)(void);
+  void (*longPress)(void);
+
+  // panel's back buffer was submitted, replacing the frame that was still
+  // pending in it when pending is set. Not accepted means the panel already
+  // shows those pixels.
+  void (*panelSubmitted)(uint8_t panel, bool pending, bool accepted);
+  // the state remote viewers are sent, changes holds the LIVE_EVENT_* bits
+  // that differ from the last one
+  void (*liveStateUpdated)(const LiveState &state, uint8_t changes);
+};
+
+/**
+ * The display's behaviour above the hardware: the readings and where they
+ * came from, the page on screen, when a frame needs drawing and what goes
+ * into it, the extra panels, touch gestures, the boot snapshot's content and
+ * the state remote viewers see.
+ *
+ * The firmware and the host simulator both run it, through the HAL and the
+ * hooks, so a change to what the display does shows up in the simulator
+ * without being written twice.
+ */
+class DeskApp {
+  private:
+    Framebuffer     &_screen;
+    DisplayPipeline &_pipeline;
+    PanelFanout     &_fanout;
+    TimerWheel      &_scheduler;
+    StockTicker     &_stocks;
+    TimeSeries      &_insideHistory;
+    TimeSeries      &_outsideHistory;
+    DeskAppHooks     _hooks = {};
+
+    int8_t   _mainJob = TIMER_WHEEL_INVALID_JOB;
+    FramePacer _pacer;
+
+    int16_t  _readings[2];
+    // what came from the network since boot, the rest is from the snapshot
+    bool     _fresh[2]       = {false, false};
+    uint32_t _readingAt[2]   = {0, 0};
+    bool     _timeSynced     = false;
+
+    bool     _activity       = false;
+    uint8_t  _step           = 0;
+    // 0 is the clock, 1.. one page per stock symbol, then the history graphs
+    uint8_t  _page           = 0;
+    uint32_t _pageShownAt    = 0;
+    bool     _showWiFiIcon   = true;
+
+    uint8_t    _panelPages[PANEL_FANOUT_MAX_PANELS];
+    FramePacer _panelPacers[PANEL_FANOUT_MAX_PANELS];
+
+    LiveState _liveState;
+
+    // a quote parsed on the network's task, recorded by update() on the one
+    // that draws the stock pages
+    struct PendingQuote {
+      int32_t  price;
+      int32_t  previousClose;
+      uint32_t symbolList;
+    };
+    PendingQuote      _quotes[STOCK_TICKER_MAX_SYMBOLS];
+    std::atomic<bool> _quotePending[STOCK_TICKER_MAX_SYMBOLS] = {};
+    // setStockSymbols() calls so far and how many there were when the last
+    // quote was asked for, a quote for an older list is dropped
+    uint32_t _symbolList      = 0;
+    uint32_t _fetchSymbolList = 0;
+
+    uint32_t _firstFrameMs   = UINT32_MAX;
+    uint32_t _freshFrameMs   = UINT32_MAX;
+
+    void drawHistoryGraph(TimeSeries &history, uint8_t graph);
+    void drawPage(uint8_t page);
+    uint8_t panelPage(uint8_t panel);
+
+  public:
+    DeskApp(Framebuffer &screen, DisplayPipeline &pipeline,
+            PanelFanout &fanout, TimerWheel &scheduler, StockTicker &stocks,
+            TimeSeries &insideHistory, TimeSeries &outsideHistory);
+
+    /**
+     * Has to come before anything else, the hooks are usually defined after
+     * everything that uses the app
+     */
+    void setHooks(const DeskAppHooks &hooks);
+
+    /**
+     * The job that runs update(), made due by touch
+     */
+    void setMainJob(int8_t job);
+
+    /**
+     * The page extra panel shows for good, DESK_APP_HISTORY_PAGE for the
+     * history graphs
+     */
+    void setPanelPage(uint8_t panel, uint8_t page);
+
+    void setShowWiFiIcon(bool show);
+
+    /**
+     * The clock is synced from the network from now on
+     */
+    void setTimeSynced();
+    bool timeSynced() const;
+
+    /**
+     * Parses a sensor response and takes its reading when it is a 200 with
+     * one in it
+     *
+     * @return true when the reading was taken
+     */
+    bool handleSensorResponse(DeskAppSensor sensor, int status,
+                              const uint8_t *body, size_t length);
+
+    /**
+     * Replaces the stock symbols, on the task that runs update()
+     */
+    void setStockSymbols(const char *list);
+
+    /**
+     * @return index of the symbol to fetch a quote for next
+     */
+    uint8_t nextStockFetch();
+
+    /**
+     * Parses a quote response for the symbol at index, on any task. The
+     * quote is recorded in the ticker by the next update().
+     *
+     * @return true when the quote was taken
+     */
+    bool handleStockResponse(uint8_t index, int status, const uint8_t *body,
+                             size_t length);
+
+    /**
+     * Records the quotes handleStockResponse() took since the last call
+     */
+    void recordStockQuotes();
+
+    /**
+     * Appends both readings to the history, once a sample interval
+     */
+    void recordHistory();
+
+    /**
+     * Takes the readings of a boot snapshot, they count as stale until
+     * fresh ones come in
+     */
+    void restoreSnapshot(const BootSnapshot &snapshot);
+
+    /**
+     * Puts what came from the network since boot into snapshot, leaving
+     * whatever it restored for the rest
+     */
+    void updateSnapshot(BootSnapshot &snapshot);
+
+    void handleTouchEvent(const TouchEvent &event);
+
+    /**
+     * The activity indicator animates while a request or a touch is going on
+     */
+    void setActivity(bool on);
+    bool activity() const;
+
+    uint8_t step() const;
+    void nextStep();
+
+    uint8_t page() const;
+    uint8_t historyPage();
+    void showNextPage();
+
+    int16_t reading(DeskAppSensor sensor) const;
+
+    /**
+     * @return true while a reading is from before this boot or the clock
+     *         isn't synced
+     */
+    bool dataStale();
+
+    /**
+     * @return false when a frame would show the same as the one on the main
+     *         panel
+     */
+    bool mainFrameChanged(bool connected);
+    void renderMainFrame(bool connected);
+
+    /**
+     * Draws the page of every extra panel that changed, once however many
+     * panels show it, and flushes them
+     *
+     * @return true when frames were queued for the transfer
+     */
+    bool renderExtraPanels();
+
+    LiveState liveState(bool connected);
+    void publishLiveState(bool connected);
+
+    /**
+     * One run of the main job: the stock quotes that came in, back to the
+     * clock once a page timed out, a new frame when anything on it changed,
+     * the extra panels and the live state
+     *
+     * @return true when extra panel frames were queued for the transfer
+     */
+    bool update(bool connected);
+
+    /**
+     * Moves the main job to the next frame boundary
+     */
+    void scheduleNextFrame(bool animating);
+
+    /**
+     * Forces the next main frame to be drawn, after something else was
+     * drawn over it
+     */
+    void invalidateFrame();
+
+    const FramePacer &framePacer() const;
+
+    // halMillis() of the first frame and the first one without stale data,
+    // UINT32_MAX until there is one
+    uint32_t firstFrameMs() const;
+    uint32_t freshFrameMs() const;
+};
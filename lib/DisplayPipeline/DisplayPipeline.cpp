@@ -0,0 +1,79 @@
+#include "DisplayPipeline.h"
+
+DisplayPipeline::DisplayPipeline(DisplayTransport &transport)
+    : _back(0), _queued(false), _busy(false), _framesSent(0),
+      _framesQueued(0) {
+  this->_transport = &transport;
+}
+
+void DisplayPipeline::attach(uint8_t *back, uint8_t *front) {
+  this->_buffers[0] = back;
+  this->_buffers[1] = front;
+  this->_back.store(0);
+}
+
+uint8_t *DisplayPipeline::backBuffer() {
+  return this->_buffers[this->_back.load()];
+}
+
+bool DisplayPipeline::swap() {
+  // queued is checked first: the transfer task marks itself busy before it
+  // takes a frame off the queue, so one of the two is always seen set
+  if (this->_queued.load() || this->_busy.load()) {
+    this->_swapsRefused++;
+    return false;
+  }
+
+  // flipped before the count moves on, and drawn into only after: a reader
+  // that sees the new count also sees the new front, one that read the old
+  // front while it was redrawn sees the count change
+  this->_back.store(this->_back.load() ^ 1);
+  this->_framesQueued.fetch_add(1);
+  this->_queued.store(true);
+
+  return true;
+}
+
+bool DisplayPipeline::transferPending() {
+  if (!this->_queued.load()) return false;
+
+  this->_busy.store(true);
+  this->_queued.store(false);
+
+  // the renderer has moved on to the other buffer by now
+  this->_transport->sendFrame(this->_buffers[this->_back.load() ^ 1]);
+  // only ever written here, a plain store is enough
+  this->_framesSent.store(this->_framesSent.load() + 1);
+
+  this->_busy.store(false);
+
+  return true;
+}
+
+bool DisplayPipeline::idle() {
+  return !this->_queued.load() && !this->_busy.load();
+}
+
+bool DisplayPipeline::readFront(DisplayFrameReadCb read, void *ctx,
+                                uint32_t &frame) {
+  if (this->_buffers[0] == nullptr) return false;
+
+  frame = this->_framesQueued.load();
+  read(this->_buffers[this->_back.load() ^ 1], ctx);
+  // reads of the frame must not move past the second look at the count
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  return this->_framesQueued.load() == frame;
+}
+
+uint32_t DisplayPipeline::framesQueued() {
+  return this->_framesQueued.load();
+}
+
+uint32_t DisplayPipeline::framesSent() {
+  return this->_framesSent.load();
+}
+
+uint32_t DisplayPipeline::swapsRefused() {
+  return this->_swapsRefused;
+}
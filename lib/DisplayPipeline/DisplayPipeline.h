@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "Framebuffer.h"
+
+/**
+ * Whatever moves a finished frame to the panel. sendFrame() runs on the
+ * transfer task and gets a whole FRAMEBUFFER_SIZE frame in page layout.
+ */
+class DisplayTransport {
+  public:
+    virtual ~DisplayTransport() {}
+
+    virtual void sendFrame(const uint8_t *frame) = 0;
+};
+
+typedef void (*DisplayFrameReadCb)(const uint8_t *frame, void *ctx);
+
+/**
+ * Double-buffered hand-off between the task that renders frames and the task
+ * that streams them to the panel.
+ *
+ * The renderer draws into backBuffer() and calls swap(), which queues the
+ * finished frame and hands out the other buffer for the next one. The
+ * transfer task calls transferPending() whenever it is woken up and sends the
+ * queued frame, so the bus transfer overlaps with preparing the next frame.
+ *
+ * A buffer is never written while it is being sent: swap() refuses to hand
+ * out the buffer of a frame that is still queued or on the bus. There is
+ * exactly one renderer and one transfer task.
+ *
+ * Other tasks can look at the frame last queued with readFront(), which
+ * never holds up the renderer.
+ */
+class DisplayPipeline {
+  private:
+    DisplayTransport     *_transport;
+    uint8_t              *_buffers[2] = {nullptr, nullptr};
+    std::atomic<uint8_t>  _back;
+
+    std::atomic<bool>     _queued;
+    std::atomic<bool>     _busy;
+    std::atomic<uint32_t> _framesSent;
+    // also the sequence number readFront() checks for a swap during a read
+    std::atomic<uint32_t> _framesQueued;
+
+    uint32_t              _swapsRefused = 0;
+
+  public:
+    DisplayPipeline(DisplayTransport &transport);
+
+    /**
+     * @param back buffer the first frame is rendered into
+     * @param front the other one, only ever filled by swap()
+     */
+    void attach(uint8_t *back, uint8_t *front);
+
+    /**
+     * The buffer to render into. After a swap it still holds the frame from
+     * two swaps ago, not a blank one.
+     */
+    uint8_t *backBuffer();
+
+    /**
+     * Queues the back buffer for transfer and swaps buffers.
+     *
+     * @return false, without swapping, while the previous frame is still
+     *         queued or being sent
+     */
+    bool swap();
+
+    /**
+     * Sends the queued frame, if any. Called by the transfer task only.
+     *
+     * @return true when a frame was sent
+     */
+    bool transferPending();
+
+    /**
+     * @return true when nothing is queued or on the bus
+     */
+    bool idle();
+
+    /**
+     * Calls read with the frame last queued by swap(), in place, on any task.
+     * A swap during read() hands that buffer back to the renderer, so read()
+     * may see it half redrawn. That is detected afterwards and false returned,
+     * whatever read() took from the frame must then be thrown away.
+     *
+     * @param frame set to framesQueued() of the frame read, 0 before the
+     *              first swap
+     * @return false when the frame changed under read() or there is no
+     *         buffer yet
+     */
+    bool readFront(DisplayFrameReadCb read, void *ctx, uint32_t &frame);
+
+    uint32_t framesQueued();
+    uint32_t framesSent();
+    // swap() calls that found the bus still busy with the previous frame
+    uint32_t swapsRefused();
+};
@@ -0,0 +1,120 @@
+#include "PanelFanout.h"
+
+#include <string.h>
+
+// column and page addressing, the last two commands' arguments included
+#define PANEL_SETUP_COMMANDS 6
+// address, control byte and about a byte's worth of start and stop
+#define PANEL_CHUNK_OVERHEAD_BYTES 3
+
+uint32_t panelFrameBusMs(uint32_t hz, uint16_t chunkSize) {
+  uint32_t chunks = (FRAMEBUFFER_SIZE + chunkSize - 1) / chunkSize;
+  uint32_t bytes = FRAMEBUFFER_SIZE + chunks * PANEL_CHUNK_OVERHEAD_BYTES +
+                   PANEL_SETUP_COMMANDS * (PANEL_CHUNK_OVERHEAD_BYTES + 1);
+
+  return (bytes * 9 * 1000 + hz - 1) / hz;
+}
+
+int8_t PanelFanout::addPanel(DisplayPipeline &pipeline, uint16_t busMs) {
+  if (this->_count >= PANEL_FANOUT_MAX_PANELS) return -1;
+
+  Panel &p = this->_panels[this->_count];
+  p.pipeline  = &pipeline;
+  p.busMs     = busMs;
+  p.changed   = false;
+  p.unchanged = 0;
+  p.deferred  = 0;
+
+  return this->_count++;
+}
+
+uint8_t PanelFanout::count() {
+  return this->_count;
+}
+
+uint8_t *PanelFanout::backBuffer(uint8_t panel) {
+  return this->_panels[panel].pipeline->backBuffer();
+}
+
+bool PanelFanout::submit(uint8_t panel) {
+  Panel &p = this->_panels[panel];
+  const uint8_t *back = p.pipeline->backBuffer();
+  const uint8_t *front = nullptr;
+  uint32_t frame;
+
+  // the renderer is the only one swapping, so the read can't be torn
+  p.pipeline->readFront(
+      [](const uint8_t *buffer, void *ctx) {
+        *(const uint8_t **)ctx = buffer;
+      },
+      &front, frame);
+
+  // before the first swap the front is the blank buffer attach() was given
+  p.changed = memcmp(back, front, FRAMEBUFFER_SIZE) != 0;
+  if (!p.changed) p.unchanged++;
+
+  return p.changed;
+}
+
+void PanelFanout::reserve(uint32_t nowMs, uint16_t busMs) {
+  if ((int32_t)(this->_busFreeAt - nowMs) < 0) this->_busFreeAt = nowMs;
+  this->_busFreeAt += busMs;
+}
+
+uint8_t PanelFanout::flush(uint32_t nowMs, uint32_t msUntilNextSecond) {
+  uint8_t queued = 0;
+  uint8_t first = this->_nextQueued;
+
+  if ((int32_t)(this->_busFreeAt - nowMs) < 0) this->_busFreeAt = nowMs;
+
+  for (uint8_t i = 0; i < this->_count; i++) {
+    uint8_t panel = (first + i) % this->_count;
+    Panel &p = this->_panels[panel];
+
+    // still on the bus, the newer frame goes out with a later flush()
+    if (!p.changed || !p.pipeline->idle()) continue;
+
+    if (this->_busFreeAt - nowMs + p.busMs + PANEL_FANOUT_GUARD_MS >
+        msUntilNextSecond) {
+      p.deferred++;
+      continue;
+    }
+
+    p.pipeline->swap();
+    p.changed = false;
+    this->_busFreeAt += p.busMs;
+    this->_nextQueued = (panel + 1) % this->_count;
+    queued++;
+  }
+
+  return queued;
+}
+
+bool PanelFanout::pending(uint8_t panel) {
+  return this->_panels[panel].changed;
+}
+
+bool PanelFanout::transferNext() {
+  for (uint8_t i = 0; i < this->_count; i++) {
+    uint8_t panel = (this->_nextSent + i) % this->_count;
+
+    if (this->_panels[panel].pipeline->transferPending()) {
+      this->_nextSent = (panel + 1) % this->_count;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+DisplayPipeline &PanelFanout::pipeline(uint8_t panel) {
+  return *this->_panels[panel].pipeline;
+}
+
+uint32_t PanelFanout::framesUnchanged(uint8_t panel) {
+  return this->_panels[panel].unchanged;
+}
+
+uint32_t PanelFanout::framesDeferred(uint8_t panel) {
+  return this->_panels[panel].deferred;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "DisplayPipeline.h"
+
+#define PANEL_FANOUT_MAX_PANELS 4
+// bus time left free in front of a second boundary, so the clock panel's
+// frame for the new second finds the bus idle
+#define PANEL_FANOUT_GUARD_MS 2
+
+/**
+ * Estimated time a whole frame takes on an I2C bus at hz: 9 clocks a byte
+ * with the ack, plus address, control byte, start and stop every chunk and
+ * the six addressing commands in front of the data
+ */
+uint32_t panelFrameBusMs(uint32_t hz, uint16_t chunkSize);
+
+/**
+ * Panels sharing the bus with the clock panel, each with a pipeline of its
+ * own. The clock panel keeps its DisplayPipeline and always goes first; the
+ * panels here get the bus time around it.
+ *
+ * The renderer draws a panel's page into backBuffer() and calls submit(),
+ * which keeps the frame only when it differs from the one last queued for
+ * that panel. flush() then queues the changed panels round-robin, as long as
+ * their transfer is estimated to end PANEL_FANOUT_GUARD_MS before the next
+ * second boundary. A panel that doesn't fit stays changed and is queued by a
+ * later flush(), after the clock panel's frame went out.
+ *
+ * The transfer task sends one panel per transferNext(), also round-robin, so
+ * a clock frame queued meanwhile waits for at most one other panel.
+ */
+class PanelFanout {
+  private:
+    struct Panel {
+      DisplayPipeline *pipeline;
+      uint16_t         busMs;
+      bool             changed;
+      uint32_t         unchanged;
+      uint32_t         deferred;
+    };
+
+    Panel    _panels[PANEL_FANOUT_MAX_PANELS];
+    uint8_t  _count = 0;
+    uint8_t  _nextQueued = 0;
+    uint8_t  _nextSent = 0;
+    // estimated end of what is queued on the bus, in the caller's ms
+    uint32_t _busFreeAt = 0;
+
+  public:
+    /**
+     * @param busMs estimated bus time of one frame, see panelFrameBusMs()
+     * @return the panel number, -1 when PANEL_FANOUT_MAX_PANELS are added
+     */
+    int8_t addPanel(DisplayPipeline &pipeline, uint16_t busMs);
+
+    uint8_t count();
+
+    uint8_t *backBuffer(uint8_t panel);
+
+    /**
+     * Called after panel's frame is drawn into backBuffer()
+     *
+     * @return false when it matches the frame last queued for the panel and
+     *         is dropped
+     */
+    bool submit(uint8_t panel);
+
+    /**
+     * Bus time taken by something else, like the clock panel's frames, that
+     * flush() has to plan around
+     */
+    void reserve(uint32_t nowMs, uint16_t busMs);
+
+    /**
+     * Queues changed panels whose transfer fits before the second boundary
+     *
+     * @param msUntilNextSecond 1 to 1000, like FramePacer takes it
+     * @return how many were queued, the transfer task has to be woken up
+     *         for them
+     */
+    uint8_t flush(uint32_t nowMs, uint32_t msUntilNextSecond);
+
+    /**
+     * @return true while a submitted frame of panel waits for flush(), a
+     *         frame drawn now replaces it
+     */
+    bool pending(uint8_t panel);
+
+    /**
+     * Sends the next queued frame. Called by the transfer task only.
+     *
+     * @return true when a frame was sent
+     */
+    bool transferNext();
+
+    DisplayPipeline &pipeline(uint8_t panel);
+    // submitted frames that matched the one on the panel
+    uint32_t framesUnchanged(uint8_t panel);
+    // flush() calls that left the panel's frame for later to keep the budget
+    uint32_t framesDeferred(uint8_t panel);
+};
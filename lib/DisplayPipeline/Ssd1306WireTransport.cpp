@@ -0,0 +1,92 @@
+#ifdef ARDUINO
+
+#include "Ssd1306WireTransport.h"
+
+#define SSD1306_CONTROL_COMMAND 0x80
+#define SSD1306_CONTROL_DATA 0x40
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+// power-on setup as SSD1306Wire::init() sends it, then flipped vertically
+static const uint8_t SSD1306_SETUP[] = {
+    0xAE,       // display off
+    0xD5, 0xF0, // clock divider
+    0xA8, 0x3F, // multiplex, 64 rows
+    0xD3, 0x00, // display offset
+    0x40,       // start line 0
+    0x8D, 0x14, // charge pump on
+    0x20, 0x00, // horizontal addressing
+    0xA0,       // segment remap and COM scan direction, flipScreenVertically()
+    0xC0,
+    0xDA, 0x12, // COM pins
+    0xD9, 0xF1, // precharge
+    0xDB, 0x40, // VCOM detect
+    0xA4,       // show RAM
+    0xA6,       // not inverted
+    0x2E,       // no scrolling
+};
+#define SSD1306_SETCONTRAST 0x81
+#define SSD1306_DISPLAYON 0xAF
+#define SSD1306_DISPLAYOFF 0xAE
+
+Ssd1306WireTransport::Ssd1306WireTransport(TwoWire &wire, uint8_t address,
+                                           uint8_t muxChannel) {
+  this->_wire = &wire;
+  this->_address = address;
+  this->_muxChannel = muxChannel;
+}
+
+void Ssd1306WireTransport::selectChannel(bool on) {
+  if (this->_muxChannel == SSD1306_WIRE_NO_MUX) return;
+
+  this->_wire->beginTransmission(SSD1306_WIRE_MUX_ADDRESS);
+  this->_wire->write(on ? 1 << this->_muxChannel : 0);
+  this->_wire->endTransmission();
+}
+
+void Ssd1306WireTransport::begin(uint8_t contrast) {
+  this->selectChannel(true);
+
+  for (uint8_t i = 0; i < sizeof(SSD1306_SETUP); i++) {
+    this->sendCommand(SSD1306_SETUP[i]);
+  }
+  this->sendCommand(SSD1306_SETCONTRAST);
+  this->sendCommand(contrast);
+  this->sendCommand(SSD1306_DISPLAYON);
+
+  this->selectChannel(false);
+}
+
+void Ssd1306WireTransport::displayOff() {
+  this->selectChannel(true);
+  this->sendCommand(SSD1306_DISPLAYOFF);
+  this->selectChannel(false);
+}
+
+void Ssd1306WireTransport::sendCommand(uint8_t command) {
+  this->_wire->beginTransmission(this->_address);
+  this->_wire->write(SSD1306_CONTROL_COMMAND);
+  this->_wire->write(command);
+  this->_wire->endTransmission();
+}
+
+void Ssd1306WireTransport::sendFrame(const uint8_t *frame) {
+  this->selectChannel(true);
+  this->sendCommand(SSD1306_COLUMNADDR);
+  this->sendCommand(0);
+  this->sendCommand(FRAMEBUFFER_WIDTH - 1);
+  this->sendCommand(SSD1306_PAGEADDR);
+  this->sendCommand(0);
+  this->sendCommand(FRAMEBUFFER_PAGES - 1);
+
+  for (uint16_t i = 0; i < FRAMEBUFFER_SIZE; i += SSD1306_WIRE_CHUNK_SIZE) {
+    this->_wire->beginTransmission(this->_address);
+    this->_wire->write(SSD1306_CONTROL_DATA);
+    this->_wire->write(frame + i, SSD1306_WIRE_CHUNK_SIZE);
+    this->_wire->endTransmission();
+  }
+
+  this->selectChannel(false);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#ifdef ARDUINO
+
+#include <Wire.h>
+
+#include "DisplayPipeline.h"
+
+// data bytes per I2C transaction, well within the Wire buffer
+#define SSD1306_WIRE_CHUNK_SIZE 64
+// a panel on the bus itself rather than behind a TCA9548A channel
+#define SSD1306_WIRE_NO_MUX 0xFF
+// the TCA9548A's address with its address pins low
+#define SSD1306_WIRE_MUX_ADDRESS 0x70
+
+/**
+ * Streams frames to an SSD1306 over Wire from the transfer task, using the
+ * same horizontal addressing setup as SSD1306Wire::display(). The bus has to
+ * be initialized by the OLED driver first and must not be used by anything
+ * else while a frame is on it.
+ *
+ * Panels that share an address sit behind channels of a TCA9548A mux. It is
+ * switched to the panel's channel for every frame and off again after, so a
+ * panel on the bus itself can have the same address.
+ */
+class Ssd1306WireTransport : public DisplayTransport {
+  private:
+    TwoWire *_wire;
+    uint8_t  _address;
+    uint8_t  _muxChannel;
+
+    void selectChannel(bool on);
+    void sendCommand(uint8_t command);
+
+  public:
+    Ssd1306WireTransport(TwoWire &wire, uint8_t address,
+                         uint8_t muxChannel = SSD1306_WIRE_NO_MUX);
+
+    /**
+     * Sends the power-on setup the OLED driver's init() sends, oriented and
+     * dimmed like the main panel, for panels the driver doesn't know about
+     */
+    void begin(uint8_t contrast);
+
+    /**
+     * Blanks the panel until the next begin(), not while a frame is sent
+     */
+    void displayOff();
+
+    void sendFrame(const uint8_t *frame) override;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "FetchArena.h"
+
+#include <string.h>
+
+FetchArena::FetchArena(uint8_t *buffer, size_t size)
+    : _buffer(buffer), _size(size) {}
+
+void *FetchArena::allocate(size_t size) {
+  size_t start = (this->_used + FETCH_ARENA_ALIGN - 1) &
+                 ~(size_t)(FETCH_ARENA_ALIGN - 1);
+
+  if (start > this->_size || size > this->_size - start) {
+    this->_refusals++;
+    return nullptr;
+  }
+
+  this->_used = start + size;
+  if (this->_used > this->_peak) this->_peak = this->_used;
+
+  return this->_buffer + start;
+}
+
+char *FetchArena::concat(const char *a, const char *b) {
+  size_t lengthA = strlen(a);
+  size_t lengthB = strlen(b);
+  char *text = (char *)this->allocate(lengthA + lengthB + 1);
+  if (!text) return nullptr;
+
+  memcpy(text, a, lengthA);
+  memcpy(text + lengthA, b, lengthB + 1);
+
+  return text;
+}
+
+uint8_t *FetchArena::spare(size_t &length) {
+  length = this->_size - this->_used;
+
+  return this->_buffer + this->_used;
+}
+
+void FetchArena::commit(size_t length) {
+  size_t spare = this->_size - this->_used;
+
+  this->_used += length < spare ? length : spare;
+  if (this->_used > this->_peak) this->_peak = this->_used;
+}
+
+void FetchArena::reset() {
+  this->_used = 0;
+}
+
+size_t FetchArena::size() const {
+  return this->_size;
+}
+
+size_t FetchArena::used() const {
+  return this->_used;
+}
+
+size_t FetchArena::peak() const {
+  return this->_peak;
+}
+
+uint32_t FetchArena::refusals() const {
+  return this->_refusals;
+}
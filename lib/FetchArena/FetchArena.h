@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// every allocation starts on a multiple of this, enough for any scalar
+#define FETCH_ARENA_ALIGN 8
+
+/**
+ * Memory for one HTTP request while it is in flight: its URL, headers,
+ * response body and whatever is parsed out of it. Allocations are only ever
+ * bumped off the end and nothing is freed on its own, reset() drops it all
+ * at once when the request is done.
+ *
+ * The fetch path then never touches the heap, so it can't fragment it, and
+ * a request can't take more than the arena it was given. peak() shows how
+ * close the largest one came.
+ */
+class FetchArena {
+  private:
+    uint8_t *_buffer;
+    size_t   _size;
+    size_t   _used     = 0;
+    size_t   _peak     = 0;
+    uint32_t _refusals = 0;
+
+  public:
+    FetchArena(uint8_t *buffer, size_t size);
+
+    /**
+     * @return nullptr when it doesn't fit, counted in refusals()
+     */
+    void *allocate(size_t size);
+
+    /**
+     * Copies a and b one after the other, terminated
+     *
+     * @return nullptr when it doesn't fit
+     */
+    char *concat(const char *a, const char *b = "");
+
+    /**
+     * The space left, for reading something of unknown length straight into
+     * it. commit() then keeps what was written.
+     */
+    uint8_t *spare(size_t &length);
+    void commit(size_t length);
+
+    /**
+     * Drops every allocation, pointers into the arena must not be used after
+     */
+    void reset();
+
+    size_t size() const;
+    size_t used() const;
+    // the most that was in use since the arena was made
+    size_t peak() const;
+    // allocations that didn't fit
+    uint32_t refusals() const;
+};
+
+/**
+ * An arena with its N bytes inside, for globals and members
+ */
+template <size_t N> class StaticFetchArena : public FetchArena {
+  private:
+    alignas(FETCH_ARENA_ALIGN) uint8_t _storage[N];
+
+  public:
+    StaticFetchArena() : FetchArena(this->_storage, N) {}
+};
@@ -0,0 +1,50 @@
+#include "FramePacer.h"
+
+// FNV-1a, 32 bit
+static uint32_t hashContent(const uint8_t *data, size_t length) {
+  uint32_t hash = 2166136261UL;
+
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+
+  return hash;
+}
+
+uint32_t FramePacer::nextFrameDelay(uint32_t msUntilNextSecond,
+                                    bool animating) const {
+  if (msUntilNextSecond == 0 || msUntilNextSecond > FRAME_PACER_IDLE_INTERVAL_MS) {
+    msUntilNextSecond = FRAME_PACER_IDLE_INTERVAL_MS;
+  }
+
+  if (!animating) return msUntilNextSecond;
+
+  return (msUntilNextSecond - 1) % FRAME_PACER_ANIMATION_INTERVAL_MS + 1;
+}
+
+bool FramePacer::contentChanged(const void *content, size_t length) {
+  uint32_t hash = hashContent((const uint8_t *)content, length);
+
+  if (this->_hasFrame && hash == this->_lastContentHash) {
+    this->_framesSkipped++;
+    return false;
+  }
+
+  this->_lastContentHash = hash;
+  this->_hasFrame = true;
+  this->_framesRendered++;
+
+  return true;
+}
+
+void FramePacer::invalidate() {
+  this->_hasFrame = false;
+}
+
+uint32_t FramePacer::framesRendered() const {
+  return this->_framesRendered;
+}
+
+uint32_t FramePacer::framesSkipped() const {
+  return this->_framesSkipped;
+}
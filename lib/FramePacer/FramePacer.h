@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// one frame per second when nothing moves, the clock ticks on every one
+#define FRAME_PACER_IDLE_INTERVAL_MS 1000
+// animation steps, kept at the speed they always had
+#define FRAME_PACER_ANIMATION_INTERVAL_MS 500
+
+/**
+ * Decides when the next frame is due and whether it needs to be drawn at all.
+ *
+ * Frames are aligned to the boundaries of the displayed second so the clock
+ * changes the moment the second does. While idle that is the only frame per
+ * second, while an animation runs the second is split into
+ * FRAME_PACER_ANIMATION_INTERVAL_MS steps that stay on the same grid.
+ *
+ * The caller describes everything a frame shows in a plain struct (zeroed,
+ * so padding compares equal). A frame whose content hashes the same as the
+ * last drawn one is skipped, which saves composing it and sending 1 KB over
+ * the bus.
+ */
+class FramePacer {
+  private:
+    uint32_t _lastContentHash = 0;
+    bool     _hasFrame        = false;
+
+    uint32_t _framesRendered  = 0;
+    uint32_t _framesSkipped   = 0;
+
+  public:
+    /**
+     * @param msUntilNextSecond time left in the current displayed second,
+     *                          1 to 1000
+     * @return milliseconds until the next frame boundary
+     */
+    uint32_t nextFrameDelay(uint32_t msUntilNextSecond, bool animating) const;
+
+    /**
+     * Remembers content as the current frame.
+     *
+     * @return false when it matches the frame already on screen
+     */
+    bool contentChanged(const void *content, size_t length);
+
+    /**
+     * Forces the next frame to be drawn, for when something else has drawn
+     * over the screen
+     */
+    void invalidate();
+
+    uint32_t framesRendered() const;
+    uint32_t framesSkipped() const;
+};
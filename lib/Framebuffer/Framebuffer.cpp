@@ -0,0 +1,231 @@
+#include "Framebuffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char PBM_HEADER[] = "P4\n128 64\n";
+static_assert(sizeof(PBM_HEADER) - 1 == FRAMEBUFFER_PBM_HEADER_SIZE,
+              "PBM header size");
+
+#define IN_BOUNDS(x, y)                                                        \
+  ((x) >= 0 && (x) < FRAMEBUFFER_WIDTH && (y) >= 0 && (y) < FRAMEBUFFER_HEIGHT)
+
+Framebuffer::Framebuffer(uint8_t *buffer) {
+  this->_buffer = buffer;
+}
+
+void Framebuffer::attach(uint8_t *buffer) {
+  this->_buffer = buffer;
+}
+
+uint8_t *Framebuffer::buffer() {
+  return this->_buffer;
+}
+
+const uint8_t *Framebuffer::buffer() const {
+  return this->_buffer;
+}
+
+void Framebuffer::clear() {
+  memset(this->_buffer, 0, FRAMEBUFFER_SIZE);
+}
+
+void Framebuffer::setPixel(int16_t x, int16_t y) {
+  if (IN_BOUNDS(x, y)) {
+    this->_buffer[x + (y >> 3) * FRAMEBUFFER_WIDTH] |= (1 << (y & 7));
+  }
+}
+
+void Framebuffer::clearPixel(int16_t x, int16_t y) {
+  if (IN_BOUNDS(x, y)) {
+    this->_buffer[x + (y >> 3) * FRAMEBUFFER_WIDTH] &= ~(1 << (y & 7));
+  }
+}
+
+bool Framebuffer::getPixel(int16_t x, int16_t y) const {
+  if (!IN_BOUNDS(x, y)) return false;
+
+  return this->_buffer[x + (y >> 3) * FRAMEBUFFER_WIDTH] & (1 << (y & 7));
+}
+
+// ORs (or with clear, ANDs out) mask into n consecutive column bytes, four at
+// a time once the destination is word aligned
+static void maskRun(uint8_t *dst, int16_t n, uint8_t mask, bool clear) {
+  uint32_t word = mask * 0x01010101UL;
+
+  while (n > 0 && ((uintptr_t)dst & 3)) {
+    *dst = clear ? *dst & ~mask : *dst | mask;
+    dst++;
+    n--;
+  }
+
+  uint32_t *words = (uint32_t *)__builtin_assume_aligned(dst, 4);
+  for (; n >= 4; n -= 4, words++) {
+    uint32_t value;
+    memcpy(&value, words, sizeof(value));
+    value = clear ? value & ~word : value | word;
+    memcpy(words, &value, sizeof(value));
+  }
+
+  dst = (uint8_t *)words;
+  while (n-- > 0) {
+    *dst = clear ? *dst & ~mask : *dst | mask;
+    dst++;
+  }
+}
+
+static void fillRectMasked(uint8_t *buffer, int16_t x, int16_t y, int16_t w,
+                           int16_t h, bool clear) {
+  int16_t x0 = x < 0 ? 0 : x;
+  int16_t y0 = y < 0 ? 0 : y;
+  int16_t x1 = x + w > FRAMEBUFFER_WIDTH ? FRAMEBUFFER_WIDTH : x + w;
+  int16_t y1 = y + h > FRAMEBUFFER_HEIGHT ? FRAMEBUFFER_HEIGHT : y + h;
+
+  if (x0 >= x1 || y0 >= y1) return;
+
+  for (int16_t page = y0 >> 3; page <= (y1 - 1) >> 3; page++) {
+    int16_t top = page * 8 > y0 ? page * 8 : y0;
+    int16_t bottom = page * 8 + 8 < y1 ? page * 8 + 8 : y1;
+    uint8_t mask = (0xFF << (top & 7)) & (0xFF >> (7 - ((bottom - 1) & 7)));
+
+    maskRun(buffer + page * FRAMEBUFFER_WIDTH + x0, x1 - x0, mask, clear);
+  }
+}
+
+void Framebuffer::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+  if (y0 == y1) {
+    this->hline(x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1);
+  } else if (x0 == x1) {
+    this->vline(x0, y0 < y1 ? y0 : y1, abs(y1 - y0) + 1);
+  } else {
+    this->drawLinePixels(x0, y0, x1, y1);
+  }
+}
+
+void Framebuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  fillRectMasked(this->_buffer, x, y, w, h, false);
+}
+
+void Framebuffer::clearRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  fillRectMasked(this->_buffer, x, y, w, h, true);
+}
+
+void Framebuffer::hline(int16_t x, int16_t y, int16_t w) {
+  fillRectMasked(this->_buffer, x, y, w, 1, false);
+}
+
+void Framebuffer::vline(int16_t x, int16_t y, int16_t h) {
+  fillRectMasked(this->_buffer, x, y, 1, h, false);
+}
+
+void Framebuffer::drawLinePixels(int16_t x0, int16_t y0, int16_t x1,
+                                 int16_t y1) {
+  int16_t tmp;
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+
+  if (steep) {
+    tmp = x0; x0 = y0; y0 = tmp;
+    tmp = x1; x1 = y1; y1 = tmp;
+  }
+
+  if (x0 > x1) {
+    tmp = x0; x0 = x1; x1 = tmp;
+    tmp = y0; y0 = y1; y1 = tmp;
+  }
+
+  int16_t dx = x1 - x0;
+  int16_t dy = abs(y1 - y0);
+  int16_t err = dx / 2;
+  int16_t ystep = y0 < y1 ? 1 : -1;
+
+  for (; x0 <= x1; x0++) {
+    if (steep) {
+      this->setPixel(y0, x0);
+    } else {
+      this->setPixel(x0, y0);
+    }
+
+    err -= dy;
+    if (err < 0) {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+}
+
+void Framebuffer::fillRectPixels(int16_t x, int16_t y, int16_t w, int16_t h) {
+  for (int16_t i = x; i < x + w; i++) {
+    for (int16_t j = y; j < y + h; j++) {
+      this->setPixel(i, j);
+    }
+  }
+}
+
+void Framebuffer::blit(const uint8_t *bitmap, uint8_t width, uint8_t pages,
+                       int16_t x, int16_t y) {
+  // floor division, y may be above the top edge
+  int16_t page = y >= 0 ? y / 8 : -((7 - y) / 8);
+  uint8_t shift = y - page * 8;
+  int16_t firstColumn = x < 0 ? -x : 0;
+  int16_t lastColumn = x + width > FRAMEBUFFER_WIDTH ? FRAMEBUFFER_WIDTH - x
+                                                     : width;
+
+  for (uint8_t p = 0; p < pages; p++) {
+    int16_t top = page + p;
+    const uint8_t *src = bitmap + p * width;
+
+    if (top >= FRAMEBUFFER_PAGES) break;
+
+    for (int16_t c = firstColumn; c < lastColumn; c++) {
+      uint8_t bits = src[c];
+      if (!bits) continue;
+
+      if (top >= 0) {
+        this->_buffer[x + c + top * FRAMEBUFFER_WIDTH] |= bits << shift;
+      }
+      if (shift && top + 1 >= 0 && top + 1 < FRAMEBUFFER_PAGES) {
+        this->_buffer[x + c + (top + 1) * FRAMEBUFFER_WIDTH] |=
+            bits >> (8 - shift);
+      }
+    }
+  }
+}
+
+size_t Framebuffer::writePbm(FramebufferWriteCb write, void *ctx) const {
+  uint8_t row[FRAMEBUFFER_WIDTH / 8];
+
+  write(ctx, (const uint8_t *)PBM_HEADER, FRAMEBUFFER_PBM_HEADER_SIZE);
+
+  for (size_t offset = FRAMEBUFFER_PBM_HEADER_SIZE;
+       offset < FRAMEBUFFER_PBM_SIZE; offset += sizeof(row)) {
+    framebufferReadPbm(this->_buffer, offset, row, sizeof(row));
+    write(ctx, row, sizeof(row));
+  }
+
+  return FRAMEBUFFER_PBM_SIZE;
+}
+
+size_t framebufferReadPbm(const uint8_t *frame, size_t offset, uint8_t *out,
+                          size_t length) {
+  size_t written = 0;
+
+  for (; written < length && offset < FRAMEBUFFER_PBM_HEADER_SIZE; offset++) {
+    out[written++] = PBM_HEADER[offset];
+  }
+
+  for (; written < length && offset < FRAMEBUFFER_PBM_SIZE; offset++) {
+    // eight pixels of a row, leftmost in the MSB, from eight column bytes
+    size_t pixel = (offset - FRAMEBUFFER_PBM_HEADER_SIZE) * 8;
+    uint8_t y = pixel / FRAMEBUFFER_WIDTH;
+    const uint8_t *columns = frame + pixel % FRAMEBUFFER_WIDTH +
+                             (y >> 3) * FRAMEBUFFER_WIDTH;
+    uint8_t bits = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+      bits = bits << 1 | ((columns[i] >> (y & 7)) & 1);
+    }
+    out[written++] = bits;
+  }
+
+  return written;
+}
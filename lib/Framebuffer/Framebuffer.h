@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAMEBUFFER_WIDTH 128
+#define FRAMEBUFFER_HEIGHT 64
+#define FRAMEBUFFER_PAGES (FRAMEBUFFER_HEIGHT / 8)
+#define FRAMEBUFFER_SIZE (FRAMEBUFFER_WIDTH * FRAMEBUFFER_PAGES)
+// "P4\n128 64\n" and a bit per pixel, rows from the top
+#define FRAMEBUFFER_PBM_HEADER_SIZE 10
+#define FRAMEBUFFER_PBM_SIZE (FRAMEBUFFER_PBM_HEADER_SIZE + FRAMEBUFFER_SIZE)
+
+typedef void (*FramebufferWriteCb)(void *ctx, const uint8_t *data, size_t length);
+
+/**
+ * 128x64 monochrome buffer in the SSD1306 page layout: byte x + page * 128
+ * holds the eight vertical pixels of column x in that page, LSB on top.
+ *
+ * It does not own memory: on the device it wraps the buffer allocated by the
+ * OLED driver so both can draw into the same frame, on the host any
+ * FRAMEBUFFER_SIZE byte array will do.
+ */
+class Framebuffer {
+  private:
+    uint8_t *_buffer;
+
+  public:
+    Framebuffer(uint8_t *buffer = nullptr);
+
+    /**
+     * Draws into another FRAMEBUFFER_SIZE byte buffer from now on
+     */
+    void attach(uint8_t *buffer);
+
+    uint8_t *buffer();
+    const uint8_t *buffer() const;
+
+    void clear();
+
+    void setPixel(int16_t x, int16_t y);
+    void clearPixel(int16_t x, int16_t y);
+    bool getPixel(int16_t x, int16_t y) const;
+
+    /**
+     * Bresenham line, endpoints included. Matches OLEDDisplay::drawLine()
+     * bit for bit, horizontal and vertical lines take the hline()/vline()
+     * fast paths.
+     */
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+
+    /**
+     * Fills w x h pixels starting at x, y. Matches OLEDDisplay::fillRect().
+     *
+     * Works a page at a time: the rows of the rectangle inside a page become
+     * one bit mask that is ORed into every column, four columns per 32-bit
+     * word.
+     */
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * Turns w x h pixels starting at x, y off, the same way fillRect() sets
+     * them
+     */
+    void clearRect(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * w pixels to the right of x, y: one masked run within a page
+     */
+    void hline(int16_t x, int16_t y, int16_t w);
+
+    /**
+     * h pixels down from x, y: one masked OR per page it crosses
+     */
+    void vline(int16_t x, int16_t y, int16_t h);
+
+    /**
+     * Reference versions of drawLine() and fillRect() that set one pixel at a
+     * time, kept to benchmark and verify the fast paths against
+     */
+    void drawLinePixels(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+    void fillRectPixels(int16_t x, int16_t y, int16_t w, int16_t h);
+
+    /**
+     * ORs a pre-rasterized bitmap into the frame with its top left corner at
+     * x, y. The bitmap is in the same page layout: `pages` rows of `width`
+     * column bytes. Page-aligned y is a plain byte copy, otherwise every byte
+     * is split across two pages.
+     */
+    void blit(const uint8_t *bitmap, uint8_t width, uint8_t pages, int16_t x,
+              int16_t y);
+
+    /**
+     * Streams the frame as a binary PBM (P4) image, lit pixels are black.
+     *
+     * @return number of bytes written
+     */
+    size_t writePbm(FramebufferWriteCb write, void *ctx) const;
+};
+
+/**
+ * Converts up to length bytes of the PBM image of frame, a FRAMEBUFFER_SIZE
+ * buffer in page layout, starting at byte offset of the image. For streaming
+ * the image out in pieces straight from the frame.
+ *
+ * @return number of bytes written to out, 0 past the end of the image
+ */
+size_t framebufferReadPbm(const uint8_t *frame, size_t offset, uint8_t *out,
+                          size_t length);
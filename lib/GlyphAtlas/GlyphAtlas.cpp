@@ -0,0 +1,73 @@
+#include "GlyphAtlas.h"
+
+#include <string.h>
+
+GlyphAtlas::GlyphAtlas(uint8_t pages) {
+  this->_pages = pages;
+  memset(this->_index, 0, sizeof(this->_index));
+}
+
+bool GlyphAtlas::capture(const Framebuffer &fb, uint8_t code, uint8_t advance,
+                         uint8_t width) {
+  if (width < advance) width = advance;
+  if (width > FRAMEBUFFER_WIDTH) width = FRAMEBUFFER_WIDTH;
+
+  uint16_t size = width * this->_pages;
+
+  if (this->_index[code] || this->_glyphCount >= GLYPH_ATLAS_MAX_GLYPHS ||
+      this->_dataUsed + size > GLYPH_ATLAS_DATA_SIZE) {
+    return false;
+  }
+
+  Glyph &glyph = this->_glyphs[this->_glyphCount];
+  glyph.code    = code;
+  glyph.advance = advance;
+  glyph.width   = width;
+  glyph.offset  = this->_dataUsed;
+
+  for (uint8_t page = 0; page < this->_pages; page++) {
+    memcpy(this->_data + this->_dataUsed + page * width,
+           fb.buffer() + page * FRAMEBUFFER_WIDTH, width);
+  }
+
+  this->_dataUsed += size;
+  this->_index[code] = ++this->_glyphCount;
+
+  return true;
+}
+
+bool GlyphAtlas::covers(const char *text) const {
+  for (const uint8_t *c = (const uint8_t *)text; *c; c++) {
+    if (!this->_index[*c]) return false;
+  }
+
+  return true;
+}
+
+uint16_t GlyphAtlas::textWidth(const char *text) const {
+  uint16_t width = 0;
+
+  for (const uint8_t *c = (const uint8_t *)text; *c; c++) {
+    if (this->_index[*c]) width += this->_glyphs[this->_index[*c] - 1].advance;
+  }
+
+  return width;
+}
+
+int16_t GlyphAtlas::drawText(Framebuffer &fb, int16_t x, int16_t y,
+                             const char *text) const {
+  for (const uint8_t *c = (const uint8_t *)text; *c; c++) {
+    if (!this->_index[*c]) continue;
+
+    const Glyph &glyph = this->_glyphs[this->_index[*c] - 1];
+    fb.blit(this->_data + glyph.offset, glyph.width, this->_pages, x, y);
+    x += glyph.advance;
+  }
+
+  return x;
+}
+
+void GlyphAtlas::drawTextCentered(Framebuffer &fb, int16_t x, int16_t y,
+                                  const char *text) const {
+  this->drawText(fb, x - this->textWidth(text) / 2, y, text);
+}
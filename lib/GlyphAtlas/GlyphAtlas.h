@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Framebuffer.h"
+
+#define GLYPH_ATLAS_MAX_GLYPHS 24
+#define GLYPH_ATLAS_DATA_SIZE 768
+
+/**
+ * Pre-rasterized glyphs of one font, kept in the page layout of the frame so
+ * text is drawn with byte-wise blits instead of going through the font
+ * decoder every frame.
+ *
+ * Glyphs are captured once from a frame the font renderer drew them into and
+ * looked up by their (Latin-1) character code. Text that contains a character
+ * the atlas does not hold is reported by covers(), callers fall back to the
+ * font renderer for it.
+ */
+class GlyphAtlas {
+  private:
+    struct Glyph {
+      uint8_t  code;
+      uint8_t  advance;
+      uint8_t  width;
+      uint16_t offset;
+    };
+
+    uint8_t  _pages;
+    Glyph    _glyphs[GLYPH_ATLAS_MAX_GLYPHS];
+    uint8_t  _glyphCount = 0;
+    uint8_t  _data[GLYPH_ATLAS_DATA_SIZE];
+    uint16_t _dataUsed   = 0;
+    // direct lookup from character code to glyph index + 1
+    uint8_t  _index[256];
+
+  public:
+    /**
+     * @param pages rows of 8 pixels every glyph occupies
+     */
+    GlyphAtlas(uint8_t pages);
+
+    /**
+     * Copies the glyph drawn with its top left corner at 0, 0 of fb into the
+     * atlas. advance is how far the pen moves after it, width how many
+     * columns of raster to keep (at least advance).
+     *
+     * @return false when the atlas is full
+     */
+    bool capture(const Framebuffer &fb, uint8_t code, uint8_t advance,
+                 uint8_t width);
+
+    bool covers(const char *text) const;
+
+    /**
+     * @return width of text in pixels, counting only characters in the atlas
+     */
+    uint16_t textWidth(const char *text) const;
+
+    /**
+     * Draws text with its top left corner at x, y
+     *
+     * @return x after the last character
+     */
+    int16_t drawText(Framebuffer &fb, int16_t x, int16_t y, const char *text) const;
+
+    /**
+     * Draws text centered on x the same way the OLED driver's
+     * TEXT_ALIGN_CENTER does
+     */
+    void drawTextCentered(Framebuffer &fb, int16_t x, int16_t y,
+                          const char *text) const;
+};
@@ -0,0 +1,250 @@
+#include "HaSensor.h"
+
+#include <string.h>
+
+// the part of a response still to be looked at
+struct JsonCursor {
+  const char *p;
+  const char *end;
+};
+
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// numbers, true, false and null
+static bool isLiteral(char c) {
+  return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         c == '-' || c == '+' || c == '.';
+}
+
+static void skipSpace(JsonCursor &c) {
+  while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) {
+    c.p++;
+  }
+}
+
+// past the closing quote of the string at c.p, text and length are its
+// content as is, escapes included
+static bool readString(JsonCursor &c, const char *&text, size_t &length) {
+  const char *start = ++c.p;
+
+  while (c.p < c.end && *c.p != '"') {
+    if (*c.p == '\\' && ++c.p == c.end) return false;
+    c.p++;
+  }
+  if (c.p == c.end) return false;
+
+  text = start;
+  length = c.p++ - start;
+  return true;
+}
+
+// past the value at c.p, nested objects and arrays are only bracket counted
+static DeserializationError skipValue(JsonCursor &c) {
+  uint16_t depth = 0;
+  const char *text;
+  size_t length;
+
+  do {
+    skipSpace(c);
+    if (c.p >= c.end) return DeserializationError::IncompleteInput;
+
+    char ch = *c.p;
+    if (ch == '"') {
+      if (!readString(c, text, length)) return DeserializationError::IncompleteInput;
+    } else if (ch == '{' || ch == '[') {
+      depth++;
+      c.p++;
+    } else if ((ch == '}' || ch == ']' || ch == ',' || ch == ':') && depth > 0) {
+      if (ch == '}' || ch == ']') depth--;
+      c.p++;
+    } else if (isLiteral(ch)) {
+      while (c.p < c.end && isLiteral(*c.p)) c.p++;
+    } else {
+      return DeserializationError::InvalidInput;
+    }
+  } while (depth > 0);
+
+  return DeserializationError::Ok;
+}
+
+// leaves c at the value of key in the object at c.p, found is false when the
+// object doesn't have it
+static DeserializationError findMember(JsonCursor &c, const char *key,
+                                       bool &found) {
+  size_t keyLength = strlen(key);
+  const char *text;
+  size_t length;
+
+  found = false;
+  skipSpace(c);
+  if (c.p >= c.end) return DeserializationError::EmptyInput;
+  if (*c.p++ != '{') return DeserializationError::InvalidInput;
+
+  skipSpace(c);
+  if (c.p < c.end && *c.p == '}') return DeserializationError::Ok;
+
+  while (true) {
+    skipSpace(c);
+    if (c.p >= c.end) return DeserializationError::IncompleteInput;
+    if (*c.p != '"') return DeserializationError::InvalidInput;
+    if (!readString(c, text, length)) return DeserializationError::IncompleteInput;
+
+    skipSpace(c);
+    if (c.p >= c.end) return DeserializationError::IncompleteInput;
+    if (*c.p++ != ':') return DeserializationError::InvalidInput;
+    skipSpace(c);
+
+    if (length == keyLength && memcmp(text, key, length) == 0) {
+      found = true;
+      return DeserializationError::Ok;
+    }
+
+    DeserializationError error = skipValue(c);
+    if (error) return error;
+
+    skipSpace(c);
+    if (c.p >= c.end) return DeserializationError::IncompleteInput;
+    if (*c.p == '}') return DeserializationError::Ok;
+    if (*c.p++ != ',') return DeserializationError::InvalidInput;
+  }
+}
+
+DeserializationError haParseReading(const uint8_t *json, size_t length,
+                                    const HaEntityFormat &format,
+                                    int16_t &value) {
+  JsonCursor c = {(const char *)json, (const char *)json + length};
+  bool found;
+  DeserializationError error;
+
+  value = SENSOR_NO_VALUE;
+
+  if (format.attribute) {
+    error = findMember(c, "attributes", found);
+    if (error || !found) return error;
+  }
+
+  error = findMember(c, format.member, found);
+  if (error || !found) return error;
+
+  if (c.p >= c.end) return DeserializationError::IncompleteInput;
+
+  const char *text = c.p;
+  size_t textLength;
+
+  if (*c.p == '"') {
+    if (!readString(c, text, textLength)) return DeserializationError::IncompleteInput;
+  } else if (isLiteral(*c.p)) {
+    while (c.p < c.end && isLiteral(*c.p)) c.p++;
+    textLength = c.p - text;
+  } else {
+    // an object or array where a reading should be
+    return DeserializationError::Ok;
+  }
+
+  if (!haParseFixed(text, textLength, format.decimals, value)) {
+    value = SENSOR_NO_VALUE;
+  }
+
+  return DeserializationError::Ok;
+}
+
+bool haParseFixed(const char *text, size_t length, uint8_t decimals,
+                  int16_t &value) {
+  const char *p = text, *end = text + length;
+  bool negative = p < end && *p == '-';
+  int32_t result = 0;
+  uint8_t fractionDigits = 0;
+  bool digits = false, roundUp = false;
+
+  if (decimals > HA_MAX_DECIMALS) return false;
+  if (negative || (p < end && *p == '+')) p++;
+
+  for (; p < end && isDigit(*p); p++) {
+    result = result * 10 + (*p - '0');
+    digits = true;
+    if (result > INT16_MAX) return false;
+  }
+
+  if (p < end && *p == '.') {
+    for (p++; p < end && isDigit(*p); p++) {
+      if (fractionDigits < decimals) {
+        result = result * 10 + (*p - '0');
+        fractionDigits++;
+        if (result > INT16_MAX) return false;
+      } else if (fractionDigits == decimals) {
+        // only the first digit past the precision decides
+        roundUp = *p >= '5';
+        fractionDigits++;
+      }
+      digits = true;
+    }
+  }
+
+  for (; fractionDigits < decimals; fractionDigits++) {
+    result *= 10;
+    if (result > INT16_MAX) return false;
+  }
+  if (roundUp) result++;
+
+  if (!digits || p != end || result > INT16_MAX) return false;
+
+  value = (int16_t)(negative ? -result : result);
+  return true;
+}
+
+// writes into a buffer of HA_FIXED_TEXT_SIZE
+static size_t formatFixed(int16_t value, uint8_t decimals, char *out) {
+  if (value == SENSOR_NO_VALUE || decimals > HA_MAX_DECIMALS) {
+    memcpy(out, SENSOR_NO_VALUE_STR, sizeof(SENSOR_NO_VALUE_STR));
+    return sizeof(SENSOR_NO_VALUE_STR) - 1;
+  }
+
+  char digits[5];
+  uint16_t magnitude = value < 0 ? -value : value;
+  uint8_t count = 0;
+  size_t length = 0;
+
+  // least significant first, at least one integer digit
+  do {
+    digits[count++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0 || count <= decimals);
+
+  if (value < 0) out[length++] = '-';
+  while (count > decimals) out[length++] = digits[--count];
+  if (decimals > 0) {
+    out[length++] = '.';
+    while (count > 0) out[length++] = digits[--count];
+  }
+  out[length] = '\0';
+
+  return length;
+}
+
+size_t haFormatFixed(int16_t value, uint8_t decimals, char *out, size_t size) {
+  if (size == 0) return 0;
+
+  char text[HA_FIXED_TEXT_SIZE];
+  size_t length = formatFixed(value, decimals, text);
+
+  if (length > size - 1) length = size - 1;
+  memcpy(out, text, length);
+  out[length] = '\0';
+
+  return length;
+}
+
+size_t haFormatReading(int16_t value, const HaEntityFormat &format, char *out,
+                       size_t size) {
+  size_t length = haFormatFixed(value, format.decimals, out, size);
+  size_t unitLength = strlen(format.unit);
+
+  if (size == 0) return 0;
+  if (unitLength > size - 1 - length) unitLength = size - 1 - length;
+  memcpy(out + length, format.unit, unitLength);
+  out[length + unitLength] = '\0';
+
+  return length + unitLength;
+}
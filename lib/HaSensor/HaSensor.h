@@ -0,0 +1,74 @@
+#pragma once
+
+#define ARDUINOJSON_USE_DOUBLE 0
+#include <ArduinoJson.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+static const char SENSOR_NO_VALUE_STR[] = "-.-";
+
+// stored instead of a reading that is unavailable or out of range
+#define SENSOR_NO_VALUE INT16_MIN
+// more would leave no integer digits in an int16_t
+#define HA_MAX_DECIMALS 4
+// "-3.2767" or "-32767" including the terminator
+#define HA_FIXED_TEXT_SIZE 8
+// a number and a unit of up to 4 bytes
+#define HA_READING_TEXT_SIZE (HA_FIXED_TEXT_SIZE + 4)
+
+/**
+ * Where a HomeAssistant state object keeps an entity's reading and how it is
+ * stored and shown. Readings are fixed point integers, value / 10^decimals.
+ */
+struct HaEntityFormat {
+  // member holding the value, of "attributes" when attribute is set
+  const char *member;
+  bool        attribute;
+  uint8_t     decimals;
+  // appended by haFormatReading(), in the panel fonts' Latin-1
+  const char *unit;
+};
+
+// the state of a temperature sensor, like sensor.indoor_temperature
+static const HaEntityFormat HA_SENSOR_TEMPERATURE = {"state", false, 1,
+                                                     "\xB0" "C"};
+// the current temperature of a weather entity, like weather.forecast_home
+static const HaEntityFormat HA_WEATHER_TEMPERATURE = {"temperature", true, 1,
+                                                      "\xB0" "C"};
+
+/**
+ * Reads the value format describes straight from the JSON text of a state
+ * object into value. Only the members in front of it are looked at. A value
+ * that is missing, "unavailable", not a number or out of range is stored as
+ * SENSOR_NO_VALUE.
+ *
+ * @return an error when the JSON in front of the value is malformed or cut
+ */
+DeserializationError haParseReading(const uint8_t *json, size_t length,
+                                    const HaEntityFormat &format,
+                                    int16_t &value);
+
+/**
+ * Converts a decimal like "21.45" or "-3" of length bytes to a fixed point
+ * integer with decimals digits after the point, rounded half away from zero,
+ * without going through float
+ *
+ * @return false for anything that isn't a plain decimal or doesn't fit
+ */
+bool haParseFixed(const char *text, size_t length, uint8_t decimals,
+                  int16_t &value);
+
+/**
+ * Writes the fixed point value with decimals digits after the point, or
+ * SENSOR_NO_VALUE_STR, into out, cut to fit size
+ *
+ * @return length written
+ */
+size_t haFormatFixed(int16_t value, uint8_t decimals, char *out, size_t size);
+
+/**
+ * haFormatFixed() with the unit of format appended
+ */
+size_t haFormatReading(int16_t value, const HaEntityFormat &format, char *out,
+                       size_t size);
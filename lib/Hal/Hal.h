@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Thin hardware abstraction for everything the portable display logic needs
+ * from the board. The ESP32 implementation forwards to the Arduino core, the
+ * native one is a simulator driven by a virtual clock.
+ */
+
+#define HAL_TOUCH_UNTOUCHED 200
+#define HAL_TOUCH_TOUCHED 20
+
+uint32_t halMillis(void);
+
+/**
+ * @return raw capacitive reading of the touch pad, lower means touched
+ */
+uint16_t halTouchRead(void);
+
+bool halWiFiConnected(void);
+int32_t halWiFiRSSI(void);
+
+#ifndef ARDUINO
+#define HAL_SIM_MAX_TOUCHES 16
+
+/**
+ * Moves the virtual clock forward, nothing happens in between
+ */
+void halSimAdvance(uint32_t ms);
+void halSimSetMillis(uint32_t ms);
+
+/**
+ * Schedules a finger on the touch pad from atMs for durationMs
+ *
+ * @return false when the touch script is full
+ */
+bool halSimScriptTouch(uint32_t atMs, uint32_t durationMs);
+
+/**
+ * Stands in for the touch interrupt
+ *
+ * @return ms until the next scripted touch starts, 0 while one is going on,
+ *         UINT32_MAX when none is left
+ */
+uint32_t halSimMsUntilTouch(void);
+
+/**
+ * Holds the touch pad at a raw reading instead of following the script, for
+ * replaying recorded samples
+ */
+void halSimSetTouch(uint16_t level);
+
+void halSimSetWiFi(bool connected, int32_t rssi);
+#endif
@@ -0,0 +1,18 @@
+#ifdef ARDUINO
+
+#include "Hal.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#define HAL_TOUCH_PIN T0
+
+uint32_t halMillis(void) { return millis(); }
+
+uint16_t halTouchRead(void) { return touchRead(HAL_TOUCH_PIN); }
+
+bool halWiFiConnected(void) { return WiFi.isConnected(); }
+
+int32_t halWiFiRSSI(void) { return WiFi.RSSI(); }
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef ARDUINO
+
+#include "Hal.h"
+
+struct SimTouch {
+  uint32_t startMs;
+  uint32_t durationMs;
+};
+
+static uint32_t simMillis = 0;
+
+static SimTouch simTouches[HAL_SIM_MAX_TOUCHES];
+static uint8_t simTouchCount = 0;
+static bool simTouchHeld = false;
+static uint16_t simTouchLevel = HAL_TOUCH_UNTOUCHED;
+
+static bool simWiFiConnected = true;
+static int32_t simWiFiRSSI = -60;
+
+uint32_t halMillis(void) { return simMillis; }
+
+uint16_t halTouchRead(void) {
+  if (simTouchHeld) return simTouchLevel;
+
+  for (uint8_t i = 0; i < simTouchCount; i++) {
+    if (simMillis - simTouches[i].startMs < simTouches[i].durationMs) {
+      return HAL_TOUCH_TOUCHED;
+    }
+  }
+
+  return HAL_TOUCH_UNTOUCHED;
+}
+
+uint32_t halSimMsUntilTouch(void) {
+  uint32_t next = UINT32_MAX;
+
+  if (simTouchHeld) return next;
+
+  for (uint8_t i = 0; i < simTouchCount; i++) {
+    uint32_t startMs = simTouches[i].startMs;
+
+    if (simMillis - startMs < simTouches[i].durationMs) return 0;
+    if ((int32_t)(startMs - simMillis) > 0 && startMs - simMillis < next) {
+      next = startMs - simMillis;
+    }
+  }
+
+  return next;
+}
+
+bool halWiFiConnected(void) { return simWiFiConnected; }
+
+int32_t halWiFiRSSI(void) { return simWiFiRSSI; }
+
+void halSimAdvance(uint32_t ms) { simMillis += ms; }
+
+void halSimSetMillis(uint32_t ms) { simMillis = ms; }
+
+bool halSimScriptTouch(uint32_t atMs, uint32_t durationMs) {
+  if (simTouchCount >= HAL_SIM_MAX_TOUCHES) {
+    return false;
+  }
+
+  simTouches[simTouchCount].startMs = atMs;
+  simTouches[simTouchCount].durationMs = durationMs;
+  simTouchCount++;
+
+  return true;
+}
+
+void halSimSetTouch(uint16_t level) {
+  simTouchHeld = true;
+  simTouchLevel = level;
+}
+
+void halSimSetWiFi(bool connected, int32_t rssi) {
+  simWiFiConnected = connected;
+  simWiFiRSSI = rssi;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "LoopbackHttp.h"
+
+#include <string.h>
+
+#include "Hal.h"
+
+static const char LOOPBACK_NOT_FOUND_URL[] = "";
+
+bool LoopbackHttp::route(const char *url, int status, const char *body,
+                         uint32_t delayMs) {
+  if (this->_routeCount >= LOOPBACK_HTTP_MAX_ROUTES) return false;
+
+  Route &r = this->_routes[this->_routeCount++];
+  r.url     = url;
+  r.status  = status;
+  r.body    = body;
+  r.delayMs = delayMs;
+
+  return true;
+}
+
+void LoopbackHttp::setFaults(const LoopbackHttpFaults &faults) {
+  this->_faults = faults;
+  this->_random = faults.seed ? faults.seed : 1;
+}
+
+void LoopbackHttp::setTimeout(uint32_t timeoutMs) {
+  this->_timeoutMs = timeoutMs;
+}
+
+void LoopbackHttp::hold(bool held) {
+  this->_held = held;
+}
+
+void LoopbackHttp::setTap(LoopbackHttpTap tap, void *ctx) {
+  this->_tap = tap;
+  this->_tapCtx = ctx;
+}
+
+// xorshift32
+uint32_t LoopbackHttp::nextRandom() {
+  this->_random ^= this->_random << 13;
+  this->_random ^= this->_random >> 17;
+  this->_random ^= this->_random << 5;
+
+  return this->_random;
+}
+
+bool LoopbackHttp::get(const char *url, LoopbackHttpCallback callback, void *arg) {
+  static const Route notFound = {LOOPBACK_NOT_FOUND_URL, 404, "", 0};
+  static const Route unauthorized = {LOOPBACK_NOT_FOUND_URL, 401,
+                                     "401: Unauthorized", 0};
+  static const Route serverError = {LOOPBACK_NOT_FOUND_URL, 500,
+                                    "500 Internal Server Error", 0};
+  static const Route timedOut = {LOOPBACK_NOT_FOUND_URL, LOOPBACK_HTTP_TIMEOUT,
+                                 "", 0};
+
+  if (this->_pendingCount >= LOOPBACK_HTTP_MAX_PENDING ||
+      strlen(url) >= LOOPBACK_HTTP_MAX_URL) {
+    return false;
+  }
+
+  if (this->_held) {
+    Pending &p = this->_pending[this->_pendingCount++];
+    p.route    = nullptr;
+    strcpy(p.url, url);
+    p.callback = callback;
+    p.arg      = arg;
+    // when it was queued, respond() answers the oldest first
+    p.dueMs    = halMillis();
+
+    return true;
+  }
+
+  const Route *match = &notFound;
+  for (uint8_t i = 0; i < this->_routeCount; i++) {
+    if (strcmp(this->_routes[i].url, url) == 0) {
+      match = &this->_routes[i];
+      break;
+    }
+  }
+
+  uint32_t delayMs = match->delayMs + this->_faults.handshakeMs;
+  if (this->_faults.jitterMs) {
+    delayMs += this->nextRandom() % (this->_faults.jitterMs + 1);
+  }
+
+  if (this->nextRandom() % 1000 < this->_faults.errorPermille) {
+    match = (this->nextRandom() & 1) ? &unauthorized : &serverError;
+  } else if (this->nextRandom() % 1000 < this->_faults.slowPermille) {
+    delayMs += this->_faults.slowDelayMs;
+  }
+
+  if (this->_timeoutMs && delayMs > this->_timeoutMs) {
+    match = &timedOut;
+    delayMs = this->_timeoutMs;
+  }
+
+  Pending &p = this->_pending[this->_pendingCount++];
+  p.route    = match;
+  strcpy(p.url, url);
+  p.callback = callback;
+  p.arg      = arg;
+  p.dueMs    = halMillis() + delayMs;
+
+  return true;
+}
+
+void LoopbackHttp::poll() {
+  uint32_t now = halMillis();
+  uint8_t i = 0;
+
+  while (i < this->_pendingCount) {
+    const Pending &p = this->_pending[i];
+
+    if (!p.route || (int32_t)(now - p.dueMs) < 0) {
+      i++;
+      continue;
+    }
+
+    this->deliver(i, p.route->status, p.route->body, strlen(p.route->body));
+  }
+}
+
+bool LoopbackHttp::respond(const char *url, int status, const char *body,
+                           size_t length) {
+  // removal swaps requests out of order, so look at when they were queued
+  uint8_t oldest = this->_pendingCount;
+
+  for (uint8_t i = 0; i < this->_pendingCount; i++) {
+    const Pending &p = this->_pending[i];
+
+    if (!p.route && strcmp(p.url, url) == 0 &&
+        (oldest == this->_pendingCount ||
+         (int32_t)(p.dueMs - this->_pending[oldest].dueMs) < 0)) {
+      oldest = i;
+    }
+  }
+
+  if (oldest == this->_pendingCount) return false;
+
+  this->deliver(oldest, status, body, length);
+  return true;
+}
+
+void LoopbackHttp::deliver(uint8_t index, int status, const char *body,
+                           size_t length) {
+  Pending p = this->_pending[index];
+
+  // remove before calling back so the callback may queue the next request
+  this->_pending[index] = this->_pending[--this->_pendingCount];
+  if (this->_tap) this->_tap(this->_tapCtx, p.url, status, body, length);
+  p.callback(p.arg, status, body, length);
+}
+
+uint8_t LoopbackHttp::inFlight() {
+  return this->_pendingCount;
+}
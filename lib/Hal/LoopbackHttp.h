@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOOPBACK_HTTP_MAX_ROUTES 64
+#define LOOPBACK_HTTP_MAX_PENDING 64
+// longest URL a request can be matched and tapped by, like a stock quote's
+#define LOOPBACK_HTTP_MAX_URL 256
+
+// same status AsyncHTTPRequest reports when a request times out
+#define LOOPBACK_HTTP_TIMEOUT -11
+
+typedef void (*LoopbackHttpCallback)(void *arg, int status, const char *body,
+                                     size_t length);
+
+// sees every response right before its callback, with the URL requested
+typedef void (*LoopbackHttpTap)(void *ctx, const char *url, int status,
+                                const char *body, size_t length);
+
+/**
+ * Fault and latency injection for LoopbackHttp. Rates are in permille and
+ * drawn from a seeded PRNG so runs are repeatable.
+ */
+struct LoopbackHttpFaults {
+  // extra uniformly distributed latency on top of the route delay
+  uint32_t jitterMs;
+  // fixed cost of a new connection, models the TLS handshake
+  uint32_t handshakeMs;
+  // answered with 401 or 500 instead of the route
+  uint16_t errorPermille;
+  // slow-loris: the server trickles the response for slowDelayMs
+  uint16_t slowPermille;
+  uint32_t slowDelayMs;
+  uint32_t seed;
+};
+
+/**
+ * In-process stand-in for the HomeAssistant REST API. Requests are answered
+ * from a fixed route table after a per-route delay measured on halMillis(),
+ * so the simulator can exercise the fetch path without a network.
+ */
+class LoopbackHttp {
+  private:
+    struct Route {
+      const char *url;
+      int         status;
+      const char *body;
+      uint32_t    delayMs;
+    };
+
+    struct Pending {
+      // nullptr while held for respond()
+      const Route         *route;
+      char                 url[LOOPBACK_HTTP_MAX_URL];
+      LoopbackHttpCallback callback;
+      void                *arg;
+      uint32_t             dueMs;
+    };
+
+    Route   _routes[LOOPBACK_HTTP_MAX_ROUTES];
+    uint8_t _routeCount = 0;
+
+    Pending _pending[LOOPBACK_HTTP_MAX_PENDING];
+    uint8_t _pendingCount = 0;
+
+    LoopbackHttpFaults _faults = LoopbackHttpFaults();
+    uint32_t           _random = 1;
+    uint32_t           _timeoutMs = 0;
+    bool               _held = false;
+
+    LoopbackHttpTap _tap = nullptr;
+    void           *_tapCtx = nullptr;
+
+    uint32_t nextRandom();
+    void deliver(uint8_t index, int status, const char *body, size_t length);
+
+  public:
+    /**
+     * Answers GET url with status and body after delayMs. Unknown URLs get
+     * an immediate 404.
+     */
+    bool route(const char *url, int status, const char *body, uint32_t delayMs = 0);
+
+    void setFaults(const LoopbackHttpFaults &faults);
+
+    /**
+     * Responses slower than this are reported as LOOPBACK_HTTP_TIMEOUT once
+     * it elapsed, 0 waits forever
+     */
+    void setTimeout(uint32_t timeoutMs);
+
+    /**
+     * Held requests wait for respond() instead of being answered from the
+     * route table, for replaying recorded responses
+     */
+    void hold(bool held);
+
+    void setTap(LoopbackHttpTap tap, void *ctx);
+
+    /**
+     * Queues a GET, the callback fires from poll() once the delay passed
+     *
+     * @return false when too many requests are in flight
+     */
+    bool get(const char *url, LoopbackHttpCallback callback, void *arg);
+
+    /**
+     * Delivers every response that is due
+     */
+    void poll();
+
+    /**
+     * Answers the oldest request for url that is held, right away
+     *
+     * @return false when no request for url is waiting
+     */
+    bool respond(const char *url, int status, const char *body, size_t length);
+
+    uint8_t inFlight();
+};
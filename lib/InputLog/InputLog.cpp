@@ -0,0 +1,232 @@
+#include "InputLog.h"
+
+#include <string.h>
+
+static const uint8_t INPUT_LOG_MAGIC[] = {'D', 'D', 'I', 'N'};
+
+static size_t putVarint(uint8_t *out, uint32_t value) {
+  size_t length = 0;
+
+  while (value >= 0x80) {
+    out[length++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[length++] = (uint8_t)value;
+
+  return length;
+}
+
+static size_t putUint16(uint8_t *out, uint16_t value) {
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+
+  return 2;
+}
+
+static uint16_t getUint16(const uint8_t *in) {
+  return (uint16_t)(in[0] | in[1] << 8);
+}
+
+InputLogWriter::InputLogWriter(InputLogWriteCb write, void *ctx,
+                               size_t capacity)
+    : _write(write), _ctx(ctx), _capacity(capacity) {}
+
+// a record that won't fit ends the log in front of it
+bool InputLogWriter::reserve(size_t length) {
+  if (this->_failed) return false;
+  if (length > this->_capacity - this->_bytes) this->_failed = true;
+
+  return !this->_failed;
+}
+
+bool InputLogWriter::put(const uint8_t *data, size_t length) {
+  if (this->_failed) return false;
+  if (length == 0) return true;
+
+  size_t written = this->_write(this->_ctx, data, length);
+  this->_bytes += written;
+  if (written != length) this->_failed = true;
+
+  return !this->_failed;
+}
+
+bool InputLogWriter::putRecord(uint8_t type, uint32_t ms, const uint8_t *fixed,
+                               size_t length) {
+  uint8_t head[INPUT_LOG_RECORD_MAX_FIXED];
+  size_t headLength = 0;
+
+  head[headLength++] = type;
+  headLength += putVarint(head + headLength, ms - this->_lastMs);
+  memcpy(head + headLength, fixed, length);
+  this->_lastMs = ms;
+
+  return this->reserve(headLength + length) &&
+         this->put(head, headLength + length);
+}
+
+bool InputLogWriter::begin() {
+  uint8_t header[INPUT_LOG_HEADER_SIZE];
+
+  memcpy(header, INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC));
+  header[sizeof(INPUT_LOG_MAGIC)] = INPUT_LOG_VERSION;
+  this->_lastMs = 0;
+
+  return this->reserve(sizeof(header)) &&
+         this->put(header, sizeof(header));
+}
+
+bool InputLogWriter::http(uint32_t ms, int16_t status, const char *url,
+                          const uint8_t *body, size_t length) {
+  uint8_t fixed[7];
+  size_t urlLength = strlen(url);
+  size_t fixedLength = putUint16(fixed, (uint16_t)status);
+  fixedLength += putVarint(fixed + fixedLength, urlLength);
+
+  uint8_t bodyLength[5];
+  size_t bodyLengthSize = putVarint(bodyLength, length);
+
+  // type, time delta and the rest, all of it or nothing
+  uint8_t delta[5];
+  size_t recordLength = 1 + putVarint(delta, ms - this->_lastMs) +
+                        fixedLength + urlLength + bodyLengthSize + length;
+  if (!this->reserve(recordLength)) return false;
+
+  return this->putRecord(INPUT_LOG_HTTP, ms, fixed, fixedLength) &&
+         this->put((const uint8_t *)url, urlLength) &&
+         this->put(bodyLength, bodyLengthSize) && this->put(body, length);
+}
+
+bool InputLogWriter::ntp(uint32_t ms, uint32_t epoch, uint16_t msIntoSecond) {
+  uint8_t fixed[6];
+  putUint16(fixed, (uint16_t)epoch);
+  putUint16(fixed + 2, (uint16_t)(epoch >> 16));
+  putUint16(fixed + 4, msIntoSecond);
+
+  return this->putRecord(INPUT_LOG_NTP, ms, fixed, sizeof(fixed));
+}
+
+bool InputLogWriter::wifi(uint32_t ms, bool connected, int8_t rssi) {
+  uint8_t fixed[2] = {connected, (uint8_t)rssi};
+
+  return this->putRecord(INPUT_LOG_WIFI, ms, fixed, sizeof(fixed));
+}
+
+bool InputLogWriter::touch(uint32_t ms, uint16_t level) {
+  uint8_t fixed[2];
+  putUint16(fixed, level);
+
+  return this->putRecord(INPUT_LOG_TOUCH, ms, fixed, sizeof(fixed));
+}
+
+size_t InputLogWriter::bytesWritten() {
+  return this->_bytes;
+}
+
+bool InputLogWriter::failed() {
+  return this->_failed;
+}
+
+InputLogReader::InputLogReader(const uint8_t *data, size_t length)
+    : _data(data), _length(length) {}
+
+bool InputLogReader::getVarint(uint32_t &value) {
+  value = 0;
+
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (this->_offset >= this->_length) return false;
+
+    uint8_t byte = this->_data[this->_offset++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+
+  return false;
+}
+
+bool InputLogReader::getBytes(size_t count, const uint8_t *&bytes) {
+  if (count > this->_length - this->_offset) return false;
+
+  bytes = this->_data + this->_offset;
+  this->_offset += count;
+
+  return true;
+}
+
+bool InputLogReader::begin() {
+  const uint8_t *header;
+
+  this->_offset = 0;
+  this->_ms = 0;
+
+  return this->getBytes(INPUT_LOG_HEADER_SIZE, header) &&
+         memcmp(header, INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC)) == 0 &&
+         header[sizeof(INPUT_LOG_MAGIC)] == INPUT_LOG_VERSION;
+}
+
+bool InputLogReader::next(InputLogRecord &record) {
+  size_t start = this->_offset;
+  const uint8_t *fixed;
+  uint32_t delta;
+
+  if (this->_offset >= this->_length) return false;
+
+  memset(&record, 0, sizeof(record));
+  record.type = this->_data[this->_offset++];
+
+  bool ok = this->getVarint(delta);
+  if (ok) {
+    switch (record.type) {
+    case INPUT_LOG_HTTP: {
+      uint32_t urlLength, bodyLength;
+      const uint8_t *url;
+
+      ok = this->getBytes(2, fixed) && this->getVarint(urlLength) &&
+           this->getBytes(urlLength, url) && this->getVarint(bodyLength) &&
+           this->getBytes(bodyLength, record.body);
+      if (ok) {
+        record.status = (int16_t)getUint16(fixed);
+        record.url = (const char *)url;
+        record.urlLength = urlLength;
+        record.bodyLength = bodyLength;
+      }
+      break;
+    }
+    case INPUT_LOG_NTP:
+      ok = this->getBytes(6, fixed);
+      if (ok) {
+        record.epoch = getUint16(fixed) | (uint32_t)getUint16(fixed + 2) << 16;
+        record.msIntoSecond = getUint16(fixed + 4);
+      }
+      break;
+    case INPUT_LOG_WIFI:
+      ok = this->getBytes(2, fixed);
+      if (ok) {
+        record.connected = fixed[0] != 0;
+        record.rssi = (int8_t)fixed[1];
+      }
+      break;
+    case INPUT_LOG_TOUCH:
+      ok = this->getBytes(2, fixed);
+      if (ok) record.touch = getUint16(fixed);
+      break;
+    default:
+      ok = false;
+      break;
+    }
+  }
+
+  if (!ok) {
+    // stays put, complete() reports the rest as unread
+    this->_offset = start;
+    return false;
+  }
+
+  this->_ms += delta;
+  record.ms = this->_ms;
+
+  return true;
+}
+
+bool InputLogReader::complete() {
+  return this->_offset == this->_length;
+}
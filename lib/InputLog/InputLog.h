@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// bumped whenever the record layout changes, older logs are refused
+#define INPUT_LOG_VERSION 1
+// magic and version in front of the first record
+#define INPUT_LOG_HEADER_SIZE 5
+// type, time delta and the fixed part of the largest record
+#define INPUT_LOG_RECORD_MAX_FIXED 16
+
+/**
+ * Everything from outside the display that decides what it shows. A record
+ * is the type, the ms since the previous record as a varint, then:
+ *
+ *   HTTP   status (int16), url and body, each a varint length and the bytes
+ *   NTP    UTC epoch (uint32) and the ms it was into that second (uint16)
+ *   WIFI   connected (uint8) and RSSI (int8)
+ *   TOUCH  raw touch pad reading (uint16)
+ *
+ * Integers are little endian. Touch and WiFi are only written when they
+ * change, so a quiet minute takes a few bytes.
+ */
+enum InputLogType : uint8_t {
+  INPUT_LOG_HTTP = 1,
+  INPUT_LOG_NTP,
+  INPUT_LOG_WIFI,
+  INPUT_LOG_TOUCH,
+};
+
+/**
+ * A decoded record. Url and body point into the log and are not terminated.
+ */
+struct InputLogRecord {
+  uint8_t        type;
+  // since the log began, the sum of the deltas
+  uint32_t       ms;
+  int16_t        status;
+  const char    *url;
+  size_t         urlLength;
+  const uint8_t *body;
+  size_t         bodyLength;
+  uint32_t       epoch;
+  uint16_t       msIntoSecond;
+  bool           connected;
+  int8_t         rssi;
+  uint16_t       touch;
+};
+
+typedef size_t (*InputLogWriteCb)(void *ctx, const uint8_t *data, size_t length);
+
+/**
+ * Encodes records and hands them to a write callback, a file in the
+ * simulator and a RAM buffer on the device. Not thread safe, the callers
+ * serialize. After one short write everything else is dropped, a log with
+ * a hole in it would replay into something that never happened.
+ *
+ * With a capacity a record that doesn't fit in what is left is refused
+ * before any of it is written, so a full buffer ends on a whole record.
+ */
+class InputLogWriter {
+  private:
+    InputLogWriteCb _write;
+    void           *_ctx;
+    size_t          _capacity;
+    uint32_t        _lastMs = 0;
+    size_t          _bytes = 0;
+    bool            _failed = false;
+
+    bool reserve(size_t length);
+    bool put(const uint8_t *data, size_t length);
+    bool putRecord(uint8_t type, uint32_t ms, const uint8_t *fixed,
+                   size_t length);
+
+  public:
+    /**
+     * @param capacity bytes write takes in all, SIZE_MAX when it is only
+     *                 known by a short write
+     */
+    InputLogWriter(InputLogWriteCb write, void *ctx,
+                   size_t capacity = SIZE_MAX);
+
+    /**
+     * Writes the header, times of the records that follow must not go back
+     */
+    bool begin();
+
+    bool http(uint32_t ms, int16_t status, const char *url, const uint8_t *body,
+              size_t length);
+    bool ntp(uint32_t ms, uint32_t epoch, uint16_t msIntoSecond);
+    bool wifi(uint32_t ms, bool connected, int8_t rssi);
+    bool touch(uint32_t ms, uint16_t level);
+
+    size_t bytesWritten();
+
+    /**
+     * @return true once a write came up short, nothing is written after it
+     */
+    bool failed();
+};
+
+/**
+ * Walks the records of a log held in memory without copying them
+ */
+class InputLogReader {
+  private:
+    const uint8_t *_data;
+    size_t         _length;
+    size_t         _offset = 0;
+    uint32_t       _ms = 0;
+
+    bool getVarint(uint32_t &value);
+    bool getBytes(size_t count, const uint8_t *&bytes);
+
+  public:
+    InputLogReader(const uint8_t *data, size_t length);
+
+    /**
+     * @return false when the header is missing or of another version
+     */
+    bool begin();
+
+    /**
+     * @return false at the end of the log or at a record that is cut off or
+     *         of an unknown type, see complete()
+     */
+    bool next(InputLogRecord &record);
+
+    /**
+     * @return true when every byte of the log was read as a record
+     */
+    bool complete();
+};
@@ -0,0 +1,84 @@
+#include "LiveEvents.h"
+
+#include <stdio.h>
+
+#include "HaSensor.h"
+
+uint8_t liveStateChanges(const LiveState &before, const LiveState &now) {
+  uint8_t changes = 0;
+
+  if (before.insideReading != now.insideReading ||
+      before.outsideReading != now.outsideReading ||
+      before.stale != now.stale) {
+    changes |= LIVE_EVENT_READINGS;
+  }
+  if (before.timeSynced != now.timeSynced ||
+      before.utcOffset != now.utcOffset) {
+    changes |= LIVE_EVENT_TIME;
+  }
+  if (before.wifiConnected != now.wifiConnected ||
+      before.wifiBars != now.wifiBars) {
+    changes |= LIVE_EVENT_WIFI;
+  }
+
+  return changes;
+}
+
+const char *liveEventName(uint8_t event) {
+  switch (event) {
+  case LIVE_EVENT_READINGS:
+    return "readings";
+  case LIVE_EVENT_TIME:
+    return "time";
+  case LIVE_EVENT_WIFI:
+    return "wifi";
+  }
+
+  return "unknown";
+}
+
+// a JSON number, or null for a missing reading
+static void formatReading(int16_t value, const HaEntityFormat &format,
+                          char *out) {
+  if (value == SENSOR_NO_VALUE) {
+    snprintf(out, HA_FIXED_TEXT_SIZE, "null");
+  } else {
+    haFormatFixed(value, format.decimals, out, HA_FIXED_TEXT_SIZE);
+  }
+}
+
+size_t liveFormatEvent(uint8_t event, const LiveState &state, char *out,
+                       size_t size) {
+  int length = 0;
+
+  if (size == 0) return 0;
+
+  switch (event) {
+  case LIVE_EVENT_READINGS: {
+    char inside[HA_FIXED_TEXT_SIZE], outside[HA_FIXED_TEXT_SIZE];
+    formatReading(state.insideReading, HA_SENSOR_TEMPERATURE, inside);
+    formatReading(state.outsideReading, HA_WEATHER_TEMPERATURE, outside);
+    length = snprintf(out, size,
+                      "{\"inside\":%s,\"outside\":%s,\"stale\":%s}", inside,
+                      outside, state.stale ? "true" : "false");
+    break;
+  }
+  case LIVE_EVENT_TIME:
+    length = snprintf(out, size, "{\"synced\":%s,\"utcOffset\":%ld}",
+                      state.timeSynced ? "true" : "false",
+                      (long)state.utcOffset);
+    break;
+  case LIVE_EVENT_WIFI:
+    length = snprintf(out, size,
+                      "{\"connected\":%s,\"bars\":%u,\"rssi\":%d}",
+                      state.wifiConnected ? "true" : "false",
+                      (unsigned)state.wifiBars, (int)state.rssi);
+    break;
+  default:
+    out[0] = '\0';
+    break;
+  }
+
+  if (length < 0) return 0;
+  return (size_t)length < size ? (size_t)length : size - 1;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// longest data line of an event
+#define LIVE_EVENT_DATA_SIZE 96
+
+// one bit per kind of event, a state change can trigger several
+#define LIVE_EVENT_READINGS 0x01
+#define LIVE_EVENT_TIME 0x02
+#define LIVE_EVENT_WIFI 0x04
+#define LIVE_EVENT_ALL (LIVE_EVENT_READINGS | LIVE_EVENT_TIME | LIVE_EVENT_WIFI)
+
+/**
+ * What the display reports to remote viewers, in the units it keeps them in
+ */
+struct LiveState {
+  // fixed point as parsed, SENSOR_NO_VALUE when missing
+  int16_t  insideReading;
+  int16_t  outsideReading;
+  // a reading is older than the current run or the clock isn't synced
+  bool     stale;
+  bool     timeSynced;
+  // seconds local time is ahead of UTC, changes with daylight saving time
+  int32_t  utcOffset;
+  bool     wifiConnected;
+  uint8_t  wifiBars;
+  // reported with the other WiFi fields but too noisy to trigger an event
+  int8_t   rssi;
+};
+
+/**
+ * @return LIVE_EVENT_* bits of the events whose data differs between the
+ *         two states
+ */
+uint8_t liveStateChanges(const LiveState &before, const LiveState &now);
+
+/**
+ * @return the SSE event name of a single LIVE_EVENT_* bit
+ */
+const char *liveEventName(uint8_t event);
+
+/**
+ * Writes the data of a single LIVE_EVENT_* bit as a JSON object into out,
+ * cut to fit size
+ *
+ * @return length written
+ */
+size_t liveFormatEvent(uint8_t event, const LiveState &state, char *out,
+                       size_t size);
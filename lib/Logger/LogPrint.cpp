@@ -0,0 +1,31 @@
+#ifdef ARDUINO
+
+#include "LogPrint.h"
+
+LogPrint::LogPrint(uint8_t level) {
+  this->_level = level;
+}
+
+size_t LogPrint::write(uint8_t c) {
+  if (c == '\r') return 1;
+  if (c == '\n') {
+    this->flush();
+    return 1;
+  }
+
+  // an overlong line goes out in pieces
+  if (this->_length == sizeof(this->_line) - 1) this->flush();
+  this->_line[this->_length++] = (char)c;
+
+  return 1;
+}
+
+void LogPrint::flush() {
+  if (this->_length == 0) return;
+
+  this->_line[this->_length] = '\0';
+  this->_length = 0;
+  logWrite(this->_level, "%s", this->_line);
+}
+
+#endif
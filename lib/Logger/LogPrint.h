@@ -0,0 +1,30 @@
+#pragma once
+
+#ifdef ARDUINO
+
+#include <Print.h>
+
+#include "Logger.h"
+
+/**
+ * Turns what is printed to it into log records, one per line, so code
+ * written against Print can log without waiting for the UART
+ */
+class LogPrint : public Print {
+  private:
+    uint8_t _level;
+    char    _line[LOG_TEXT_SIZE];
+    size_t  _length = 0;
+
+  public:
+    LogPrint(uint8_t level);
+
+    size_t write(uint8_t c) override;
+
+    /**
+     * Logs what is left of the current line
+     */
+    void flush() override;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "Logger.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Hal.h"
+
+static LogRing logRing;
+static std::atomic<uint8_t> runtimeLevel{LOG_LEVEL_INFO};
+static LogWakeupCb logWakeup = nullptr;
+
+LogRing::LogRing() {
+  for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) {
+    this->_slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+// A slot is free for the writer at position pos while its sequence is pos and
+// readable once the writer bumps it to pos + 1. The reader hands it back for
+// the next lap by setting it to pos + LOG_RING_SLOTS.
+bool LogRing::push(uint8_t level, uint32_t ms, const char *format, va_list args) {
+  uint32_t pos = this->_writePos.load(std::memory_order_relaxed);
+  Slot *slot;
+
+  while (true) {
+    slot = &this->_slots[pos & (LOG_RING_SLOTS - 1)];
+    int32_t lag = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+
+    if (lag == 0) {
+      if (this->_writePos.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (lag < 0) {
+      // the reader is a whole lap behind
+      this->_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = this->_writePos.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->record.ms    = ms;
+  slot->record.level = level;
+  vsnprintf(slot->record.text, LOG_TEXT_SIZE, format, args);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  return true;
+}
+
+bool LogRing::pop(LogRecord &out) {
+  uint32_t pos = this->_readPos.load(std::memory_order_relaxed);
+  Slot &slot = this->_slots[pos & (LOG_RING_SLOTS - 1)];
+
+  // an unfinished write holds up the ones behind it until it is published
+  if (slot.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+
+  out = slot.record;
+  slot.sequence.store(pos + LOG_RING_SLOTS, std::memory_order_release);
+  this->_readPos.store(pos + 1, std::memory_order_relaxed);
+
+  return true;
+}
+
+bool LogRing::pending() const {
+  return this->_writePos.load(std::memory_order_relaxed) !=
+         this->_readPos.load(std::memory_order_relaxed);
+}
+
+uint32_t LogRing::dropped() const {
+  return this->_dropped.load(std::memory_order_relaxed);
+}
+
+void logSetLevel(uint8_t level) {
+  runtimeLevel.store(level, std::memory_order_relaxed);
+}
+
+uint8_t logLevel(void) {
+  return runtimeLevel.load(std::memory_order_relaxed);
+}
+
+void logSetWakeup(LogWakeupCb wakeup) {
+  logWakeup = wakeup;
+}
+
+bool logWrite(uint8_t level, const char *format, ...) {
+  if (level > logLevel()) return false;
+
+  va_list args;
+  va_start(args, format);
+  bool pushed = logRing.push(level, halMillis(), format, args);
+  va_end(args);
+
+  if (pushed && logWakeup) logWakeup();
+
+  return pushed;
+}
+
+bool logRead(LogRecord &out) {
+  return logRing.pop(out);
+}
+
+bool logPending(void) {
+  return logRing.pending();
+}
+
+uint32_t logDropped(void) {
+  return logRing.dropped();
+}
+
+size_t logFormat(const LogRecord &record, char *out, size_t size) {
+  static const char LEVEL_LETTERS[] = "-EWID";
+  char letter = record.level <= LOG_LEVEL_DEBUG ? LEVEL_LETTERS[record.level] : '?';
+  int length = snprintf(out, size, "[%8u] %c %s", (unsigned)record.ms, letter,
+                        record.text);
+
+  if (length < 0) return 0;
+  return (size_t)length < size ? (size_t)length : size - 1;
+}
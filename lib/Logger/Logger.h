@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// calls above this level are compiled out, arguments included. Release builds
+// can drop the debug ones with -DLOG_COMPILE_LEVEL=3
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// a power of two, records that don't fit are dropped rather than waited for
+#define LOG_RING_SLOTS 32
+// longer messages are cut
+#define LOG_TEXT_SIZE 96
+// "[12345678] W " in front of the text
+#define LOG_PREFIX_SIZE 13
+
+struct LogRecord {
+  uint32_t ms;
+  uint8_t  level;
+  char     text[LOG_TEXT_SIZE];
+};
+
+/**
+ * Bounded queue of log records any number of tasks can write to without
+ * locking, read by a single one. A writer claims a slot with a single
+ * compare-and-swap and formats straight into it, a full ring drops the record.
+ */
+class LogRing {
+  private:
+    struct Slot {
+      std::atomic<uint32_t> sequence;
+      LogRecord             record;
+    };
+
+    Slot                  _slots[LOG_RING_SLOTS];
+    std::atomic<uint32_t> _writePos{0};
+    std::atomic<uint32_t> _readPos{0};
+    std::atomic<uint32_t> _dropped{0};
+
+  public:
+    LogRing();
+
+    /**
+     * @return false when the ring was full and the record dropped
+     */
+    bool push(uint8_t level, uint32_t ms, const char *format, va_list args);
+
+    /**
+     * Reader side, only one task may call it
+     *
+     * @return false when the ring is empty
+     */
+    bool pop(LogRecord &out);
+
+    /**
+     * @return true while records are written or waiting to be read
+     */
+    bool pending() const;
+
+    /**
+     * @return records dropped so far because the ring was full
+     */
+    uint32_t dropped() const;
+};
+
+typedef void (*LogWakeupCb)(void);
+
+/**
+ * Records above level are skipped at runtime
+ */
+void logSetLevel(uint8_t level);
+uint8_t logLevel(void);
+
+/**
+ * Called after every record that made it into the ring, e.g. to wake up the
+ * task draining it. Must not log itself.
+ */
+void logSetWakeup(LogWakeupCb wakeup);
+
+/**
+ * Formats a record into the shared ring, never blocks. Use the LOG_* macros,
+ * they skip the call below the compile time and runtime levels.
+ *
+ * @return false when the record was skipped or dropped
+ */
+bool logWrite(uint8_t level, const char *format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Takes the oldest record out of the shared ring, for the draining task only
+ */
+bool logRead(LogRecord &out);
+
+bool logPending(void);
+uint32_t logDropped(void);
+
+/**
+ * Writes record as `[      ms] L text` without a line break into out
+ *
+ * @return length written, cut to fit size
+ */
+size_t logFormat(const LogRecord &record, char *out, size_t size);
+
+#define LOG_AT(level, ...)                                   \
+  do {                                                       \
+    if ((level) <= logLevel()) logWrite(level, __VA_ARGS__); \
+  } while (0)
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_COMPILE_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
@@ -111,13 +111,17 @@ bool NTPClient::forceUpdate() {
     timeout++;
   } while (cb == 0);
 
-  this->_lastUpdate = millis() - (10 * (timeout + 1)); // Account for delay in reading the time
-
   unsigned long highWord = word(this->_packetBuffer[40], this->_packetBuffer[41]);
   unsigned long lowWord = word(this->_packetBuffer[42], this->_packetBuffer[43]);
   // combine the four bytes (two words) into a long integer
   // this is NTP time (seconds since Jan 1 1900):
   unsigned long secsSince1900 = highWord << 16 | lowWord;
+  // top 16 bits of the 1/2^32 s fraction are plenty for milliseconds
+  unsigned long fractionMs = ((unsigned long)word(this->_packetBuffer[44], this->_packetBuffer[45]) * 1000) >> 16;
+
+  // Account for delay in reading the time, and move the reference back to the
+  // start of the server's second so whole seconds tick at the right moment
+  this->_lastUpdate = millis() - (10 * (timeout + 1)) - fractionMs;
 
   this->_currentEpoc = secsSince1900 - SEVENZYYEARS;
 
@@ -134,13 +138,25 @@ bool NTPClient::update() {
 }
 
 unsigned long NTPClient::getEpochTime() {
-  return this->_timeOffset + // User offset
-         this->_currentEpoc + // Epoc returned by the NTP server
-         ((millis() - this->_lastUpdate) / 1000); // Time since last update
+  unsigned long utc = this->getUTCEpochTime();
+
+  return utc + (this->_timeZone ? this->_timeZone->offsetAt(utc) : this->_timeOffset);
+}
+
+unsigned long NTPClient::getUTCEpochTime() {
+  return this->_currentEpoc + ((millis() - this->_lastUpdate) / 1000);
+}
+
+unsigned long NTPClient::msUntilNextSecond() {
+  return 1000 - (millis() - this->_lastUpdate) % 1000;
+}
+
+unsigned long NTPClient::getLastUpdate() {
+  return this->_lastUpdate;
 }
 
 int NTPClient::getDay() {
-  return (((this->getEpochTime()  / 86400L) + 4 ) % 7); //0 is Sunday
+  return dayOfWeek(this->getEpochTime()); //0 is Sunday
 }
 int NTPClient::getHours() {
   return ((this->getEpochTime()  % 86400L) / 3600);
@@ -153,44 +169,30 @@ int NTPClient::getSeconds() {
 }
 
 String NTPClient::getFormattedTime(unsigned long secs) {
-  unsigned long rawTime = secs ? secs : this->getEpochTime();
-  unsigned long hours = (rawTime % 86400L) / 3600;
-  String hoursStr = hours < 10 ? "0" + String(hours) : String(hours);
-
-  unsigned long minutes = (rawTime % 3600) / 60;
-  String minuteStr = minutes < 10 ? "0" + String(minutes) : String(minutes);
+  char time[TIME_FORMAT_TIME_SIZE];
+  formatTime(secs ? secs : this->getEpochTime(), time);
 
-  unsigned long seconds = rawTime % 60;
-  String secondStr = seconds < 10 ? "0" + String(seconds) : String(seconds);
-
-  return hoursStr + ":" + minuteStr + ":" + secondStr;
+  return String(time);
 }
 
-// Based on https://github.com/PaulStoffregen/Time/blob/master/Time.cpp
-// currently assumes UTC timezone, instead of using this->_timeOffset
+// a secs argument is taken to be in the current offset
 String NTPClient::getFormattedDate(unsigned long secs) {
-  unsigned long rawTime = (secs ? secs : this->getEpochTime()) / 86400L;  // in days
-  unsigned long days = 0, year = 1970;
-  uint8_t month;
-  static const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31};
-
-  while((days += (LEAP_YEAR(year) ? 366 : 365)) <= rawTime)
-    year++;
-  rawTime -= days - (LEAP_YEAR(year) ? 366 : 365); // now it is days in this year, starting at 0
-  days=0;
-  for (month=0; month<12; month++) {
-    uint8_t monthLength;
-    if (month==1) { // february
-      monthLength = LEAP_YEAR(year) ? 29 : 28;
-    } else {
-      monthLength = monthDays[month];
-    }
-    if (rawTime < monthLength) break;
-    rawTime -= monthLength;
-  }
-  String monthStr = ++month < 10 ? "0" + String(month) : String(month); // jan is month 1  
-  String dayStr = ++rawTime < 10 ? "0" + String(rawTime) : String(rawTime); // day of month  
-  return String(year) + "-" + monthStr + "-" + dayStr + "T" + this->getFormattedTime(secs ? secs : 0) + "Z";
+  unsigned long rawTime = secs ? secs : this->getEpochTime();
+  long offset = this->getTimeOffset();
+  unsigned long offsetMinutes = (offset < 0 ? -offset : offset) / 60;
+  // yyyy-mm-ddThh:mm:ss+hh:mm
+  char date[TIME_FORMAT_DATE_SIZE + TIME_FORMAT_TIME_SIZE + 6];
+  char* zone = date + TIME_FORMAT_DATE_SIZE + TIME_FORMAT_TIME_SIZE - 1;
+
+  formatDate(rawTime, date);
+  date[TIME_FORMAT_DATE_SIZE - 1] = 'T';
+  formatTime(rawTime, date + TIME_FORMAT_DATE_SIZE);
+  // hh:mm:ss of the offset, cut before the seconds
+  formatTime(offsetMinutes * 60, zone + 1);
+  zone[0] = offset < 0 ? '-' : '+';
+  zone[6] = '\0';
+
+  return String(date);
 }
 
 void NTPClient::end() {
@@ -203,6 +205,14 @@ void NTPClient::setTimeOffset(int timeOffset) {
   this->_timeOffset     = timeOffset;
 }
 
+void NTPClient::setTimeZone(TimeZone* timeZone) {
+  this->_timeZone = timeZone;
+}
+
+long NTPClient::getTimeOffset() {
+  return this->_timeZone ? this->_timeZone->offsetAt(this->getUTCEpochTime()) : this->_timeOffset;
+}
+
 void NTPClient::setUpdateInterval(unsigned long updateInterval) {
   this->_updateInterval = updateInterval;
 }
@@ -4,10 +4,12 @@
 
 #include <Udp.h>
 
+#include "TimeFormat.h"
+#include "TimeZone.h"
+
 #define SEVENZYYEARS 2208988800UL
 #define NTP_PACKET_SIZE 48
 #define NTP_DEFAULT_LOCAL_PORT 1337
-#define LEAP_YEAR(Y)     ( (Y>0) && !(Y%4) && ( (Y%100) || !(Y%400) ) )
 
 
 class NTPClient {
@@ -18,6 +20,7 @@ class NTPClient {
     const char*   _poolServerName = "pool.ntp.org"; // Default time server
     int           _port           = NTP_DEFAULT_LOCAL_PORT;
     int           _timeOffset     = 0;
+    TimeZone*     _timeZone       = nullptr;
 
     unsigned long _updateInterval = 60000;  // In ms
 
@@ -71,6 +74,17 @@ class NTPClient {
      */
     void setTimeOffset(int timeOffset);
 
+    /**
+     * Follows the rules of timeZone, including daylight saving time, instead
+     * of the fixed time offset. nullptr goes back to the fixed offset
+     */
+    void setTimeZone(TimeZone* timeZone);
+
+    /**
+     * @return seconds getEpochTime() is currently ahead of UTC
+     */
+    long getTimeOffset();
+
     /**
      * Set the update interval to another frequency. E.g. useful when the
      * timeOffset should not be set in the constructor
@@ -86,7 +100,23 @@ class NTPClient {
      * @return time in seconds since Jan. 1, 1970
      */
     unsigned long getEpochTime();
+
+    /**
+     * @return time in seconds since Jan. 1, 1970 UTC, without the time offset
+     */
+    unsigned long getUTCEpochTime();
   
+    /**
+     * @return milliseconds until getEpochTime() next increments, 1 to 1000
+     */
+    unsigned long msUntilNextSecond();
+
+    /**
+     * @return millis() when the second of the last update began, changes with
+     * every successful update and is 0 before the first
+     */
+    unsigned long getLastUpdate();
+
     /**
     * @return secs argument (or 0 for current date) formatted to ISO 8601
     * like `2004-02-12T15:19:21+00:00`
@@ -0,0 +1,73 @@
+#include "PowerLedger.h"
+
+static const char *STATE_NAMES[POWER_STATE_COUNT] = {"cpu", "display", "network",
+                                                     "idle"};
+
+void PowerLedger::reset(uint64_t nowUs) {
+  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++) {
+    this->_timeUs[i] = 0;
+    this->_entries[i] = 0;
+  }
+
+  this->_since = nowUs;
+  this->_start = nowUs;
+}
+
+void PowerLedger::update(uint64_t nowUs) {
+  uint8_t next = POWER_STATE_IDLE;
+  for (uint8_t i = 0; i < POWER_ACTIVITY_COUNT; i++) {
+    if (this->_holds[i] > 0) {
+      next = i;
+      break;
+    }
+  }
+
+  if (next == this->_state) return;
+
+  this->_timeUs[this->_state] += nowUs - this->_since;
+  this->_since = nowUs;
+  this->_state = next;
+  this->_entries[next]++;
+}
+
+void PowerLedger::begin(uint8_t activity, uint64_t nowUs) {
+  if (activity >= POWER_ACTIVITY_COUNT) return;
+
+  this->_holds[activity]++;
+  this->update(nowUs);
+}
+
+void PowerLedger::end(uint8_t activity, uint64_t nowUs) {
+  if (activity >= POWER_ACTIVITY_COUNT || this->_holds[activity] == 0) return;
+
+  this->_holds[activity]--;
+  this->update(nowUs);
+}
+
+uint8_t PowerLedger::state() const {
+  return this->_state;
+}
+
+uint64_t PowerLedger::timeIn(uint8_t state, uint64_t nowUs) const {
+  if (state >= POWER_STATE_COUNT) return 0;
+
+  uint64_t time = this->_timeUs[state];
+  if (state == this->_state) time += nowUs - this->_since;
+
+  return time;
+}
+
+uint16_t PowerLedger::basisPoints(uint8_t state, uint64_t nowUs) const {
+  uint64_t total = nowUs - this->_start;
+  if (total == 0) return 0;
+
+  return (uint16_t)(this->timeIn(state, nowUs) * 10000 / total);
+}
+
+uint32_t PowerLedger::entries(uint8_t state) const {
+  return state < POWER_STATE_COUNT ? this->_entries[state] : 0;
+}
+
+const char *powerStateName(uint8_t state) {
+  return state < POWER_STATE_COUNT ? STATE_NAMES[state] : "";
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * What keeps the chip awake, in the order the ledger attributes time: while
+ * the CPU works, waiting for the display or the network doesn't count.
+ */
+enum PowerActivity : uint8_t {
+  POWER_ACTIVITY_CPU,
+  POWER_ACTIVITY_DISPLAY,
+  POWER_ACTIVITY_NETWORK,
+  POWER_ACTIVITY_COUNT
+};
+
+// states are the activities plus idle, when the chip is free to light sleep
+#define POWER_STATE_IDLE POWER_ACTIVITY_COUNT
+#define POWER_STATE_COUNT (POWER_ACTIVITY_COUNT + 1)
+
+/**
+ * Per-state time accounting. Every begin() is matched by an end() of the same
+ * activity; activities nest and overlap freely, the state at any time is the
+ * first one in PowerActivity order with work in progress, or idle.
+ *
+ * Times are in microseconds and passed in by the caller, the ledger itself
+ * is not thread safe.
+ */
+class PowerLedger {
+  private:
+    uint16_t _holds[POWER_ACTIVITY_COUNT] = {};
+    uint64_t _timeUs[POWER_STATE_COUNT]   = {};
+    uint32_t _entries[POWER_STATE_COUNT]  = {};
+    uint8_t  _state                       = POWER_STATE_IDLE;
+    uint64_t _since                       = 0;
+    uint64_t _start                       = 0;
+
+    void update(uint64_t nowUs);
+
+  public:
+    /**
+     * Starts accounting from nowUs, idle
+     */
+    void reset(uint64_t nowUs);
+
+    void begin(uint8_t activity, uint64_t nowUs);
+    void end(uint8_t activity, uint64_t nowUs);
+
+    uint8_t state() const;
+
+    /**
+     * @return time spent in state up to nowUs, the current stretch included
+     */
+    uint64_t timeIn(uint8_t state, uint64_t nowUs) const;
+
+    /**
+     * @return share of the time since reset() spent in state, in 0.01%
+     */
+    uint16_t basisPoints(uint8_t state, uint64_t nowUs) const;
+
+    /**
+     * @return how often state was entered, for cpu the number of wakeups
+     */
+    uint32_t entries(uint8_t state) const;
+};
+
+/**
+ * @return "cpu", "display", "network" or "idle"
+ */
+const char *powerStateName(uint8_t state);
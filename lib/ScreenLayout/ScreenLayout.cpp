@@ -0,0 +1,14 @@
+#include "ScreenLayout.h"
+
+void drawLayoutRules(Framebuffer &fb, const LayoutCommand *commands,
+                     size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const LayoutCommand &command = commands[i];
+
+    if (command.kind == LAYOUT_HRULE) {
+      fb.hline(command.x, command.y, command.w);
+    } else if (command.kind == LAYOUT_VRULE) {
+      fb.vline(command.x, command.y, command.h);
+    }
+  }
+}
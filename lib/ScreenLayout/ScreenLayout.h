@@ -0,0 +1,257 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Framebuffer.h"
+
+// split points a row can have, giving it one more column than that
+#define LAYOUT_MAX_SPLITS 3
+// column of an item that spans the whole row
+#define LAYOUT_SPAN 0xFF
+
+// line heights of the OLED driver's ArialMT_Plain_10 and ArialMT_Plain_24
+#define LAYOUT_FONT_10_HEIGHT 13
+#define LAYOUT_FONT_24_HEIGHT 28
+
+enum LayoutFont : uint8_t { LAYOUT_FONT_10, LAYOUT_FONT_24 };
+
+// horizontal alignment in the item's column, LAYOUT_MIDDLE can be ORed in to
+// center text vertically in its row instead of putting it at the top
+enum LayoutAlign : uint8_t {
+  LAYOUT_LEFT   = 0,
+  LAYOUT_CENTER = 1,
+  LAYOUT_RIGHT  = 2,
+  LAYOUT_MIDDLE = 4,
+};
+
+enum LayoutKind : uint8_t {
+  // a text anchor: x is the left edge, center or right edge by alignment
+  LAYOUT_TEXT,
+  // a fixed size box, for icons and graphs
+  LAYOUT_BOX,
+  // a 1 px line across the column
+  LAYOUT_HRULE,
+  // a 1 px line down the row
+  LAYOUT_VRULE,
+};
+
+/**
+ * A band of the screen, rows are stacked from the top in the order given.
+ * Splits are x positions dividing the row into columns, 0 ends the list.
+ */
+struct LayoutRow {
+  int16_t height;
+  int16_t splits[LAYOUT_MAX_SPLITS] = {};
+};
+
+struct LayoutPad {
+  int16_t top    = 0;
+  int16_t left   = 0;
+  int16_t right  = 0;
+  int16_t bottom = 0;
+};
+
+/**
+ * One element of a screen, placed in a column of a row. Build them with
+ * layoutText(), layoutBox(), layoutHRule() and layoutVRule().
+ */
+struct LayoutItem {
+  // position of the resolved command in the table, usually a screen's enum
+  uint8_t   id;
+  uint8_t   kind;
+  uint8_t   row;
+  uint8_t   column;
+  uint8_t   align;
+  uint8_t   font;
+  int16_t   w;
+  int16_t   h;
+  LayoutPad pad;
+};
+
+/**
+ * An item resolved to panel coordinates. For text x, y is the anchor to draw
+ * at with align and w x h the column and line it owns, for everything else
+ * the top left corner and size.
+ */
+struct LayoutCommand {
+  uint8_t kind;
+  uint8_t align;
+  uint8_t font;
+  int16_t x;
+  int16_t y;
+  int16_t w;
+  int16_t h;
+};
+
+template <size_t N> struct LayoutTable {
+  LayoutCommand commands[N];
+
+  constexpr const LayoutCommand &operator[](size_t id) const {
+    return this->commands[id];
+  }
+
+  constexpr size_t size() const { return N; }
+};
+
+constexpr LayoutItem layoutText(uint8_t id, uint8_t row, uint8_t font,
+                                uint8_t align, LayoutPad pad = {},
+                                uint8_t column = LAYOUT_SPAN) {
+  return {id, LAYOUT_TEXT, row, column, align, font, 0, 0, pad};
+}
+
+constexpr LayoutItem layoutBox(uint8_t id, uint8_t row, int16_t w, int16_t h,
+                               uint8_t align, LayoutPad pad = {},
+                               uint8_t column = LAYOUT_SPAN) {
+  return {id, LAYOUT_BOX, row, column, align, 0, w, h, pad};
+}
+
+// left and right padding shorten the rule, top moves it down the row
+constexpr LayoutItem layoutHRule(uint8_t id, uint8_t row, LayoutPad pad = {},
+                                 uint8_t column = LAYOUT_SPAN) {
+  return {id, LAYOUT_HRULE, row, column, LAYOUT_LEFT, 0, 0, 1, pad};
+}
+
+// top and bottom padding shorten the rule
+constexpr LayoutItem layoutVRule(uint8_t id, uint8_t row, uint8_t align,
+                                 LayoutPad pad = {},
+                                 uint8_t column = LAYOUT_SPAN) {
+  return {id, LAYOUT_VRULE, row, column, align, 0, 1, 0, pad};
+}
+
+constexpr int16_t layoutFontHeight(uint8_t font) {
+  return font == LAYOUT_FONT_24 ? LAYOUT_FONT_24_HEIGHT : LAYOUT_FONT_10_HEIGHT;
+}
+
+// Not constexpr on purpose: layoutResolve() calls one of these for a broken
+// layout, which stops the compiler with the function's name in the error.
+inline void layoutRowsOverflowPanel(void) {}
+inline void layoutSplitsOutOfOrder(void) {}
+inline void layoutUnknownRow(void) {}
+inline void layoutUnknownColumn(void) {}
+inline void layoutNegativePadding(void) {}
+inline void layoutIdOutOfRange(void) {}
+inline void layoutIdUsedTwice(void) {}
+inline void layoutItemOverflowsColumn(void) {}
+inline void layoutItemOverflowsRow(void) {}
+inline void layoutItemOverflowsPanel(void) {}
+
+/**
+ * Resolves items placed in rows into a table of draw commands indexed by item
+ * id. Meant for constexpr tables only: the layout is worked out by the
+ * compiler and a layout that doesn't fit the panel, or names a row or column
+ * that doesn't exist, doesn't compile.
+ *
+ * Boxes and rules have to fit their row. Text width depends on what is
+ * drawn, so only the line height of text is checked, against the panel
+ * rather than the row: the fonts leave blank rows under the glyphs that may
+ * run into the next row.
+ */
+template <size_t R, size_t N>
+constexpr LayoutTable<N> layoutResolve(const LayoutRow (&rows)[R],
+                                       const LayoutItem (&items)[N]) {
+  LayoutTable<N> table{};
+  int16_t rowTop[R] = {};
+  int16_t top = 0;
+  bool used[N] = {};
+
+  for (size_t r = 0; r < R; r++) {
+    rowTop[r] = top;
+    top += rows[r].height;
+
+    int16_t previous = 0;
+    for (uint8_t s = 0; s < LAYOUT_MAX_SPLITS && rows[r].splits[s] > 0; s++) {
+      if (rows[r].splits[s] <= previous ||
+          rows[r].splits[s] >= FRAMEBUFFER_WIDTH) {
+        layoutSplitsOutOfOrder();
+      }
+      previous = rows[r].splits[s];
+    }
+  }
+  if (top > FRAMEBUFFER_HEIGHT) layoutRowsOverflowPanel();
+
+  for (size_t i = 0; i < N; i++) {
+    const LayoutItem &item = items[i];
+
+    if (item.row >= R) layoutUnknownRow();
+    if (item.id >= N) layoutIdOutOfRange();
+    if (used[item.id]) layoutIdUsedTwice();
+    used[item.id] = true;
+    if (item.pad.top < 0 || item.pad.left < 0 || item.pad.right < 0 ||
+        item.pad.bottom < 0) {
+      layoutNegativePadding();
+    }
+
+    const LayoutRow &row = rows[item.row];
+    int16_t left = 0, right = FRAMEBUFFER_WIDTH;
+    if (item.column != LAYOUT_SPAN) {
+      uint8_t splits = 0;
+      while (splits < LAYOUT_MAX_SPLITS && row.splits[splits] > 0) splits++;
+      if (item.column > splits) layoutUnknownColumn();
+
+      if (item.column > 0) left = row.splits[item.column - 1];
+      if (item.column < splits) right = row.splits[item.column];
+    }
+    left += item.pad.left;
+    right -= item.pad.right;
+
+    int16_t y = rowTop[item.row] + item.pad.top;
+    int16_t height = row.height - item.pad.top - item.pad.bottom;
+    int16_t w = item.w, h = item.h;
+
+    if (item.kind == LAYOUT_TEXT) {
+      w = right - left;
+      h = layoutFontHeight(item.font);
+    } else if (item.kind == LAYOUT_HRULE) {
+      w = right - left;
+    } else if (item.kind == LAYOUT_VRULE) {
+      h = height;
+    }
+
+    int16_t x = left;
+    uint8_t horizontal = item.align & ~LAYOUT_MIDDLE;
+    if (item.kind == LAYOUT_TEXT) {
+      if (horizontal == LAYOUT_CENTER) x = (left + right) / 2;
+      if (horizontal == LAYOUT_RIGHT) x = right - 1;
+      if (item.align & LAYOUT_MIDDLE) y += height / 2;
+    } else {
+      if (horizontal == LAYOUT_CENTER) x = left + (right - left - w) / 2;
+      if (horizontal == LAYOUT_RIGHT) x = right - w;
+      if (item.align & LAYOUT_MIDDLE) y += (height - h) / 2;
+    }
+
+    // boxes and rules stay inside their row, padding included
+    if ((item.kind != LAYOUT_TEXT && h > height) ||
+        (item.kind == LAYOUT_VRULE && height <= 0)) {
+      layoutItemOverflowsRow();
+    }
+    if (w <= 0 || h <= 0 || (item.kind != LAYOUT_TEXT && w > right - left)) {
+      layoutItemOverflowsColumn();
+    }
+
+    // the box text can cover, whichever way it is anchored
+    int16_t boxLeft = item.kind == LAYOUT_TEXT ? left : x;
+    int16_t boxTop = (item.kind == LAYOUT_TEXT && (item.align & LAYOUT_MIDDLE))
+                         ? y - h / 2
+                         : y;
+    if (boxLeft < 0 || boxTop < 0 || boxLeft + w > FRAMEBUFFER_WIDTH ||
+        boxTop + h > FRAMEBUFFER_HEIGHT) {
+      layoutItemOverflowsPanel();
+    }
+
+    table.commands[item.id] = {item.kind, item.align, item.font, x, y, w, h};
+  }
+
+  return table;
+}
+
+/**
+ * Draws the rules of a resolved table, the static lines of a screen
+ */
+void drawLayoutRules(Framebuffer &fb, const LayoutCommand *commands,
+                     size_t count);
+
+template <size_t N>
+void drawLayoutRules(Framebuffer &fb, const LayoutTable<N> &table) {
+  drawLayoutRules(fb, table.commands, N);
+}
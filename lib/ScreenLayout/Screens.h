@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ScreenLayout.h"
+#include "Widgets.h"
+
+// Every screen of the display as rows of items, resolved into draw command
+// tables at compile time. Draw code looks up where things go by item id, e.g.
+// MAIN_SCREEN[MAIN_CLOCK].x, a new screen is a new enum and table here.
+
+// clock, the two sensor rows between rules and the date with the day name
+// behind a rule
+enum MainScreenItem : uint8_t {
+  MAIN_CLOCK,
+  MAIN_STALE_MARKER,
+  MAIN_RULE_TOP,
+  MAIN_READINGS,
+  MAIN_QUOTE,
+  MAIN_SIDE_LEFT,
+  MAIN_SIDE_RIGHT,
+  MAIN_WIFI_ICON,
+  MAIN_RULE_BOTTOM,
+  MAIN_DATE,
+  MAIN_DATE_RULE,
+  MAIN_SCREEN_ITEMS
+};
+
+static constexpr LayoutRow MAIN_ROWS[] = {{25}, {26}, {13, {82}}};
+
+static constexpr LayoutItem MAIN_ITEMS[MAIN_SCREEN_ITEMS] = {
+    layoutText(MAIN_CLOCK, 0, LAYOUT_FONT_24, LAYOUT_CENTER),
+    layoutBox(MAIN_STALE_MARKER, 0, STALE_MARKER_SIZE, STALE_MARKER_SIZE,
+              LAYOUT_LEFT),
+    layoutHRule(MAIN_RULE_TOP, 1, {0, 25, 24}),
+    layoutText(MAIN_READINGS, 1, LAYOUT_FONT_10, LAYOUT_CENTER, {1}),
+    layoutText(MAIN_QUOTE, 1, LAYOUT_FONT_10, LAYOUT_CENTER, {13}),
+    layoutBox(MAIN_SIDE_LEFT, 1, SIDE_LINES_WIDTH, SIDE_LINES_HEIGHT,
+              LAYOUT_LEFT, {3, 10}),
+    layoutBox(MAIN_SIDE_RIGHT, 1, SIDE_LINES_WIDTH, SIDE_LINES_HEIGHT,
+              LAYOUT_RIGHT, {3, 0, 9}),
+    layoutBox(MAIN_WIFI_ICON, 1, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT,
+              LAYOUT_LEFT, {7, 6}),
+    layoutHRule(MAIN_RULE_BOTTOM, 2, {0, 25, 24}),
+    layoutText(MAIN_DATE, 2, LAYOUT_FONT_10, LAYOUT_CENTER),
+    layoutVRule(MAIN_DATE_RULE, 2, LAYOUT_LEFT, {}, 1),
+};
+
+static constexpr auto MAIN_SCREEN = layoutResolve(MAIN_ROWS, MAIN_ITEMS);
+
+// one stock symbol: header, price and a sparkline of the day
+enum StockScreenItem : uint8_t {
+  STOCK_SYMBOL,
+  STOCK_CHANGE,
+  STOCK_PRICE,
+  STOCK_NO_QUOTE,
+  STOCK_SPARKLINE,
+  STOCK_SCREEN_ITEMS
+};
+
+static constexpr LayoutRow STOCK_ROWS[] = {{11}, {29}, {24}};
+
+static constexpr LayoutItem STOCK_ITEMS[STOCK_SCREEN_ITEMS] = {
+    layoutText(STOCK_SYMBOL, 0, LAYOUT_FONT_10, LAYOUT_LEFT),
+    layoutText(STOCK_CHANGE, 0, LAYOUT_FONT_10, LAYOUT_RIGHT),
+    layoutText(STOCK_PRICE, 1, LAYOUT_FONT_24, LAYOUT_CENTER),
+    layoutText(STOCK_NO_QUOTE, 1, LAYOUT_FONT_10, LAYOUT_CENTER, {15}),
+    layoutBox(STOCK_SPARKLINE, 2, FRAMEBUFFER_WIDTH, 24, LAYOUT_LEFT),
+};
+
+static constexpr auto STOCK_SCREEN = layoutResolve(STOCK_ROWS, STOCK_ITEMS);
+
+// the last day of both sensors, a range line over a min/max graph each
+enum HistoryScreenItem : uint8_t {
+  HISTORY_IN_RANGE,
+  HISTORY_IN_AVERAGE,
+  HISTORY_IN_GRAPH,
+  HISTORY_OUT_RANGE,
+  HISTORY_OUT_AVERAGE,
+  HISTORY_OUT_GRAPH,
+  HISTORY_SCREEN_ITEMS
+};
+
+static constexpr LayoutRow HISTORY_ROWS[] = {{31}, {2}, {31}};
+
+static constexpr LayoutItem HISTORY_ITEMS[HISTORY_SCREEN_ITEMS] = {
+    layoutText(HISTORY_IN_RANGE, 0, LAYOUT_FONT_10, LAYOUT_LEFT),
+    layoutText(HISTORY_IN_AVERAGE, 0, LAYOUT_FONT_10, LAYOUT_RIGHT),
+    layoutBox(HISTORY_IN_GRAPH, 0, FRAMEBUFFER_WIDTH, 19, LAYOUT_LEFT, {12}),
+    layoutText(HISTORY_OUT_RANGE, 2, LAYOUT_FONT_10, LAYOUT_LEFT),
+    layoutText(HISTORY_OUT_AVERAGE, 2, LAYOUT_FONT_10, LAYOUT_RIGHT),
+    layoutBox(HISTORY_OUT_GRAPH, 2, FRAMEBUFFER_WIDTH, 19, LAYOUT_LEFT, {12}),
+};
+
+static constexpr auto HISTORY_SCREEN =
+    layoutResolve(HISTORY_ROWS, HISTORY_ITEMS);
+
+// shown until the device is set up: the access point to connect to
+enum SetupScreenItem : uint8_t {
+  SETUP_WIFI_ICON,
+  SETUP_SSID,
+  SETUP_PASSWORD,
+  SETUP_SCREEN_ITEMS
+};
+
+static constexpr LayoutRow SETUP_ROWS[] = {{40}, {10}, {14}};
+
+static constexpr LayoutItem SETUP_ITEMS[SETUP_SCREEN_ITEMS] = {
+    layoutBox(SETUP_WIFI_ICON, 0, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT,
+              LAYOUT_CENTER, {17}),
+    layoutText(SETUP_SSID, 1, LAYOUT_FONT_10, LAYOUT_LEFT, {0, 30}),
+    layoutText(SETUP_PASSWORD, 2, LAYOUT_FONT_10, LAYOUT_LEFT, {0, 30}),
+};
+
+static constexpr auto SETUP_SCREEN = layoutResolve(SETUP_ROWS, SETUP_ITEMS);
+
+// a single line in the middle, with the WiFi icon where the main screen has it
+enum MessageScreenItem : uint8_t {
+  MESSAGE_TEXT,
+  MESSAGE_WIFI_ICON,
+  MESSAGE_SCREEN_ITEMS
+};
+
+static constexpr LayoutRow MESSAGE_ROWS[] = {{FRAMEBUFFER_HEIGHT}};
+
+static constexpr LayoutItem MESSAGE_ITEMS[MESSAGE_SCREEN_ITEMS] = {
+    layoutText(MESSAGE_TEXT, 0, LAYOUT_FONT_10, LAYOUT_CENTER | LAYOUT_MIDDLE),
+    layoutBox(MESSAGE_WIFI_ICON, 0, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT,
+              LAYOUT_LEFT, {32, 6}),
+};
+
+static constexpr auto MESSAGE_SCREEN =
+    layoutResolve(MESSAGE_ROWS, MESSAGE_ITEMS);
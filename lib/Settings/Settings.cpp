@@ -0,0 +1,69 @@
+#include "Settings.h"
+
+#include <string.h>
+
+const char *settingsTemplateValue(const DeviceSettings &settings,
+                                  const char *var) {
+  if (strcmp(var, "IS_SETUP") == 0) {
+    return settings.isSetup ? "checked" : "";
+  } else if (strcmp(var, "WIFI_SSID") == 0) {
+    return settings.wifiSsid;
+  } else if (strcmp(var, "WIFI_PASSWORD") == 0) {
+    return settings.wifiPassword;
+  } else if (strcmp(var, "HA_API") == 0) {
+    return settings.apiUrl;
+  } else if (strcmp(var, "AUTH_TOKEN") == 0) {
+    return settings.authToken;
+  } else if (strcmp(var, "IN_SENSOR_ID") == 0) {
+    return settings.inSensorId;
+  } else if (strcmp(var, "OUT_SENSOR_ID") == 0) {
+    return settings.outSensorId;
+  } else if (strcmp(var, "STOCK_SYMBOLS") == 0) {
+    return settings.stockSymbols;
+  } else if (strcmp(var, "STOCK_API_URL") == 0) {
+    return settings.stockApiUrl;
+  } else if (strcmp(var, "TIME_ZONE") == 0) {
+    return settings.timeZone;
+  } else if (strcmp(var, "WIFI_ICON_STATE") == 0) {
+    return settings.displayWifiIndicator ? "checked" : "";
+  } else if (strcmp(var, "HTTP_REQUEST_INTERVAL") == 0) {
+    return settings.httpRequestInterval;
+  } else if (strcmp(var, "LONG_TOUCH_SELECTED") == 0) {
+    return strcmp(settings.sleepTouchThreshold, "long") == 0 ? "selected" : "";
+  } else if (strcmp(var, "MEDIUM_TOUCH_SELECTED") == 0) {
+    return strcmp(settings.sleepTouchThreshold, "medium") == 0 ? "selected"
+                                                               : "";
+  } else if (strcmp(var, "SHORT_TOUCH_SELECTED") == 0) {
+    return strcmp(settings.sleepTouchThreshold, "short") == 0 ? "selected" : "";
+  } else if (strcmp(var, "HIGH_BRIGHTNESS_SELECTED") == 0) {
+    return strcmp(settings.screenBrightness, "high") == 0 ? "selected" : "";
+  } else if (strcmp(var, "MEDIUM_BRIGHTNESS_SELECTED") == 0) {
+    return strcmp(settings.screenBrightness, "medium") == 0 ? "selected" : "";
+  } else if (strcmp(var, "DIM_BRIGHTNESS_SELECTED") == 0) {
+    return strcmp(settings.screenBrightness, "dim") == 0 ? "selected" : "";
+  } else if (strcmp(var, "INVERT_SCREEN") == 0) {
+    return settings.invertScreen ? "checked" : "";
+  } else if (strcmp(var, "POWER_SAVE") == 0) {
+    return settings.powerSave ? "checked" : "";
+  } else if (strcmp(var, "ENABLE_DEBUG") == 0) {
+    return settings.debugMode ? "checked" : "";
+  } else if (strcmp(var, "SETUP_STATE") == 0) {
+    return settings.isSetup
+               ? "is successfully set up!"
+               : "is not set up! Please fill out the form below to start.";
+  } else if (strcmp(var, "DEBUG_MODE_STYLING") == 0) {
+    return settings.debugMode ? "" : " style=\"display:none\"";
+  }
+
+  return "";
+}
+
+bool settingsSave(const DeviceSettings &settings, SettingsWriteCb write,
+                  void *ctx) {
+  return write(ctx, (const uint8_t *)&settings, sizeof(settings)) ==
+         sizeof(settings);
+}
+
+bool settingsLoad(DeviceSettings &settings, SettingsReadCb read, void *ctx) {
+  return read(ctx, (uint8_t *)&settings, sizeof(settings)) == sizeof(settings);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONFIG_TEXT_MAX_LENGTH 256
+
+static const char defaultHttpRequestInterval[] = "60";
+static const char defaultSleepTouchThreshold[] = "long";
+static const char defaultScreenBrightness[] = "dim";
+
+struct DeviceSettings {
+  // internal flags
+  bool isSetup;
+  // wifi settings
+  char wifiSsid[CONFIG_TEXT_MAX_LENGTH];
+  char wifiPassword[CONFIG_TEXT_MAX_LENGTH];
+  // home assistant rest api settings
+  char apiUrl[CONFIG_TEXT_MAX_LENGTH];
+  char authToken[CONFIG_TEXT_MAX_LENGTH];
+  char inSensorId[CONFIG_TEXT_MAX_LENGTH];
+  char outSensorId[CONFIG_TEXT_MAX_LENGTH];
+  // device settings
+  bool displayWifiIndicator;
+  char httpRequestInterval[CONFIG_TEXT_MAX_LENGTH];
+  char sleepTouchThreshold[CONFIG_TEXT_MAX_LENGTH];
+  char screenBrightness[CONFIG_TEXT_MAX_LENGTH];
+  bool invertScreen;
+  bool debugMode;
+  // stock ticker, appended so older config files still load the fields above
+  char stockSymbols[CONFIG_TEXT_MAX_LENGTH];
+  char stockApiUrl[CONFIG_TEXT_MAX_LENGTH];
+  // frequency scaling, modem and light sleep
+  bool powerSave;
+  // POSIX TZ string, an empty one from an older file means the default zone
+  char timeZone[CONFIG_TEXT_MAX_LENGTH];
+};
+
+typedef size_t (*SettingsWriteCb)(void *ctx, const uint8_t *data, size_t length);
+typedef size_t (*SettingsReadCb)(void *ctx, uint8_t *data, size_t length);
+
+/**
+ * @return value of a %VAR% placeholder in the settings page, empty string for
+ * unknown placeholders
+ */
+const char *settingsTemplateValue(const DeviceSettings &settings,
+                                  const char *var);
+
+/**
+ * Writes the settings through write
+ *
+ * @return true when everything was written
+ */
+bool settingsSave(const DeviceSettings &settings, SettingsWriteCb write,
+                  void *ctx);
+
+/**
+ * Reads settings written by settingsSave() through read
+ *
+ * @return true when a complete record was read
+ */
+bool settingsLoad(DeviceSettings &settings, SettingsReadCb read, void *ctx);
@@ -0,0 +1,186 @@
+#include "StockTicker.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "TimeFormat.h"
+#include "TimeZone.h"
+
+#define SECONDS_PER_DAY 86400UL
+#define MARKET_OPEN_MINUTE (9 * 60 + 30)
+#define MARKET_CLOSE_MINUTE (16 * 60)
+
+// the filter keeps two members, the keys copied out of the response and the
+// filter's own literals take no room of their own
+static StaticJsonDocument<JSON_OBJECT_SIZE(2) + sizeof("c") + sizeof("pc")>
+    quoteDoc;
+static StaticJsonDocument<JSON_OBJECT_SIZE(2)> quoteFilter;
+// the exchanges' local time, see stockQuoteInit()
+static TimeZone marketZone;
+
+void StockTicker::setSymbols(const char *list) {
+  this->_symbolCount = 0;
+  this->_nextFetch = 0;
+
+  while (*list && this->_symbolCount < STOCK_TICKER_MAX_SYMBOLS) {
+    while (*list == ',' || *list == ' ') list++;
+    if (!*list) break;
+
+    Symbol &symbol = this->_symbols[this->_symbolCount++];
+    uint8_t length = 0;
+
+    for (; *list && *list != ',' && *list != ' '; list++) {
+      if (length < STOCK_SYMBOL_SIZE - 1) symbol.name[length++] = *list;
+    }
+
+    symbol.name[length] = '\0';
+    symbol.head = 0;
+    symbol.length = 0;
+    symbol.previousClose = 0;
+  }
+}
+
+uint8_t StockTicker::symbolCount() const {
+  return this->_symbolCount;
+}
+
+const char *StockTicker::symbol(uint8_t index) const {
+  if (index >= this->_symbolCount) return nullptr;
+
+  return this->_symbols[index].name;
+}
+
+uint8_t StockTicker::nextFetch() {
+  if (this->_symbolCount == 0) return 0;
+
+  uint8_t index = this->_nextFetch;
+  this->_nextFetch = (index + 1) % this->_symbolCount;
+
+  return index;
+}
+
+void StockTicker::record(uint8_t index, int32_t priceCents,
+                         int32_t previousCloseCents) {
+  if (index >= this->_symbolCount) return;
+
+  Symbol &symbol = this->_symbols[index];
+  symbol.history[symbol.head] = priceCents;
+  symbol.head = (symbol.head + 1) % STOCK_HISTORY_SIZE;
+  if (symbol.length < STOCK_HISTORY_SIZE) symbol.length++;
+  symbol.previousClose = previousCloseCents;
+  this->_updates++;
+}
+
+uint8_t StockTicker::historyLength(uint8_t index) const {
+  if (index >= this->_symbolCount) return 0;
+
+  return this->_symbols[index].length;
+}
+
+int32_t StockTicker::price(uint8_t index, uint8_t age) const {
+  if (index >= this->_symbolCount || age >= this->_symbols[index].length) {
+    return 0;
+  }
+
+  const Symbol &symbol = this->_symbols[index];
+  return symbol.history[(symbol.head + STOCK_HISTORY_SIZE - 1 - age) %
+                        STOCK_HISTORY_SIZE];
+}
+
+uint8_t StockTicker::copyHistory(uint8_t index, int32_t *out) const {
+  uint8_t length = this->historyLength(index);
+
+  for (uint8_t i = 0; i < length; i++) {
+    out[i] = this->price(index, length - 1 - i);
+  }
+
+  return length;
+}
+
+int32_t StockTicker::change(uint8_t index) const {
+  if (this->historyLength(index) == 0) return 0;
+
+  return this->price(index) - this->_symbols[index].previousClose;
+}
+
+int32_t StockTicker::changeBasisPoints(uint8_t index) const {
+  if (this->historyLength(index) == 0 ||
+      this->_symbols[index].previousClose <= 0) {
+    return 0;
+  }
+
+  return (int64_t)this->change(index) * 10000 /
+         this->_symbols[index].previousClose;
+}
+
+uint32_t StockTicker::updates() const {
+  return this->_updates;
+}
+
+void stockFormatCents(int32_t cents, bool sign, char *out, size_t size) {
+  int64_t value = cents;
+  const char *prefix = value < 0 ? "-" : (sign && value > 0 ? "+" : "");
+  if (value < 0) value = -value;
+
+  snprintf(out, size, "%s%ld.%02d", prefix, (long)(value / 100),
+           (int)(value % 100));
+}
+
+bool stockQuoteUrl(const char *urlTemplate, const char *symbol, char *out,
+                   size_t size) {
+  const char *placeholder = strstr(urlTemplate, STOCK_SYMBOL_PLACEHOLDER);
+  size_t prefix = placeholder ? placeholder - urlTemplate : strlen(urlTemplate);
+  const char *suffix =
+      placeholder ? placeholder + strlen(STOCK_SYMBOL_PLACEHOLDER) : "";
+  size_t symbolLength = placeholder ? strlen(symbol) : 0;
+
+  if (prefix + symbolLength + strlen(suffix) + 1 > size) return false;
+
+  memcpy(out, urlTemplate, prefix);
+  memcpy(out + prefix, symbol, symbolLength);
+  strcpy(out + prefix + symbolLength, suffix);
+
+  return true;
+}
+
+bool stockMarketOpen(unsigned long utcSecs) {
+  unsigned long local = utcSecs + marketZone.offsetAt(utcSecs);
+  uint8_t weekday = dayOfWeek(local);
+  unsigned long minute = local % SECONDS_PER_DAY / 60;
+
+  return weekday >= 1 && weekday <= 5 && minute >= MARKET_OPEN_MINUTE &&
+         minute < MARKET_CLOSE_MINUTE;
+}
+
+uint32_t stockFetchIntervalMs(unsigned long utcSecs) {
+  return stockMarketOpen(utcSecs) ? STOCK_FETCH_INTERVAL_MS
+                                  : STOCK_CLOSED_FETCH_INTERVAL_MS;
+}
+
+void stockQuoteInit(void) {
+  quoteFilter["c"] = true;
+  quoteFilter["pc"] = true;
+  marketZone.set(STOCK_MARKET_TIME_ZONE);
+}
+
+DeserializationError stockParseQuote(const uint8_t *json, size_t length,
+                                     int32_t &priceCents,
+                                     int32_t &previousCloseCents) {
+  DeserializationError error = deserializeJson(
+      quoteDoc, json, length, DeserializationOption::Filter(quoteFilter));
+
+  if (error) {
+    return error;
+  }
+
+  // an unknown symbol is answered with zeros rather than an error
+  if (!quoteDoc["c"].is<float>() || quoteDoc["c"].as<float>() <= 0) {
+    return DeserializationError::InvalidInput;
+  }
+
+  priceCents = lroundf(quoteDoc["c"].as<float>() * 100);
+  previousCloseCents = lroundf(quoteDoc["pc"].as<float>() * 100);
+
+  return error;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#define ARDUINOJSON_USE_DOUBLE 0
+#include <ArduinoJson.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STOCK_TICKER_MAX_SYMBOLS 4
+#define STOCK_SYMBOL_SIZE 8
+// one sample per fetch, an hour of trading at the default interval
+#define STOCK_HISTORY_SIZE 60
+#define STOCK_QUOTE_URL_SIZE 256
+
+#define STOCK_FETCH_INTERVAL_MS 60000UL
+// a single fetch keeps the last price current while the market is closed
+#define STOCK_CLOSED_FETCH_INTERVAL_MS (30 * 60000UL)
+// NYSE/Nasdaq trading hours are in US Eastern time
+#define STOCK_MARKET_TIME_ZONE "EST5EDT,M3.2.0,M11.1.0"
+
+// replaced with the symbol in the quote URL template
+static const char STOCK_SYMBOL_PLACEHOLDER[] = "{symbol}";
+
+/**
+ * Recent quotes for a short list of symbols, in a fixed amount of memory.
+ *
+ * Every symbol keeps the last STOCK_HISTORY_SIZE prices in a ring, oldest
+ * overwritten first, plus the previous close the change is measured
+ * against. Prices are in cents.
+ */
+class StockTicker {
+  private:
+    struct Symbol {
+      char    name[STOCK_SYMBOL_SIZE];
+      int32_t history[STOCK_HISTORY_SIZE];
+      uint8_t head;
+      uint8_t length;
+      int32_t previousClose;
+    };
+
+    Symbol  _symbols[STOCK_TICKER_MAX_SYMBOLS];
+    uint8_t  _symbolCount = 0;
+    uint8_t  _nextFetch   = 0;
+    uint32_t _updates     = 0;
+
+  public:
+    /**
+     * Replaces the symbol list with a comma separated one, e.g. "WDAY,AAPL".
+     * Symbols past STOCK_TICKER_MAX_SYMBOLS and characters past
+     * STOCK_SYMBOL_SIZE - 1 are dropped. History is cleared.
+     */
+    void setSymbols(const char *list);
+
+    uint8_t symbolCount() const;
+    const char *symbol(uint8_t index) const;
+
+    /**
+     * @return index of the symbol to fetch next, round robin
+     */
+    uint8_t nextFetch();
+
+    void record(uint8_t index, int32_t priceCents, int32_t previousCloseCents);
+
+    /**
+     * @return prices recorded for the symbol, at most STOCK_HISTORY_SIZE
+     */
+    uint8_t historyLength(uint8_t index) const;
+
+    /**
+     * @param age 0 for the latest price, historyLength() - 1 for the oldest
+     */
+    int32_t price(uint8_t index, uint8_t age = 0) const;
+
+    /**
+     * Copies the history oldest first into out
+     *
+     * @return number of prices copied
+     */
+    uint8_t copyHistory(uint8_t index, int32_t *out) const;
+
+    /**
+     * @return change of the latest price against the previous close, in
+     *         cents and in hundredths of a percent
+     */
+    int32_t change(uint8_t index) const;
+    int32_t changeBasisPoints(uint8_t index) const;
+
+    /**
+     * @return number of record() calls so far, changes whenever any history
+     *         does
+     */
+    uint32_t updates() const;
+};
+
+/**
+ * Formats cents as "123.45" or "-0.05", with a leading '+' for positive
+ * values when sign is set
+ */
+void stockFormatCents(int32_t cents, bool sign, char *out, size_t size);
+
+/**
+ * Fills template with symbol in place of STOCK_SYMBOL_PLACEHOLDER
+ *
+ * @return false when the result does not fit into size
+ */
+bool stockQuoteUrl(const char *urlTemplate, const char *symbol, char *out,
+                   size_t size);
+
+/**
+ * @return true during regular NYSE/Nasdaq trading hours, 9:30 to 16:00 US
+ *         Eastern time on weekdays (holidays are not known)
+ */
+bool stockMarketOpen(unsigned long utcSecs);
+
+/**
+ * @return how long to wait before the next fetch at utcSecs
+ */
+uint32_t stockFetchIntervalMs(unsigned long utcSecs);
+
+/**
+ * Sets up the JSON filter and the market's time zone, call once before
+ * parsing or asking whether the market is open
+ */
+void stockQuoteInit(void);
+
+/**
+ * Reads a quote in the Finnhub /quote format, {"c": price, "pc": previous
+ * close, ...}. Any source that can serve that shape, including a local
+ * stand-in, can be used. A price that isn't above zero is InvalidInput.
+ */
+DeserializationError stockParseQuote(const uint8_t *json, size_t length,
+                                     int32_t &priceCents,
+                                     int32_t &previousCloseCents);
@@ -0,0 +1,71 @@
+#include "TimeFormat.h"
+
+static void writeTwoDigits(char *out, unsigned long value) {
+  out[0] = '0' + value / 10;
+  out[1] = '0' + value % 10;
+}
+
+void formatTime(unsigned long secs, char *out) {
+  writeTwoDigits(out, (secs % 86400L) / 3600);
+  out[2] = ':';
+  writeTwoDigits(out + 3, (secs % 3600) / 60);
+  out[5] = ':';
+  writeTwoDigits(out + 6, secs % 60);
+  out[8] = '\0';
+}
+
+// Based on https://github.com/PaulStoffregen/Time/blob/master/Time.cpp
+void formatDate(unsigned long secs, char *out) {
+  unsigned long rawTime = secs / 86400L;  // in days
+  unsigned long days = 0, year = 1970;
+  uint8_t month;
+  static const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31};
+
+  while((days += (LEAP_YEAR(year) ? 366 : 365)) <= rawTime)
+    year++;
+  rawTime -= days - (LEAP_YEAR(year) ? 366 : 365); // now it is days in this year, starting at 0
+  days=0;
+  for (month=0; month<12; month++) {
+    uint8_t monthLength;
+    if (month==1) { // february
+      monthLength = LEAP_YEAR(year) ? 29 : 28;
+    } else {
+      monthLength = monthDays[month];
+    }
+    if (rawTime < monthLength) break;
+    rawTime -= monthLength;
+  }
+
+  writeTwoDigits(out, year / 100);
+  writeTwoDigits(out + 2, year % 100);
+  out[4] = '-';
+  writeTwoDigits(out + 5, month + 1);   // jan is month 1
+  out[7] = '-';
+  writeTwoDigits(out + 8, rawTime + 1); // day of month
+  out[10] = '\0';
+}
+
+uint8_t dayOfWeek(unsigned long secs) {
+  return ((secs / 86400L) + 4) % 7;
+}
+
+long daysFromCivil(int year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  long era = (year >= 0 ? year : year - 399) / 400;
+  unsigned yearOfEra = (unsigned)(year - era * 400);
+  unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+  return era * 146097 + (long)dayOfEra - 719468;
+}
+
+int yearOfDays(long days) {
+  days += 719468;
+  long era = (days >= 0 ? days : days - 146096) / 146097;
+  unsigned dayOfEra = (unsigned)(days - era * 146097);
+  unsigned yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  // March based year, January and February belong to the next one
+  return (int)(yearOfEra + era * 400) + (dayOfYear >= 306);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// "hh:mm:ss" and "yyyy-mm-dd" including the terminator
+#define TIME_FORMAT_TIME_SIZE 9
+#define TIME_FORMAT_DATE_SIZE 11
+
+#define LEAP_YEAR(Y)     ( (Y>0) && !(Y%4) && ( (Y%100) || !(Y%400) ) )
+
+/**
+ * Writes secs (seconds since Jan. 1, 1970) as `hh:mm:ss` into out
+ */
+void formatTime(unsigned long secs, char *out);
+
+/**
+ * Writes the date of secs (seconds since Jan. 1, 1970) as `yyyy-mm-dd`
+ * into out
+ */
+void formatDate(unsigned long secs, char *out);
+
+/**
+ * @return day of the week of secs, 0 is Sunday
+ */
+uint8_t dayOfWeek(unsigned long secs);
+
+/**
+ * @return days since Jan. 1, 1970 of a proleptic Gregorian date, month
+ * and day are 1 based
+ */
+long daysFromCivil(int year, unsigned month, unsigned day);
+
+/**
+ * @return Gregorian year of days since Jan. 1, 1970
+ */
+int yearOfDays(long days);
@@ -0,0 +1,453 @@
+#include "TimeSeries.h"
+
+#include <string.h>
+
+// block header, followed by the bit stream of every sample after the first
+#define HEADER_MAGIC    0
+#define HEADER_COUNT    2
+#define HEADER_SEQ      4
+#define HEADER_START    8
+#define HEADER_FIRST    12
+#define HEADER_BITS     14
+#define HEADER_SIZE     16
+
+#define BLOCK_MAGIC     0x5354
+#define PAYLOAD_BITS    ((TIME_SERIES_BLOCK_SIZE - HEADER_SIZE) * 8)
+#define NO_WINDOW       0xFF
+
+static uint16_t get16(const uint8_t *p) {
+  uint16_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static uint32_t get32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+/**
+ * Up to 64 bits of one encoded sample, staged so it can be checked against
+ * the room left in the block before anything is written
+ */
+struct Bits {
+  uint64_t value = 0;
+  uint8_t  length = 0;
+
+  void push(uint32_t bits, uint8_t n) {
+    this->value = (this->value << n) | (bits & (uint32_t)((1ULL << n) - 1));
+    this->length += n;
+  }
+};
+
+static void writeBits(uint8_t *payload, uint16_t &pos, uint64_t bits, uint8_t n) {
+  while (n > 0) {
+    uint8_t room = 8 - (pos & 7);
+    uint8_t take = n < room ? n : room;
+    uint8_t chunk = (uint8_t)((bits >> (n - take)) & ((1u << take) - 1));
+
+    // blocks are reused, so a byte is cleared the first time it is touched
+    if ((pos & 7) == 0) payload[pos >> 3] = 0;
+    payload[pos >> 3] |= chunk << (room - take);
+
+    pos += take;
+    n -= take;
+  }
+}
+
+static uint32_t readBits(const uint8_t *payload, uint16_t &pos, uint8_t n) {
+  uint32_t bits = 0;
+
+  while (n > 0) {
+    uint8_t room = 8 - (pos & 7);
+    uint8_t take = n < room ? n : room;
+    uint8_t chunk = (payload[pos >> 3] >> (room - take)) & ((1u << take) - 1);
+
+    bits = (bits << take) | chunk;
+    pos += take;
+    n -= take;
+  }
+
+  return bits;
+}
+
+static int32_t signExtend(uint32_t bits, uint8_t n) {
+  uint32_t sign = 1u << (n - 1);
+  return (int32_t)((bits ^ sign) - sign);
+}
+
+static uint8_t leadingZeros16(uint16_t x) {
+  return (uint8_t)(__builtin_clz((uint32_t)x) - 16);
+}
+
+static uint8_t trailingZeros16(uint16_t x) {
+  return (uint8_t)__builtin_ctz((uint32_t)x);
+}
+
+/**
+ * Timestamp delta of delta with a prefix per range: 0, 10 + 7 bits,
+ * 110 + 9 bits, 1110 + 12 bits, 1111 + 32 bits
+ */
+static void encodeTime(Bits &bits, int32_t dod) {
+  if (dod == 0) {
+    bits.push(0, 1);
+  } else if (dod >= -64 && dod <= 63) {
+    bits.push(0x2, 2);
+    bits.push((uint32_t)dod, 7);
+  } else if (dod >= -256 && dod <= 255) {
+    bits.push(0x6, 3);
+    bits.push((uint32_t)dod, 9);
+  } else if (dod >= -2048 && dod <= 2047) {
+    bits.push(0xE, 4);
+    bits.push((uint32_t)dod, 12);
+  } else {
+    bits.push(0xF, 4);
+    bits.push((uint32_t)dod, 32);
+  }
+}
+
+static int32_t decodeTime(const uint8_t *payload, uint16_t &pos) {
+  if (readBits(payload, pos, 1) == 0) return 0;
+  if (readBits(payload, pos, 1) == 0) return signExtend(readBits(payload, pos, 7), 7);
+  if (readBits(payload, pos, 1) == 0) return signExtend(readBits(payload, pos, 9), 9);
+  if (readBits(payload, pos, 1) == 0) return signExtend(readBits(payload, pos, 12), 12);
+  return (int32_t)readBits(payload, pos, 32);
+}
+
+/**
+ * Value XOR: 0 when unchanged, 10 + the bits inside the previous window,
+ * 11 + 4 bits leading zeros + 4 bits length - 1 + the bits of a new window
+ */
+static void encodeValue(Bits &bits, uint16_t x, uint8_t &leading, uint8_t &trailing) {
+  if (x == 0) {
+    bits.push(0, 1);
+    return;
+  }
+
+  uint8_t lead = leadingZeros16(x);
+  uint8_t trail = trailingZeros16(x);
+
+  if (leading != NO_WINDOW && lead >= leading && trail >= trailing) {
+    bits.push(0x2, 2);
+    bits.push(x >> trailing, 16 - leading - trailing);
+    return;
+  }
+
+  uint8_t length = 16 - lead - trail;
+  bits.push(0x3, 2);
+  bits.push(lead, 4);
+  bits.push(length - 1, 4);
+  bits.push(x >> trail, length);
+
+  leading = lead;
+  trailing = trail;
+}
+
+static uint16_t decodeValue(const uint8_t *payload, uint16_t &pos, uint8_t &leading, uint8_t &trailing) {
+  if (readBits(payload, pos, 1) == 0) return 0;
+
+  if (readBits(payload, pos, 1) == 1) {
+    leading = (uint8_t)readBits(payload, pos, 4);
+    trailing = 16 - leading - ((uint8_t)readBits(payload, pos, 4) + 1);
+  }
+
+  return (uint16_t)(readBits(payload, pos, 16 - leading - trailing) << trailing);
+}
+
+/**
+ * Calls visit for every sample of block in [from, to)
+ *
+ * @return false once the block reached to, so later blocks can be skipped
+ */
+typedef void (*SampleVisitor)(void *ctx, uint32_t time, int16_t value);
+
+static bool decodeBlock(const uint8_t *block, uint32_t from, uint32_t to,
+                        SampleVisitor visit, void *ctx) {
+  if (get16(block + HEADER_MAGIC) != BLOCK_MAGIC) return true;
+
+  const uint8_t *payload = block + HEADER_SIZE;
+  uint16_t count = get16(block + HEADER_COUNT);
+  uint32_t time = get32(block + HEADER_START);
+  uint16_t value = get16(block + HEADER_FIRST);
+  int32_t delta = 0;
+  uint8_t leading = NO_WINDOW;
+  uint8_t trailing = 0;
+  uint16_t pos = 0;
+
+  for (uint16_t i = 0; i < count; i++) {
+    if (i > 0) {
+      delta += decodeTime(payload, pos);
+      time += delta;
+      value ^= decodeValue(payload, pos, leading, trailing);
+    }
+
+    if (time >= to) return false;
+    if (time >= from) visit(ctx, time, (int16_t)value);
+  }
+
+  return true;
+}
+
+static void keepLastTime(void *ctx, uint32_t time, int16_t value) {
+  (void)value;
+  *(uint32_t *)ctx = time;
+}
+
+/**
+ * Sets first and last to the block's sample times, last < first when it has
+ * none
+ */
+static void blockRange(const uint8_t *block, uint32_t &first, uint32_t &last) {
+  first = 1;
+  last = 0;
+
+  if (get16(block + HEADER_MAGIC) != BLOCK_MAGIC || get16(block + HEADER_COUNT) == 0) return;
+
+  first = get32(block + HEADER_START);
+  last = first;
+  decodeBlock(block, first, UINT32_MAX, keepLastTime, &last);
+}
+
+TimeSeries::TimeSeries(uint8_t *storage, size_t size) {
+  size_t blocks = size / TIME_SERIES_BLOCK_SIZE;
+
+  this->_blocks = storage;
+  this->_blockCount = blocks > 255 ? 255 : (uint8_t)blocks;
+  this->_encoder = Encoder();
+}
+
+void TimeSeries::setSpill(TimeSeriesSpill *spill) {
+  this->_spill = spill;
+  this->_nextSlot = 0;
+
+  if (spill == nullptr || spill->slotCount() == 0) {
+    this->_spill = nullptr;
+    return;
+  }
+
+  this->_slots = spill->slotCount();
+  if (this->_slots > TIME_SERIES_MAX_SPILL_SLOTS) this->_slots = TIME_SERIES_MAX_SPILL_SLOTS;
+
+  uint8_t block[TIME_SERIES_BLOCK_SIZE];
+  uint32_t newest = 0;
+
+  for (uint16_t slot = 0; slot < this->_slots; slot++) {
+    this->_slotFirst[slot] = 1;
+    this->_slotLast[slot] = 0;
+
+    if (!spill->readSlot(slot, block) || get16(block + HEADER_MAGIC) != BLOCK_MAGIC) continue;
+
+    blockRange(block, this->_slotFirst[slot], this->_slotLast[slot]);
+
+    uint32_t seq = get32(block + HEADER_SEQ);
+    if (seq >= newest) {
+      newest = seq;
+      this->_nextSlot = (slot + 1) % this->_slots;
+    }
+  }
+
+  if (newest >= this->_seq) this->_seq = newest + 1;
+}
+
+uint8_t *TimeSeries::block(uint8_t age) {
+  return this->_blocks + ((this->_first + age) % this->_blockCount) * TIME_SERIES_BLOCK_SIZE;
+}
+
+void TimeSeries::spillBlock(const uint8_t *block) {
+  uint16_t slot = this->_nextSlot;
+
+  if (this->_spill->writeSlot(slot, block)) {
+    blockRange(block, this->_slotFirst[slot], this->_slotLast[slot]);
+  } else {
+    // whatever the slot holds now, queries read it
+    this->_slotFirst[slot] = 0;
+    this->_slotLast[slot] = UINT32_MAX;
+  }
+
+  this->_nextSlot = (slot + 1) % this->_slots;
+}
+
+uint8_t *TimeSeries::openBlock(uint32_t time, int16_t value) {
+  if (this->_used == this->_blockCount) {
+    if (this->_spill != nullptr) this->spillBlock(this->block(0));
+
+    this->_first = (this->_first + 1) % this->_blockCount;
+    this->_used--;
+  }
+
+  uint8_t *b = this->block(this->_used++);
+  put16(b + HEADER_MAGIC, BLOCK_MAGIC);
+  put16(b + HEADER_COUNT, 1);
+  put32(b + HEADER_SEQ, this->_seq++);
+  put32(b + HEADER_START, time);
+  put16(b + HEADER_FIRST, (uint16_t)value);
+  put16(b + HEADER_BITS, 0);
+
+  this->_encoder.time = time;
+  this->_encoder.delta = 0;
+  this->_encoder.value = (uint16_t)value;
+  this->_encoder.leading = NO_WINDOW;
+  this->_encoder.trailing = 0;
+  this->_encoder.bitPos = 0;
+
+  return b;
+}
+
+void TimeSeries::flush() {
+  if (this->_spill == nullptr) return;
+
+  for (uint8_t age = 0; age < this->_used; age++) {
+    this->spillBlock(this->block(age));
+  }
+
+  this->_first = 0;
+  this->_used = 0;
+}
+
+bool TimeSeries::append(uint32_t time, int16_t value) {
+  if (this->_blockCount == 0) return false;
+  if (this->_used > 0 && time < this->_encoder.time) return false;
+
+  if (this->_used == 0) {
+    this->openBlock(time, value);
+    this->_samples++;
+    return true;
+  }
+
+  Encoder &enc = this->_encoder;
+  int32_t delta = (int32_t)(time - enc.time);
+  uint8_t leading = enc.leading;
+  uint8_t trailing = enc.trailing;
+  Bits bits;
+
+  encodeTime(bits, delta - enc.delta);
+  encodeValue(bits, (uint16_t)value ^ enc.value, leading, trailing);
+
+  if (enc.bitPos + bits.length > PAYLOAD_BITS) {
+    this->openBlock(time, value);
+    this->_samples++;
+    return true;
+  }
+
+  uint8_t *b = this->block(this->_used - 1);
+  writeBits(b + HEADER_SIZE, enc.bitPos, bits.value, bits.length);
+  put16(b + HEADER_COUNT, get16(b + HEADER_COUNT) + 1);
+  put16(b + HEADER_BITS, enc.bitPos);
+
+  enc.time = time;
+  enc.delta = delta;
+  enc.value = (uint16_t)value;
+  enc.leading = leading;
+  enc.trailing = trailing;
+
+  this->_samples++;
+  return true;
+}
+
+uint32_t TimeSeries::samples() const {
+  return this->_samples;
+}
+
+size_t TimeSeries::bytesUsed() const {
+  if (this->_used == 0) return 0;
+
+  return (size_t)(this->_used - 1) * TIME_SERIES_BLOCK_SIZE + HEADER_SIZE + (this->_encoder.bitPos + 7) / 8;
+}
+
+void TimeSeries::forEach(uint32_t from, uint32_t to, Visitor visit, void *ctx) {
+  if (from >= to) return;
+
+  if (this->_spill != nullptr) {
+    uint8_t block[TIME_SERIES_BLOCK_SIZE];
+
+    // the slot written next holds the oldest block
+    for (uint16_t i = 0; i < this->_slots; i++) {
+      uint16_t slot = (this->_nextSlot + i) % this->_slots;
+      if (this->_slotLast[slot] < this->_slotFirst[slot]) continue;
+      if (this->_slotFirst[slot] >= to) return;
+      if (this->_slotLast[slot] < from) continue;
+      if (!this->_spill->readSlot(slot, block)) continue;
+      if (!decodeBlock(block, from, to, visit, ctx)) return;
+    }
+  }
+
+  for (uint8_t age = 0; age < this->_used; age++) {
+    // a block is over before from when the next one starts at or before it
+    if (age + 1 < this->_used && get32(this->block(age + 1) + HEADER_START) <= from) continue;
+    if (!decodeBlock(this->block(age), from, to, visit, ctx)) return;
+  }
+}
+
+struct StatsAccumulator {
+  TimeSeriesStats stats;
+  int64_t sum;
+};
+
+static void accumulateStats(void *ctx, uint32_t time, int16_t value) {
+  (void)time;
+  StatsAccumulator &acc = *(StatsAccumulator *)ctx;
+
+  if (acc.stats.count == 0 || value < acc.stats.min) acc.stats.min = value;
+  if (acc.stats.count == 0 || value > acc.stats.max) acc.stats.max = value;
+  acc.sum += value;
+  acc.stats.count++;
+}
+
+bool TimeSeries::stats(uint32_t from, uint32_t to, TimeSeriesStats &out) {
+  StatsAccumulator acc;
+  acc.stats = TimeSeriesStats();
+  acc.sum = 0;
+
+  this->forEach(from, to, accumulateStats, &acc);
+
+  if (acc.stats.count == 0) return false;
+
+  acc.stats.avg = (int16_t)(acc.sum / (int64_t)acc.stats.count);
+  out = acc.stats;
+  return true;
+}
+
+struct BucketAccumulator {
+  uint32_t from;
+  uint32_t span;
+  uint16_t buckets;
+  int16_t *min;
+  int16_t *max;
+};
+
+static void accumulateBucket(void *ctx, uint32_t time, int16_t value) {
+  BucketAccumulator &acc = *(BucketAccumulator *)ctx;
+  uint16_t i = (uint16_t)((uint64_t)(time - acc.from) * acc.buckets / acc.span);
+
+  if (acc.min[i] == TIME_SERIES_NO_VALUE || value < acc.min[i]) acc.min[i] = value;
+  if (acc.max[i] == TIME_SERIES_NO_VALUE || value > acc.max[i]) acc.max[i] = value;
+}
+
+uint16_t TimeSeries::downsample(uint32_t from, uint32_t to, int16_t *min, int16_t *max,
+                                uint16_t buckets) {
+  for (uint16_t i = 0; i < buckets; i++) {
+    min[i] = TIME_SERIES_NO_VALUE;
+    max[i] = TIME_SERIES_NO_VALUE;
+  }
+
+  if (buckets == 0 || from >= to) return 0;
+
+  BucketAccumulator acc = { from, to - from, buckets, min, max };
+  this->forEach(from, to, accumulateBucket, &acc);
+
+  uint16_t filled = 0;
+  for (uint16_t i = 0; i < buckets; i++) {
+    if (min[i] != TIME_SERIES_NO_VALUE) filled++;
+  }
+
+  return filled;
+}
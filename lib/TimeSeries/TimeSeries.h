@@ -0,0 +1,138 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIME_SERIES_BLOCK_SIZE 128
+#define TIME_SERIES_NO_VALUE INT16_MIN
+// spill slots whose time range is kept in RAM, slots past it go unused
+#define TIME_SERIES_MAX_SPILL_SLOTS 64
+
+struct TimeSeriesStats {
+  uint32_t count;
+  int16_t  min;
+  int16_t  max;
+  // rounded towards zero
+  int16_t  avg;
+};
+
+/**
+ * Optional second tier for blocks that no longer fit into RAM. Slots are
+ * written strictly round robin, so every one of them wears at the same rate,
+ * and each block carries a sequence number to find the newest after reboot.
+ */
+class TimeSeriesSpill {
+  public:
+    virtual ~TimeSeriesSpill() {}
+
+    virtual uint16_t slotCount() = 0;
+
+    /**
+     * block is TIME_SERIES_BLOCK_SIZE bytes
+     */
+    virtual bool writeSlot(uint16_t slot, const uint8_t *block) = 0;
+    virtual bool readSlot(uint16_t slot, uint8_t *block) = 0;
+};
+
+/**
+ * Compressed history of one fixed-point reading, e.g. a temperature in
+ * tenths of a degree.
+ *
+ * Samples are packed into TIME_SERIES_BLOCK_SIZE byte blocks the way
+ * Gorilla does it: timestamps as the delta of the delta to the previous one
+ * (1 bit for a sample exactly on schedule), values XORed with the previous
+ * one and only the changed bits stored (1 bit for an unchanged reading).
+ * A reading every minute takes a few hundred bytes a day.
+ *
+ * The RAM budget is the caller's buffer, split into blocks. When it is full
+ * the oldest block is handed to the spill, if there is one, and reused.
+ * Queries decode the blocks on the fly, oldest first, including the spilled
+ * ones.
+ */
+class TimeSeries {
+  private:
+    struct Encoder {
+      uint32_t time;
+      int32_t  delta;
+      uint16_t value;
+      // bits of the XOR window in use, leading 0xFF while there is none
+      uint8_t  leading;
+      uint8_t  trailing;
+      uint16_t bitPos;
+    };
+
+    uint8_t         *_blocks;
+    uint8_t          _blockCount;
+    // oldest RAM block and blocks in use, the newest one is being filled
+    uint8_t          _first    = 0;
+    uint8_t          _used     = 0;
+    Encoder          _encoder;
+    uint32_t         _seq      = 1;
+    uint32_t         _samples  = 0;
+
+    TimeSeriesSpill *_spill    = nullptr;
+    uint16_t         _slots    = 0;
+    uint16_t         _nextSlot = 0;
+    // first and last sample time of every slot, last < first when it is empty,
+    // so queries only read the slots they need
+    uint32_t         _slotFirst[TIME_SERIES_MAX_SPILL_SLOTS];
+    uint32_t         _slotLast[TIME_SERIES_MAX_SPILL_SLOTS];
+
+    uint8_t *block(uint8_t age);
+    uint8_t *openBlock(uint32_t time, int16_t value);
+    void spillBlock(const uint8_t *block);
+
+    typedef void (*Visitor)(void *ctx, uint32_t time, int16_t value);
+    void forEach(uint32_t from, uint32_t to, Visitor visit, void *ctx);
+
+  public:
+    /**
+     * @param storage RAM budget, whole blocks of it are used
+     */
+    TimeSeries(uint8_t *storage, size_t size);
+
+    /**
+     * Spills evicted blocks to spill from now on and includes what it
+     * already holds in queries. Continues after the newest block it finds.
+     */
+    void setSpill(TimeSeriesSpill *spill);
+
+    /**
+     * Hands every RAM block, the one being filled too, to the spill and
+     * starts over with an empty RAM budget. Before deep sleep, so nothing is
+     * lost but the blocks' unused bits.
+     */
+    void flush();
+
+    /**
+     * @return false when time is before the newest sample
+     */
+    bool append(uint32_t time, int16_t value);
+
+    /**
+     * @return samples appended since boot, also changes with every append
+     */
+    uint32_t samples() const;
+
+    /**
+     * @return bytes of the RAM budget holding samples
+     */
+    size_t bytesUsed() const;
+
+    /**
+     * Minimum, maximum and average of the samples in [from, to)
+     *
+     * @return false when there are none
+     */
+    bool stats(uint32_t from, uint32_t to, TimeSeriesStats &out);
+
+    /**
+     * Splits [from, to) into buckets of equal length, e.g. one per pixel
+     * column of a graph, and reports the lowest and highest sample in each.
+     * Empty buckets get TIME_SERIES_NO_VALUE.
+     *
+     * @return number of buckets that have samples
+     */
+    uint16_t downsample(uint32_t from, uint32_t to, int16_t *min, int16_t *max,
+                        uint16_t buckets);
+};
@@ -0,0 +1,66 @@
+#ifdef ARDUINO
+
+#include "TimeSeriesFileSpill.h"
+
+#include <string.h>
+
+TimeSeriesFileSpill::TimeSeriesFileSpill(fs::FS &fs, const char *path, uint16_t slots) {
+  this->_fs = &fs;
+  this->_path = path;
+  this->_slots = slots;
+}
+
+bool TimeSeriesFileSpill::begin() {
+  size_t size = (size_t)this->_slots * TIME_SERIES_BLOCK_SIZE;
+
+  if (this->_file) this->_file.close();
+
+  File file = this->_fs->open(this->_path, FILE_READ);
+  bool fits = file && file.size() == size;
+  if (file) file.close();
+
+  if (!fits) {
+    uint8_t erased[TIME_SERIES_BLOCK_SIZE];
+    memset(erased, 0xFF, sizeof(erased));
+
+    file = this->_fs->open(this->_path, FILE_WRITE);
+    if (!file) return false;
+
+    for (uint16_t slot = 0; slot < this->_slots; slot++) {
+      if (file.write(erased, sizeof(erased)) != sizeof(erased)) {
+        file.close();
+        return false;
+      }
+    }
+
+    file.close();
+  }
+
+  // "r+" rewrites in place, FILE_WRITE would truncate the other slots
+  this->_file = this->_fs->open(this->_path, "r+");
+  return (bool)this->_file;
+}
+
+uint16_t TimeSeriesFileSpill::slotCount() {
+  return this->_slots;
+}
+
+bool TimeSeriesFileSpill::writeSlot(uint16_t slot, const uint8_t *block) {
+  if (!this->_file) return false;
+
+  bool ok = this->_file.seek((uint32_t)slot * TIME_SERIES_BLOCK_SIZE) &&
+            this->_file.write(block, TIME_SERIES_BLOCK_SIZE) == TIME_SERIES_BLOCK_SIZE;
+  // on flash before deep sleep or a reset, not only in the file system's cache
+  this->_file.flush();
+
+  return ok;
+}
+
+bool TimeSeriesFileSpill::readSlot(uint16_t slot, uint8_t *block) {
+  if (!this->_file) return false;
+
+  return this->_file.seek((uint32_t)slot * TIME_SERIES_BLOCK_SIZE) &&
+         this->_file.read(block, TIME_SERIES_BLOCK_SIZE) == TIME_SERIES_BLOCK_SIZE;
+}
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#ifdef ARDUINO
+
+#include <FS.h>
+
+#include "TimeSeries.h"
+
+/**
+ * Keeps spilled history blocks in one preallocated file, slot after slot.
+ * The file system levels wear across the chip, the round robin slot order
+ * keeps the file itself from being rewritten in one place.
+ */
+class TimeSeriesFileSpill : public TimeSeriesSpill {
+  private:
+    fs::FS     *_fs;
+    const char *_path;
+    uint16_t    _slots;
+    // open from begin() on, so reading a slot is a seek and a read
+    File        _file;
+
+  public:
+    TimeSeriesFileSpill(fs::FS &fs, const char *path, uint16_t slots);
+
+    /**
+     * Creates the file with every slot erased unless it has the right size
+     * and keeps it open
+     */
+    bool begin();
+
+    uint16_t slotCount() override;
+    bool writeSlot(uint16_t slot, const uint8_t *block) override;
+    bool readSlot(uint16_t slot, uint8_t *block) override;
+};
+
+#endif
@@ -0,0 +1,262 @@
+#include "TimeZone.h"
+
+#include <string.h>
+
+#include "TimeFormat.h"
+
+#define SECONDS_PER_DAY 86400L
+#define DEFAULT_TRANSITION_TIME (2 * 3600L)
+
+static bool isAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static bool parseNumber(const char*& p, long max, long& out) {
+  if (!isDigit(*p)) return false;
+
+  out = 0;
+  while (isDigit(*p)) {
+    out = out * 10 + (*p++ - '0');
+    if (out > max) return false;
+  }
+
+  return true;
+}
+
+// `EET` or quoted like `<+0330>`
+static bool parseName(const char*& p, char* out) {
+  size_t length = 0;
+
+  if (*p == '<') {
+    p++;
+    while (isAlpha(*p) || isDigit(*p) || *p == '+' || *p == '-') {
+      if (length < TIME_ZONE_NAME_SIZE - 1) out[length++] = *p;
+      p++;
+    }
+    if (*p++ != '>' || length == 0) return false;
+  } else {
+    while (isAlpha(*p)) {
+      if (length < TIME_ZONE_NAME_SIZE - 1) out[length] = *p;
+      length++;
+      p++;
+    }
+    if (length < 3) return false;
+    if (length > TIME_ZONE_NAME_SIZE - 1) length = TIME_ZONE_NAME_SIZE - 1;
+  }
+
+  out[length] = '\0';
+  return true;
+}
+
+// [+-]hh[:mm[:ss]]
+static bool parseTime(const char*& p, long maxHours, int32_t& out) {
+  long sign = 1, hours, minutes = 0, seconds = 0;
+
+  if (*p == '+' || *p == '-') sign = *p++ == '-' ? -1 : 1;
+  if (!parseNumber(p, maxHours, hours)) return false;
+  if (*p == ':') {
+    p++;
+    if (!parseNumber(p, 59, minutes)) return false;
+    if (*p == ':') {
+      p++;
+      if (!parseNumber(p, 59, seconds)) return false;
+    }
+  }
+
+  out = (int32_t)(sign * (hours * 3600 + minutes * 60 + seconds));
+  return true;
+}
+
+bool TimeZone::set(const char* posix, uint32_t nearUtc) {
+  char stdName[TIME_ZONE_NAME_SIZE], dstName[TIME_ZONE_NAME_SIZE] = "";
+  int32_t stdOffset, dstOffset = 0;
+  Rule rules[2];
+  const char* p = posix;
+
+  if (p == nullptr || !parseName(p, stdName) || !parseTime(p, 24, stdOffset)) return false;
+  // TZ offsets count west of UTC
+  stdOffset = -stdOffset;
+
+  bool hasDst = *p != '\0';
+  if (hasDst) {
+    if (!parseName(p, dstName)) return false;
+
+    if (*p && *p != ',') {
+      if (!parseTime(p, 24, dstOffset)) return false;
+      dstOffset = -dstOffset;
+    } else {
+      dstOffset = stdOffset + 3600;
+    }
+
+    // the TZ spec leaves missing rules to the implementation, take the US ones
+    // like most C libraries do
+    const char* defaults = ",M3.2.0,M11.1.0";
+    const char* q = *p ? p : defaults;
+
+    for (Rule& rule : rules) {
+      long month, week, weekday, day;
+
+      if (*q++ != ',') return false;
+
+      if (*q == 'M') {
+        q++;
+        if (!parseNumber(q, 12, month) || month < 1 || *q++ != '.' ||
+            !parseNumber(q, 5, week) || week < 1 || *q++ != '.' ||
+            !parseNumber(q, 6, weekday)) {
+          return false;
+        }
+        rule = {'M', (uint8_t)month, (uint8_t)week, (uint8_t)weekday, 0, 0};
+      } else if (*q == 'J') {
+        q++;
+        if (!parseNumber(q, 365, day) || day < 1) return false;
+        rule = {'J', 0, 0, 0, (uint16_t)day, 0};
+      } else {
+        if (!parseNumber(q, 365, day)) return false;
+        rule = {'D', 0, 0, 0, (uint16_t)day, 0};
+      }
+
+      rule.time = DEFAULT_TRANSITION_TIME;
+      if (*q == '/') {
+        q++;
+        if (!parseTime(q, 167, rule.time)) return false;
+      }
+    }
+
+    if (*q != '\0') return false;
+  }
+
+  strcpy(this->_stdName, stdName);
+  strcpy(this->_dstName, dstName);
+  this->_stdOffset = stdOffset;
+  this->_dstOffset = dstOffset;
+  this->_hasDst    = hasDst;
+  if (hasDst) {
+    this->_start = rules[0];
+    this->_end   = rules[1];
+  }
+
+  int year = yearOfDays(nearUtc / SECONDS_PER_DAY);
+  this->_allYearDst = hasDst && this->coversYear(year);
+  this->build(year);
+  return true;
+}
+
+uint32_t TimeZone::transitionAt(const Rule& rule, int year, int32_t offsetBefore) const {
+  long jan1 = daysFromCivil(year, 1, 1);
+  long day;
+
+  if (rule.kind == 'M') {
+    long first = daysFromCivil(year, rule.month, 1);
+    long next = rule.month == 12 ? daysFromCivil(year + 1, 1, 1)
+                                 : daysFromCivil(year, rule.month + 1, 1);
+    uint8_t weekday = dayOfWeek(first * SECONDS_PER_DAY);
+
+    day = first + (rule.weekday - weekday + 7) % 7 + (rule.week - 1) * 7;
+    while (day >= next) day -= 7;
+  } else if (rule.kind == 'J') {
+    // Feb 29 is never counted, so day 60 is always March 1
+    day = jan1 + rule.day - 1 + (LEAP_YEAR(year) && rule.day >= 60);
+  } else {
+    day = jan1 + rule.day;
+  }
+
+  int64_t utc = (int64_t)day * SECONDS_PER_DAY + rule.time - offsetBefore;
+
+  if (utc < 0) return 0;
+  if (utc > UINT32_MAX) return UINT32_MAX;
+  return (uint32_t)utc;
+}
+
+// without a moment of standard time in between: DST starts no later than
+// the local new year and lasts until next year's starts
+bool TimeZone::coversYear(int year) const {
+  int64_t newYear = (int64_t)daysFromCivil(year, 1, 1) * SECONDS_PER_DAY - this->_stdOffset;
+
+  return this->transitionAt(this->_start, year, this->_stdOffset) <= newYear &&
+         this->transitionAt(this->_end, year, this->_dstOffset) >=
+             this->transitionAt(this->_start, year + 1, this->_stdOffset);
+}
+
+void TimeZone::build(int firstYear) {
+  this->_count      = 0;
+  this->_cursor     = 0;
+  this->_tableStart = (uint32_t)(daysFromCivil(firstYear, 1, 1) * SECONDS_PER_DAY);
+  this->_tableEnd   =
+      (uint32_t)(daysFromCivil(firstYear + TIME_ZONE_TABLE_YEARS, 1, 1) * SECONDS_PER_DAY);
+  this->_baseOffset = this->offsetFromRules(this->_tableStart);
+
+  if (!this->_hasDst || this->_allYearDst) return;
+
+  for (int year = firstYear; year < firstYear + TIME_ZONE_TABLE_YEARS; year++) {
+    Transition start = {this->transitionAt(this->_start, year, this->_stdOffset), this->_dstOffset};
+    Transition end   = {this->transitionAt(this->_end, year, this->_dstOffset), this->_stdOffset};
+
+    // southern hemisphere zones leave summer time first
+    if (end.at < start.at) {
+      this->_table[this->_count++] = end;
+      this->_table[this->_count++] = start;
+    } else {
+      this->_table[this->_count++] = start;
+      this->_table[this->_count++] = end;
+    }
+  }
+}
+
+// stretch n runs from transition n - 1 to transition n, with the table
+// bounds standing in at either end
+int32_t TimeZone::stretchOffset(uint8_t stretch) const {
+  return stretch == 0 ? this->_baseOffset : this->_table[stretch - 1].offset;
+}
+
+int32_t TimeZone::offsetAt(uint32_t utc) {
+  if (!this->_hasDst) return this->_stdOffset;
+  if (this->_allYearDst) return this->_dstOffset;
+
+  uint8_t stretch = this->_cursor;
+  uint32_t from = stretch > 0 ? this->_table[stretch - 1].at : this->_tableStart;
+  uint32_t to = stretch < this->_count ? this->_table[stretch].at : this->_tableEnd;
+
+  if (utc >= from && utc < to) return this->stretchOffset(stretch);
+
+  if (utc < this->_tableStart || utc >= this->_tableEnd) {
+    this->build(yearOfDays(utc / SECONDS_PER_DAY));
+    this->_rebuilds++;
+  }
+
+  // only taken twice a year once the clock runs, a scan is plenty
+  stretch = 0;
+  while (stretch < this->_count && this->_table[stretch].at <= utc) stretch++;
+  this->_cursor = stretch;
+
+  return this->stretchOffset(stretch);
+}
+
+int32_t TimeZone::offsetFromRules(uint32_t utc) const {
+  if (!this->_hasDst) return this->_stdOffset;
+  if (this->_allYearDst) return this->_dstOffset;
+
+  int year = yearOfDays(utc / SECONDS_PER_DAY);
+  uint32_t start = this->transitionAt(this->_start, year, this->_stdOffset);
+  uint32_t end = this->transitionAt(this->_end, year, this->_dstOffset);
+  bool dst = start < end ? utc >= start && utc < end : utc >= start || utc < end;
+
+  return dst ? this->_dstOffset : this->_stdOffset;
+}
+
+const char* TimeZone::abbreviation(uint32_t utc) {
+  if (this->_hasDst && this->offsetAt(utc) == this->_dstOffset) return this->_dstName;
+
+  return this->_stdName;
+}
+
+uint8_t TimeZone::transitions() const {
+  return this->_count;
+}
+
+uint32_t TimeZone::rebuilds() const {
+  return this->_rebuilds;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+
+// abbreviations longer than this are cut, POSIX asks for 3 to 6 characters
+#define TIME_ZONE_NAME_SIZE 8
+// years ahead the transition table covers, two transitions per year
+#define TIME_ZONE_TABLE_YEARS 8
+#define TIME_ZONE_MAX_TRANSITIONS (2 * TIME_ZONE_TABLE_YEARS)
+#define TIME_ZONE_DEFAULT "EET-2EEST,M3.5.0/3,M10.5.0/4"
+
+/**
+ * Local time offsets of a POSIX TZ string like `EST5EDT,M3.2.0,M11.1.0`.
+ *
+ * The rules are compiled into a table of the UTC instants the offset changes
+ * at, so a lookup is a compare against the stretch of the previous one
+ * instead of working out the transition days of the year on every call.
+ */
+class TimeZone {
+  private:
+    struct Rule {
+      char     kind;     // 'M' month.week.day, 'J' day without Feb 29, 'D' zero based day
+      uint8_t  month;
+      uint8_t  week;     // 5 is the last one of the month
+      uint8_t  weekday;  // 0 is Sunday
+      uint16_t day;
+      int32_t  time;     // local seconds after midnight, may be negative or past a day
+    };
+
+    struct Transition {
+      uint32_t at;       // UTC
+      int32_t  offset;   // seconds east of UTC from here on
+    };
+
+    char       _stdName[TIME_ZONE_NAME_SIZE] = "UTC";
+    char       _dstName[TIME_ZONE_NAME_SIZE] = "";
+    int32_t    _stdOffset = 0;
+    int32_t    _dstOffset = 0;
+    bool       _hasDst    = false;
+    // DST from the start of the year to where the next year's begins
+    bool       _allYearDst = false;
+    Rule       _start;
+    Rule       _end;
+
+    Transition _table[TIME_ZONE_MAX_TRANSITIONS];
+    uint8_t    _count       = 0;
+    uint32_t   _tableStart  = 0;
+    uint32_t   _tableEnd    = 0;
+    int32_t    _baseOffset  = 0;   // before the first transition
+    uint8_t    _cursor      = 0;   // stretch of the last lookup, see stretchOffset()
+    uint32_t   _rebuilds    = 0;
+
+    uint32_t transitionAt(const Rule& rule, int year, int32_t offsetBefore) const;
+    bool     coversYear(int year) const;
+    void     build(int firstYear);
+    int32_t  stretchOffset(uint8_t stretch) const;
+
+  public:
+    /**
+     * Parses posix, e.g. `CET-1CEST,M3.5.0,M10.5.0/3` or `<+03>-3`, and builds
+     * the transition table from the year of nearUtc on. Offsets are west of
+     * UTC like in the TZ variable. On a malformed string the zone is left
+     * unchanged. Rules like `J1/0,J365/25`, whose DST runs from the start of
+     * the year into the next year's, mean DST all year round as in RFC 8536.
+     *
+     * @return true if posix was understood
+     */
+    bool set(const char* posix, uint32_t nearUtc = 0);
+
+    /**
+     * @return seconds to add to utc for local time, rebuilds the table when
+     * utc falls outside it
+     */
+    int32_t offsetAt(uint32_t utc);
+
+    /**
+     * Works out the offset from the rules on every call. Reference for
+     * offsetAt(), which gives the same answer from the table.
+     */
+    int32_t offsetFromRules(uint32_t utc) const;
+
+    /**
+     * @return abbreviation in effect at utc, like `EEST`
+     */
+    const char* abbreviation(uint32_t utc);
+
+    /**
+     * @return number of transitions in the table
+     */
+    uint8_t transitions() const;
+
+    /**
+     * @return times the table had to be rebuilt for a lookup outside of it
+     */
+    uint32_t rebuilds() const;
+};
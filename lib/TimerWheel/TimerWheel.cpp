@@ -0,0 +1,157 @@
+#include "TimerWheel.h"
+
+// wrap-safe "a is at or after b" for millisecond timestamps
+#define TIME_REACHED(a, b) ((int32_t)((a) - (b)) >= 0)
+
+TimerWheel::TimerWheel(TimerWheelClock clock) {
+  this->_clock = clock;
+}
+
+int8_t TimerWheel::attach(const char* name, uint32_t periodMs, uint32_t coalesceMs,
+                          uint8_t priority, TimerWheelCallback callback) {
+  if (this->_jobCount >= TIMER_WHEEL_MAX_JOBS || periodMs == 0 || callback == nullptr) {
+    return TIMER_WHEEL_INVALID_JOB;
+  }
+
+  Job& job = this->_jobs[this->_jobCount];
+  job.name       = name;
+  job.callback   = callback;
+  job.periodMs   = periodMs;
+  // a window as long as the period would let the job starve itself
+  job.coalesceMs = coalesceMs < periodMs ? coalesceMs : periodMs - 1;
+  job.deadline   = this->_clock() + periodMs;
+  job.priority   = priority;
+  job.enabled    = true;
+  job.stats      = TimerWheelJobStats();
+
+  return (int8_t)this->_jobCount++;
+}
+
+void TimerWheel::enable(int8_t job) {
+  if (job < 0 || job >= this->_jobCount) return;
+
+  if (!this->_jobs[job].enabled) {
+    this->_jobs[job].enabled  = true;
+    this->_jobs[job].deadline = this->_clock() + this->_jobs[job].periodMs;
+  }
+}
+
+void TimerWheel::disable(int8_t job) {
+  if (job < 0 || job >= this->_jobCount) return;
+
+  this->_jobs[job].enabled = false;
+}
+
+void TimerWheel::setPeriod(int8_t job, uint32_t periodMs) {
+  if (job < 0 || job >= this->_jobCount || periodMs == 0) return;
+
+  Job& j = this->_jobs[job];
+  j.periodMs = periodMs;
+  if (j.coalesceMs >= periodMs) j.coalesceMs = periodMs - 1;
+  j.deadline = this->_clock() + periodMs;
+}
+
+void TimerWheel::setNextRun(int8_t job, uint32_t delayMs) {
+  if (job < 0 || job >= this->_jobCount) return;
+
+  this->_jobs[job].enabled  = true;
+  this->_jobs[job].deadline = this->_clock() + delayMs;
+}
+
+void TimerWheel::trigger(int8_t job) {
+  if (job < 0 || job >= this->_jobCount) return;
+
+  this->_jobs[job].enabled  = true;
+  this->_jobs[job].deadline = this->_clock();
+}
+
+void TimerWheel::runJob(Job& job, uint32_t now) {
+  TimerWheelJobStats& stats = job.stats;
+  uint32_t late = now - job.deadline;
+
+  if (late > stats.maxLateMs) stats.maxLateMs = late;
+  stats.avgLateMs = stats.avgLateMs - (stats.avgLateMs >> 3) + (late >> 3);
+
+  // keep the job phase-locked to its original schedule instead of drifting
+  // by the lateness of every run. Advanced before the callback so the job can
+  // move its own next run with setNextRun().
+  job.deadline += job.periodMs;
+
+  uint32_t start = this->_clock();
+  job.callback();
+  uint32_t ran = this->_clock() - start;
+
+  if (ran > stats.maxRunMs) stats.maxRunMs = ran;
+  stats.runs++;
+
+  uint32_t after = this->_clock();
+  if (TIME_REACHED(after, job.deadline)) {
+    uint32_t missed = (after - job.deadline) / job.periodMs + 1;
+    stats.overruns += missed;
+    job.deadline += missed * job.periodMs;
+  }
+}
+
+uint32_t TimerWheel::tick() {
+  uint32_t now = this->_clock();
+  bool ranAny = false;
+
+  this->_wakeups++;
+
+  for (uint8_t priority = TIMER_WHEEL_PRIORITY_HIGH; priority <= TIMER_WHEEL_PRIORITY_LOW; priority++) {
+    for (uint8_t i = 0; i < this->_jobCount; i++) {
+      Job& job = this->_jobs[i];
+
+      if (job.enabled && job.priority == priority && TIME_REACHED(now, job.deadline)) {
+        this->runJob(job, now);
+        ranAny = true;
+      }
+    }
+  }
+
+  if (!ranAny) this->_idleWakeups++;
+
+  return this->msUntilNextWake();
+}
+
+uint32_t TimerWheel::msUntilNextWake() {
+  uint32_t now = this->_clock();
+  uint32_t next = UINT32_MAX;
+
+  for (uint8_t i = 0; i < this->_jobCount; i++) {
+    const Job& job = this->_jobs[i];
+    if (!job.enabled) continue;
+
+    // waking at the end of the window lets every job whose window has
+    // opened by then share the same wakeup
+    uint32_t latest = job.deadline + job.coalesceMs;
+    if (TIME_REACHED(now, latest)) return 0;
+    if (latest - now < next) next = latest - now;
+  }
+
+  return next;
+}
+
+const char* TimerWheel::jobName(int8_t job) {
+  if (job < 0 || job >= this->_jobCount) return nullptr;
+
+  return this->_jobs[job].name;
+}
+
+const TimerWheelJobStats* TimerWheel::jobStats(int8_t job) {
+  if (job < 0 || job >= this->_jobCount) return nullptr;
+
+  return &this->_jobs[job].stats;
+}
+
+uint8_t TimerWheel::jobCount() {
+  return this->_jobCount;
+}
+
+uint32_t TimerWheel::wakeups() {
+  return this->_wakeups;
+}
+
+uint32_t TimerWheel::idleWakeups() {
+  return this->_idleWakeups;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_MAX_JOBS 12
+#define TIMER_WHEEL_INVALID_JOB -1
+
+typedef void (*TimerWheelCallback)(void);
+typedef uint32_t (*TimerWheelClock)(void);
+
+enum TimerWheelPriority : uint8_t {
+  TIMER_WHEEL_PRIORITY_HIGH = 0,
+  TIMER_WHEEL_PRIORITY_NORMAL = 1,
+  TIMER_WHEEL_PRIORITY_LOW = 2
+};
+
+struct TimerWheelJobStats {
+  uint32_t runs;
+  // whole periods that were skipped because the job started too late
+  uint32_t overruns;
+  // worst and smoothed (1/8 EWMA) start lateness against the deadline, in ms
+  uint32_t maxLateMs;
+  uint32_t avgLateMs;
+  // worst callback duration, in ms
+  uint32_t maxRunMs;
+};
+
+/**
+ * Single scheduler for all periodic work on the device.
+ *
+ * Every job has a period, a coalescing window and a priority. A job may be
+ * delayed by up to its coalescing window so that it runs in the same wakeup as
+ * other jobs, which keeps the number of wakeups (and esp_timer interrupts) as
+ * low as possible. The owner calls tick() whenever the single hardware timer
+ * fires and re-arms that timer with the returned delay.
+ *
+ * The clock is injected so the scheduler can be driven by a virtual clock on
+ * the host.
+ */
+class TimerWheel {
+  private:
+    struct Job {
+      const char*        name;
+      TimerWheelCallback callback;
+      uint32_t           periodMs;
+      uint32_t           coalesceMs;
+      uint32_t           deadline;
+      uint8_t            priority;
+      bool               enabled;
+      TimerWheelJobStats stats;
+    };
+
+    TimerWheelClock _clock;
+    Job             _jobs[TIMER_WHEEL_MAX_JOBS];
+    uint8_t         _jobCount    = 0;
+
+    uint32_t        _wakeups     = 0;
+    uint32_t        _idleWakeups = 0;
+
+    void runJob(Job& job, uint32_t now);
+
+  public:
+    TimerWheel(TimerWheelClock clock);
+
+    /**
+     * Registers a periodic job. The first run is due one period from now.
+     *
+     * @return job id, or TIMER_WHEEL_INVALID_JOB when the table is full
+     */
+    int8_t attach(const char* name, uint32_t periodMs, uint32_t coalesceMs,
+                  uint8_t priority, TimerWheelCallback callback);
+
+    void enable(int8_t job);
+    void disable(int8_t job);
+
+    /**
+     * Changes the period and restarts the job from now
+     */
+    void setPeriod(int8_t job, uint32_t periodMs);
+
+    /**
+     * Moves only the next run to delayMs from now, later runs follow the
+     * period from there. May be called from the job's own callback.
+     */
+    void setNextRun(int8_t job, uint32_t delayMs);
+
+    /**
+     * Makes the job due immediately, it will run on the next tick()
+     */
+    void trigger(int8_t job);
+
+    /**
+     * Runs every job whose deadline has passed, highest priority first.
+     *
+     * @return milliseconds until the next wakeup is needed
+     */
+    uint32_t tick();
+
+    /**
+     * @return milliseconds until the latest moment the next job may run
+     */
+    uint32_t msUntilNextWake();
+
+    const char* jobName(int8_t job);
+    const TimerWheelJobStats* jobStats(int8_t job);
+    uint8_t jobCount();
+
+    uint32_t wakeups();
+    // wakeups where no job was due
+    uint32_t idleWakeups();
+};
@@ -0,0 +1,121 @@
+#include "TouchGestures.h"
+
+TouchGestures::TouchGestures(uint16_t initialBaseline, uint32_t longPressMs) {
+  this->_baseline = initialBaseline;
+  this->_longPressMs = longPressMs;
+}
+
+void TouchGestures::setLongPressMs(uint32_t longPressMs) {
+  this->_longPressMs = longPressMs;
+}
+
+uint16_t TouchGestures::filtered(uint16_t raw) {
+  if (this->_sampleCount < 3) {
+    this->_samples[this->_sampleCount++] = raw;
+    if (this->_sampleCount < 3) return raw;
+  } else {
+    this->_samples[0] = this->_samples[1];
+    this->_samples[1] = this->_samples[2];
+    this->_samples[2] = raw;
+  }
+
+  uint16_t a = this->_samples[0], b = this->_samples[1], c = this->_samples[2];
+
+  if (a > b) {
+    uint16_t tmp = a; a = b; b = tmp;
+  }
+  // median is b clamped to [a, c] once a <= b
+  if (c < a) return a;
+  if (c > b) return b;
+  return c;
+}
+
+void TouchGestures::push(uint8_t type, uint32_t atMs, uint32_t durationMs) {
+  uint8_t next = (this->_head + 1) % TOUCH_GESTURES_QUEUE_SIZE;
+
+  if (next == this->_tail) {
+    this->_dropped++;
+    return;
+  }
+
+  this->_queue[this->_head].type = type;
+  this->_queue[this->_head].atMs = atMs;
+  this->_queue[this->_head].durationMs = durationMs;
+  this->_head = next;
+}
+
+void TouchGestures::sample(uint32_t nowMs, uint16_t raw) {
+  uint16_t value = this->filtered(raw);
+
+  if (!this->_pressed) {
+    if (value < this->pressLevel()) {
+      this->_pressed = true;
+      this->_longReported = false;
+      this->_pressStart = nowMs;
+      this->push(TOUCH_EVENT_PRESS, nowMs, 0);
+    } else if (value >= this->_baseline) {
+      this->_baseline += (value - this->_baseline + 1) / 2;
+    } else if (value > (uint32_t)this->_baseline * TOUCH_GESTURES_RELEASE_PERCENT / 100) {
+      // slow drift downwards, a finger hovering close must not drag it along
+      this->_baseline -= (this->_baseline - value + 15) / 16;
+    }
+  } else if (value > (uint32_t)this->_baseline * TOUCH_GESTURES_RELEASE_PERCENT / 100) {
+    uint32_t duration = nowMs - this->_pressStart;
+
+    this->_pressed = false;
+    this->push(TOUCH_EVENT_RELEASE, nowMs, duration);
+
+    if (duration <= TOUCH_GESTURES_TAP_MAX_MS) {
+      if (this->_tapPending) {
+        this->_tapPending = false;
+        this->push(TOUCH_EVENT_DOUBLE_TAP, nowMs, 0);
+      } else {
+        this->_tapPending = true;
+        this->_tapAt = nowMs;
+      }
+    }
+  }
+
+  if (this->_pressed && !this->_longReported &&
+      nowMs - this->_pressStart >= this->_longPressMs) {
+    this->_longReported = true;
+    // a long press never completes a double tap
+    this->_tapPending = false;
+    this->push(TOUCH_EVENT_LONG_PRESS, nowMs, nowMs - this->_pressStart);
+  }
+
+  if (this->_tapPending && !this->_pressed &&
+      nowMs - this->_tapAt > TOUCH_GESTURES_DOUBLE_TAP_WINDOW_MS) {
+    this->_tapPending = false;
+    this->push(TOUCH_EVENT_TAP, this->_tapAt, 0);
+  }
+}
+
+bool TouchGestures::active() const {
+  return this->_pressed || this->_tapPending;
+}
+
+bool TouchGestures::pressed() const {
+  return this->_pressed;
+}
+
+uint16_t TouchGestures::pressLevel() const {
+  return (uint32_t)this->_baseline * TOUCH_GESTURES_PRESS_PERCENT / 100;
+}
+
+uint16_t TouchGestures::baseline() const {
+  return this->_baseline;
+}
+
+bool TouchGestures::nextEvent(TouchEvent &event) {
+  if (this->_tail == this->_head) return false;
+
+  event = this->_queue[this->_tail];
+  this->_tail = (this->_tail + 1) % TOUCH_GESTURES_QUEUE_SIZE;
+
+  return true;
+}
+
+uint32_t TouchGestures::droppedEvents() const {
+  return this->_dropped;
+}
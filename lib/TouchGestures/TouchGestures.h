@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+
+// a finger pulls the reading below this share of the baseline...
+#define TOUCH_GESTURES_PRESS_PERCENT 60
+// ...and it counts as lifted again above this one
+#define TOUCH_GESTURES_RELEASE_PERCENT 80
+#define TOUCH_GESTURES_TAP_MAX_MS 400
+#define TOUCH_GESTURES_DOUBLE_TAP_WINDOW_MS 300
+// how often the pad has to be sampled while a gesture is in progress
+#define TOUCH_GESTURES_SAMPLE_INTERVAL_MS 20
+#define TOUCH_GESTURES_QUEUE_SIZE 8
+
+enum TouchEventType : uint8_t {
+  TOUCH_EVENT_PRESS,
+  TOUCH_EVENT_RELEASE,
+  TOUCH_EVENT_TAP,
+  TOUCH_EVENT_DOUBLE_TAP,
+  TOUCH_EVENT_LONG_PRESS
+};
+
+struct TouchEvent {
+  uint8_t  type;
+  uint32_t atMs;
+  // how long the finger was down, for RELEASE and LONG_PRESS
+  uint32_t durationMs;
+};
+
+/**
+ * Turns raw capacitive readings of the touch pad into gestures.
+ *
+ * Readings go through a median-of-three filter against single-sample spikes
+ * and are compared against a baseline that follows the untouched pad (fast
+ * upwards, slowly downwards) with separate press and release levels. Tap,
+ * double tap and long press are recognized from the press timings and queued
+ * for the UI, which takes them with nextEvent().
+ *
+ * Samples only need to come in at TOUCH_GESTURES_SAMPLE_INTERVAL_MS while
+ * active(). Otherwise the pad is left to the touch interrupt, armed at
+ * pressLevel(), plus the occasional sample to keep the baseline current.
+ */
+class TouchGestures {
+  private:
+    uint16_t   _samples[3];
+    uint8_t    _sampleCount   = 0;
+    uint16_t   _baseline;
+
+    uint32_t   _longPressMs;
+
+    bool       _pressed       = false;
+    bool       _longReported  = false;
+    uint32_t   _pressStart    = 0;
+    // a tap waiting to see if a second one follows
+    bool       _tapPending    = false;
+    uint32_t   _tapAt         = 0;
+
+    TouchEvent _queue[TOUCH_GESTURES_QUEUE_SIZE];
+    uint8_t    _head          = 0;
+    uint8_t    _tail          = 0;
+    uint32_t   _dropped       = 0;
+
+    uint16_t filtered(uint16_t raw);
+    void push(uint8_t type, uint32_t atMs, uint32_t durationMs);
+
+  public:
+    /**
+     * @param initialBaseline untouched reading to assume until samples come in
+     * @param longPressMs hold time that makes a long press
+     */
+    TouchGestures(uint16_t initialBaseline, uint32_t longPressMs);
+
+    void setLongPressMs(uint32_t longPressMs);
+
+    void sample(uint32_t nowMs, uint16_t raw);
+
+    /**
+     * @return true while the pad is pressed or a tap may still become a
+     *         double tap, samples are needed every
+     *         TOUCH_GESTURES_SAMPLE_INTERVAL_MS until it turns false
+     */
+    bool active() const;
+
+    bool pressed() const;
+
+    /**
+     * @return raw reading below which the pad counts as pressed, for arming
+     *         the touch interrupt
+     */
+    uint16_t pressLevel() const;
+    uint16_t baseline() const;
+
+    /**
+     * Takes the oldest event off the queue
+     *
+     * @return false when there is none
+     */
+    bool nextEvent(TouchEvent &event);
+
+    // events lost because the queue was full
+    uint32_t droppedEvents() const;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+// Generated by scripts/gen_sprites.py, do not edit.
+
+#include <stdint.h>
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+// WiFi icon by number of arcs, top left at dot x -6, y -9
+#define WIFI_SPRITE_OFFSET_X -6
+#define WIFI_SPRITE_OFFSET_Y -9
+#define WIFI_SPRITE_WIDTH 14
+#define WIFI_SPRITE_PAGES 2
+static const uint8_t WIFI_SPRITES[4][28] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x80, 0x80, 0x40, 0x40, 0x40, 0x40, 0x80, 0x80, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x10, 0x90, 0x88, 0x48, 0x48, 0x48, 0x48, 0x88, 0x90, 0x10,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00},
+    {0x02, 0x02, 0x11, 0x91, 0x89, 0x49, 0x49, 0x49, 0x49, 0x89, 0x91, 0x11,
+     0x02, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00},
+};
+
+// activity indicator by animation step, left and right of the sensor rows
+#define SIDE_SPRITE_Y 28
+#define SIDE_SPRITE_LEFT_X 10
+#define SIDE_SPRITE_RIGHT_X 108
+#define SIDE_SPRITE_WIDTH 11
+// the lines take the top rows of the pages, the rest is blank
+#define SIDE_SPRITE_HEIGHT 21
+#define SIDE_SPRITE_PAGES 3
+static const uint8_t SIDE_SPRITES_LEFT[4][33] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x1f},
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0x00, 0xff, 0x1f,
+     0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x1f},
+};
+static const uint8_t SIDE_SPRITES_RIGHT[4][33] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0xff, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+     0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x00,
+     0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0xff, 0x00, 0x00, 0x00, 0x00, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+     0x00, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x00,
+     0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00},
+};
@@ -0,0 +1,112 @@
+#include "Widgets.h"
+
+#include "Sprites.h"
+
+static_assert(WIFI_ICON_WIDTH == WIFI_SPRITE_WIDTH &&
+                  WIFI_ICON_HEIGHT == WIFI_SPRITE_PAGES * 8,
+              "WiFi icon size doesn't match its sprites");
+static_assert(SIDE_LINES_WIDTH == SIDE_SPRITE_WIDTH &&
+                  SIDE_LINES_HEIGHT == SIDE_SPRITE_HEIGHT,
+              "side lines size doesn't match their sprites");
+
+uint8_t wifiBarsForRSSI(int32_t rssi) {
+  if (rssi >= -67) return 3;
+  if (rssi >= -70) return 2;
+  if (rssi >= -80) return 1;
+
+  return 0;
+}
+
+void drawWiFiIcon(Framebuffer &fb, uint8_t bars, int16_t x, int16_t y) {
+  if (bars > WIFI_ICON_MAX_BARS) bars = WIFI_ICON_MAX_BARS;
+
+  fb.blit(WIFI_SPRITES[bars], WIFI_SPRITE_WIDTH, WIFI_SPRITE_PAGES, x, y);
+}
+
+void drawSideLines(Framebuffer &fb, uint8_t step, int16_t leftX, int16_t rightX,
+                   int16_t y) {
+  if (step > MAX_SIDE_LINE_STEP) return;
+
+  fb.blit(SIDE_SPRITES_LEFT[step], SIDE_SPRITE_WIDTH, SIDE_SPRITE_PAGES, leftX,
+          y);
+  fb.blit(SIDE_SPRITES_RIGHT[step], SIDE_SPRITE_WIDTH, SIDE_SPRITE_PAGES,
+          rightX, y);
+}
+
+void drawSparkline(Framebuffer &fb, int16_t x, int16_t y, int16_t w, int16_t h,
+                   const int32_t *values, uint8_t count) {
+  if (count == 0 || w < 2 || h < 1) return;
+
+  int32_t min = values[0], max = values[0];
+  for (uint8_t i = 1; i < count; i++) {
+    if (values[i] < min) min = values[i];
+    if (values[i] > max) max = values[i];
+  }
+
+  int64_t range = (int64_t)max - min;
+  int16_t prevX = 0, prevY = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    // a single value sits at the right edge like the latest of many would
+    int16_t px = count > 1 ? x + (int32_t)i * (w - 1) / (count - 1) : x + w - 1;
+    int16_t py = range > 0 ? y + h - 1 - (values[i] - min) * (h - 1) / range
+                           : y + h / 2;
+
+    if (i == 0) {
+      fb.setPixel(px, py);
+    } else {
+      fb.drawLine(prevX, prevY, px, py);
+    }
+
+    prevX = px;
+    prevY = py;
+  }
+}
+
+void drawRangeGraph(Framebuffer &fb, int16_t x, int16_t y, int16_t w, int16_t h,
+                    const int16_t *min, const int16_t *max, uint16_t count) {
+  if (count > w) count = w;
+  if (count == 0 || h < 1) return;
+
+  int16_t low = INT16_MAX, high = INT16_MIN;
+  for (uint16_t i = 0; i < count; i++) {
+    if (min[i] == INT16_MIN) continue;
+    if (min[i] < low) low = min[i];
+    if (max[i] > high) high = max[i];
+  }
+
+  if (low > high) return;
+
+  int32_t range = (int32_t)high - low;
+
+  for (uint16_t i = 0; i < count; i++) {
+    if (min[i] == INT16_MIN) continue;
+
+    int16_t top = range > 0 ? y + h - 1 - (max[i] - low) * (h - 1) / range
+                            : y + h / 2;
+    int16_t bottom = range > 0 ? y + h - 1 - (min[i] - low) * (h - 1) / range
+                               : y + h / 2;
+
+    fb.vline(x + i, top, bottom - top + 1);
+  }
+}
+
+void drawStaleMarker(Framebuffer &fb, int16_t x, int16_t y) {
+  // ..###..
+  // .#...#.
+  // #..#..#
+  // #..##.#
+  // #.....#
+  // .#...#.
+  // ..###..
+  fb.hline(x + 2, y, 3);
+  fb.hline(x + 2, y + 6, 3);
+  fb.vline(x, y + 2, 3);
+  fb.vline(x + 6, y + 2, 3);
+  fb.setPixel(x + 1, y + 1);
+  fb.setPixel(x + 5, y + 1);
+  fb.setPixel(x + 1, y + 5);
+  fb.setPixel(x + 5, y + 5);
+  fb.vline(x + 3, y + 2, 2);
+  fb.setPixel(x + 4, y + 3);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "Framebuffer.h"
+
+#define WIFI_ICON_MAX_BARS 3
+#define WIFI_ICON_WIDTH 14
+#define WIFI_ICON_HEIGHT 16
+#define MAX_SIDE_LINE_STEP 3
+#define SIDE_LINES_WIDTH 11
+// drawn from SIDE_SPRITE_PAGES pages, the blank rows under it don't count
+#define SIDE_LINES_HEIGHT 21
+
+/**
+ * Maps an RSSI reading to the number of arcs drawn above the WiFi dot
+ */
+uint8_t wifiBarsForRSSI(int32_t rssi);
+
+/**
+ * Draws the WiFi icon, WIFI_ICON_WIDTH x WIFI_ICON_HEIGHT with its top left
+ * corner at x, y, with the given number of arcs (0-3) above the dot
+ */
+void drawWiFiIcon(Framebuffer &fb, uint8_t bars, int16_t x, int16_t y);
+
+/**
+ * Draws the activity indicator bars for animation step 0-3, each
+ * SIDE_LINES_WIDTH x SIDE_LINES_HEIGHT with its top left corner at leftX or
+ * rightX, y
+ */
+void drawSideLines(Framebuffer &fb, uint8_t step, int16_t leftX, int16_t rightX,
+                   int16_t y);
+
+/**
+ * Draws values (oldest first) as a line graph scaled to fill the w x h box
+ * at x, y, the newest value at the right edge. A flat series is drawn
+ * through the middle of the box.
+ */
+void drawSparkline(Framebuffer &fb, int16_t x, int16_t y, int16_t w, int16_t h,
+                   const int32_t *values, uint8_t count);
+
+/**
+ * Draws a min/max envelope, one column per entry, as vertical lines scaled to
+ * fill the w x h box at x, y. Columns whose min is INT16_MIN have no data and
+ * stay empty.
+ */
+void drawRangeGraph(Framebuffer &fb, int16_t x, int16_t y, int16_t w, int16_t h,
+                    const int16_t *min, const int16_t *max, uint16_t count);
+
+#define STALE_MARKER_SIZE 7
+
+/**
+ * Draws the small clock face shown while the screen still has data from
+ * before the last boot, top left corner at x, y
+ */
+void drawStaleMarker(Framebuffer &fb, int16_t x, int16_t y);
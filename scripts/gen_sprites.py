@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""
+Generates lib/Widgets/Sprites.h: the WiFi icon levels and activity indicator
+steps pre-rasterized into SSD1306 page layout (one byte per column per page,
+LSB on top), so the firmware blits them instead of drawing lines.
+
+The geometry mirrors the line drawing the widgets used before. Run it again
+after changing it:
+
+    python3 scripts/gen_sprites.py
+"""
+import os
+
+OUT = os.path.join(os.path.dirname(__file__), "..", "lib", "Widgets", "Sprites.h")
+
+# WiFi icon relative to the dot's top left corner: (x0, x1, dy) spans per arc
+WIFI_ORIGIN = (-6, -9)  # sprite top left relative to the dot
+WIFI_SIZE = (14, 11)
+WIFI_ARCS = [
+    [(-3, -2, -2), (-1, 2, -3), (3, 4, -2)],  # lower
+    [(-4, -3, -5), (-2, 3, -6), (4, 5, -5)],  # mid
+    [(-6, -5, -8), (-4, 5, -9), (6, 7, -8)],  # top
+]
+
+# activity indicator bars as (x, y0, y1), left side then mirrored right side
+SIDE_ORIGIN_Y = 28
+SIDE_HEIGHT = 21
+SIDE_LEFT_X = 10
+SIDE_RIGHT_X = 108
+SIDE_WIDTH = 11
+SIDE_BARS = {
+    "l2o4": [(10, 36, 40), (118, 36, 40)],
+    "l3o4": [(15, 32, 44), (113, 32, 44)],
+    "l4o4": [(20, 28, 48), (108, 28, 48)],
+}
+SIDE_STEPS = [[], ["l4o4"], ["l3o4", "l4o4"], ["l2o4", "l3o4", "l4o4"]]
+
+
+def blank(width, height):
+    return [[0] * width for _ in range(height)]
+
+
+def to_pages(pixels):
+    height, width = len(pixels), len(pixels[0])
+    pages = (height + 7) // 8
+    out = []
+    for page in range(pages):
+        for x in range(width):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < height and pixels[y][x]:
+                    byte |= 1 << bit
+            out.append(byte)
+    return pages, out
+
+
+def wifi_sprite(bars):
+    w, h = WIFI_SIZE
+    px = blank(w, h)
+    ox, oy = WIFI_ORIGIN
+    for arc in WIFI_ARCS[:bars]:
+        for x0, x1, dy in arc:
+            for x in range(x0, x1 + 1):
+                px[dy - oy][x - ox] = 1
+    for x in (0, 1):  # the 2x2 dot
+        for y in (0, 1):
+            px[y - oy][x - ox] = 1
+    return to_pages(px)
+
+
+def side_sprite(step, left):
+    px = blank(SIDE_WIDTH, SIDE_HEIGHT)
+    origin = SIDE_LEFT_X if left else SIDE_RIGHT_X
+    for name in SIDE_STEPS[step]:
+        for x, y0, y1 in SIDE_BARS[name]:
+            if origin <= x < origin + SIDE_WIDTH:
+                for y in range(y0, y1 + 1):
+                    px[y - SIDE_ORIGIN_Y][x - origin] = 1
+    return to_pages(px)
+
+
+def emit_table(name, sprites):
+    lines = ["static const uint8_t %s[%d][%d] PROGMEM = {" % (name, len(sprites), len(sprites[0]))]
+    for data in sprites:
+        rows = [data[i:i + 12] for i in range(0, len(data), 12)]
+        body = ",\n     ".join(", ".join("0x%02x" % b for b in row) for row in rows)
+        lines.append("    {" + body + "},")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    wifi = [wifi_sprite(bars) for bars in range(4)]
+    left = [side_sprite(step, True) for step in range(4)]
+    right = [side_sprite(step, False) for step in range(4)]
+
+    out = [
+        "#pragma once",
+        "",
+        "// Generated by scripts/gen_sprites.py, do not edit.",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#ifndef PROGMEM",
+        "#define PROGMEM",
+        "#endif",
+        "",
+        "// WiFi icon by number of arcs, top left at dot x %d, y %d" % WIFI_ORIGIN,
+        "#define WIFI_SPRITE_OFFSET_X %d" % WIFI_ORIGIN[0],
+        "#define WIFI_SPRITE_OFFSET_Y %d" % WIFI_ORIGIN[1],
+        "#define WIFI_SPRITE_WIDTH %d" % WIFI_SIZE[0],
+        "#define WIFI_SPRITE_PAGES %d" % wifi[0][0],
+        emit_table("WIFI_SPRITES", [d for _, d in wifi]),
+        "",
+        "// activity indicator by animation step, left and right of the sensor rows",
+        "#define SIDE_SPRITE_Y %d" % SIDE_ORIGIN_Y,
+        "#define SIDE_SPRITE_LEFT_X %d" % SIDE_LEFT_X,
+        "#define SIDE_SPRITE_RIGHT_X %d" % SIDE_RIGHT_X,
+        "#define SIDE_SPRITE_WIDTH %d" % SIDE_WIDTH,
+        "// the lines take the top rows of the pages, the rest is blank",
+        "#define SIDE_SPRITE_HEIGHT %d" % SIDE_HEIGHT,
+        "#define SIDE_SPRITE_PAGES %d" % left[0][0],
+        emit_table("SIDE_SPRITES_LEFT", [d for _, d in left]),
+        emit_table("SIDE_SPRITES_RIGHT", [d for _, d in right]),
+        "",
+    ]
+
+    with open(OUT, "w") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,5 @@
+# PlatformIO passes build_flags to the compiler only, the sanitizer runtimes
+# also have to be linked in.
+Import("env")
+
+env.Append(LINKFLAGS=["-fsanitize=address,undefined"])
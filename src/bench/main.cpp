@@ -0,0 +1,589 @@
+/**
+ * Host micro-benchmarks for the per-tick hot paths of the firmware.
+ *
+ * Every case runs against fixed fixtures (recorded HomeAssistant responses,
+ * fixed epochs, a fixed settings record) and reports ns/op, allocations/op and
+ * allocated bytes/op. Results can be saved as a baseline and later runs
+ * compared against it; a case that gets slower than the threshold or
+ * allocates more than before fails the run.
+ *
+ *   desk_display_bench [--filter TEXT] [--save FILE] [--baseline FILE]
+ *                      [--threshold PERCENT]
+ */
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DeskApp.h"
+#include "DisplayPipeline.h"
+#include "Framebuffer.h"
+#include "GlyphAtlas.h"
+#include "HaSensor.h"
+#include "Hal.h"
+#include "PanelFanout.h"
+#include "Screens.h"
+#include "Settings.h"
+#include "StockTicker.h"
+#include "TimeFormat.h"
+#include "TimeSeries.h"
+#include "TimerWheel.h"
+#include "TimeZone.h"
+#include "Widgets.h"
+#include "../native/fixtures.h"
+
+#define BENCH_MIN_TIME_MS 200
+#define BENCH_RUNS 5
+#define BENCH_MAX_CASES 32
+#define BENCH_DEFAULT_THRESHOLD_PERCENT 25
+
+// allocation accounting for everything running inside a measured case
+static bool countAllocations = false;
+static unsigned long allocationCount = 0;
+static unsigned long allocationBytes = 0;
+
+void *operator new(size_t size) {
+  if (countAllocations) {
+    allocationCount++;
+    allocationBytes += size;
+  }
+
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// keeps the optimizer from dropping the measured work
+static volatile uint32_t sink;
+
+// 2022-11-02T18:41:09Z and a leap day
+static const unsigned long FIXED_EPOCHS[] = {1667414469UL, 1709208000UL};
+
+static const char *TEMPLATE_VARS[] = {
+    "SETUP_STATE",          "WIFI_SSID",
+    "WIFI_PASSWORD",        "HA_API",
+    "AUTH_TOKEN",           "IN_SENSOR_ID",
+    "OUT_SENSOR_ID",        "STOCK_SYMBOLS",
+    "STOCK_API_URL",        "ENABLE_DEBUG",
+    "DEBUG_MODE_STYLING",   "WIFI_ICON_STATE",
+    "DEBUG_MODE_STYLING",   "HTTP_REQUEST_INTERVAL",
+    "DEBUG_MODE_STYLING",   "LONG_TOUCH_SELECTED",
+    "MEDIUM_TOUCH_SELECTED", "SHORT_TOUCH_SELECTED",
+    "DEBUG_MODE_STYLING",   "HIGH_BRIGHTNESS_SELECTED",
+    "MEDIUM_BRIGHTNESS_SELECTED", "DIM_BRIGHTNESS_SELECTED",
+    "DEBUG_MODE_STYLING",   "POWER_SAVE", "TIME_ZONE",
+    "INVERT_SCREEN",        "IS_SETUP"};
+
+static uint8_t frame[FRAMEBUFFER_SIZE];
+static Framebuffer screen(frame);
+
+// stand-in for the 24 px clock font: solid 12 x 28 px glyphs
+static GlyphAtlas clockAtlas(4);
+
+static DeviceSettings settings;
+static uint8_t settingsStore[sizeof(DeviceSettings)];
+static size_t settingsStorePos;
+
+static int16_t reading;
+// spans every digit count and both signs
+static const int16_t FORMAT_READINGS[] = {224, -35, -125, 5, 1234, -32767};
+#define FORMAT_READING_COUNT (sizeof(FORMAT_READINGS) / sizeof(FORMAT_READINGS[0]))
+
+// a day of readings a minute apart, the decode cases go through all of it
+#define HISTORY_BENCH_SAMPLES 1440
+static uint8_t historyBuffer[16 * TIME_SERIES_BLOCK_SIZE];
+static TimeSeries history(historyBuffer, sizeof(historyBuffer));
+static uint8_t appendBuffer[16 * TIME_SERIES_BLOCK_SIZE];
+static TimeSeries appendHistory(appendBuffer, sizeof(appendBuffer));
+static uint32_t historySample = 0;
+
+// the firmware's main frame path, with the fixture readings and frames
+// handed to a transport that drops them
+class NullTransport : public DisplayTransport {
+  public:
+    void sendFrame(const uint8_t *frame) override { sink += frame[0]; }
+};
+
+static uint8_t appFrames[2][FRAMEBUFFER_SIZE];
+static Framebuffer appScreen(appFrames[0]);
+static NullTransport appTransport;
+static DisplayPipeline appPipeline(appTransport);
+static PanelFanout appFanout;
+static TimerWheel appScheduler(halMillis);
+static StockTicker appStocks;
+static uint8_t appInsideBuffer[HISTORY_RAM_SIZE];
+static uint8_t appOutsideBuffer[HISTORY_RAM_SIZE];
+static TimeSeries appInsideHistory(appInsideBuffer, sizeof(appInsideBuffer));
+static TimeSeries appOutsideHistory(appOutsideBuffer, sizeof(appOutsideBuffer));
+static DeskApp app(appScreen, appPipeline, appFanout, appScheduler, appStocks,
+                   appInsideHistory, appOutsideHistory);
+static uint32_t appEpoch = FIXED_EPOCHS[0];
+
+static uint32_t appUtcEpoch(void) {
+  return appEpoch;
+}
+
+static uint32_t appMsUntilNextSecond(void) {
+  return 500;
+}
+
+static void appAttachFrame(uint8_t *frame) {
+  appScreen.attach(frame);
+}
+
+// the transfer task's part too, so the next swap finds the bus free
+static void appPresentFrame(void) {
+  appPipeline.swap();
+  appPipeline.transferPending();
+  appScreen.attach(appPipeline.backBuffer());
+}
+
+// the clock atlas stands in for the OLED driver's fonts on the device
+static void appDrawText(uint8_t page) {
+  char time[TIME_FORMAT_TIME_SIZE];
+
+  if (page != 0) return;
+
+  formatTime(appEpoch, time);
+  clockAtlas.drawTextCentered(appScreen, MAIN_SCREEN[MAIN_CLOCK].x,
+                             MAIN_SCREEN[MAIN_CLOCK].y, time);
+}
+
+static const DeskAppHooks APP_HOOKS = {
+    appUtcEpoch,    appMsUntilNextSecond, nullptr,
+    appAttachFrame, appPresentFrame,      appDrawText,
+    nullptr,        nullptr,              nullptr,
+    nullptr,
+};
+
+static void initApp(void) {
+  app.setHooks(APP_HOOKS);
+  appPipeline.attach(appFrames[0], appFrames[1]);
+  app.setTimeSynced();
+  app.handleSensorResponse(DESK_APP_INSIDE, 200,
+                           (const uint8_t *)IN_SENSOR_RESPONSE,
+                           sizeof(IN_SENSOR_RESPONSE) - 1);
+  app.handleSensorResponse(DESK_APP_OUTSIDE, 200,
+                           (const uint8_t *)OUT_SENSOR_RESPONSE,
+                           sizeof(OUT_SENSOR_RESPONSE) - 1);
+  // the first frame logs, keep that out of the measurements
+  app.update(true);
+}
+
+// a clock frame with the activity indicator running
+static void benchRenderFrame(void) {
+  app.setActivity(true);
+  app.renderMainFrame(true);
+  sink += appPipeline.framesQueued();
+}
+
+// a main job run every second: a new clock frame
+static void benchAppUpdate(void) {
+  app.setActivity(false);
+  appEpoch++;
+  sink += app.update(true);
+}
+
+// a main job run that finds nothing changed, e.g. the second run while
+// animating at half seconds
+static void benchAppUpdateUnchanged(void) {
+  app.setActivity(false);
+  sink += app.update(true);
+}
+
+static void benchClockText(void) {
+  static uint8_t i = 0;
+  char time[TIME_FORMAT_TIME_SIZE];
+
+  formatTime(FIXED_EPOCHS[i++ & 1], time);
+  screen.clear();
+  clockAtlas.drawTextCentered(screen, MAIN_SCREEN[MAIN_CLOCK].x,
+                             MAIN_SCREEN[MAIN_CLOCK].y, time);
+
+  sink += frame[64];
+}
+
+// the primitives each run across page boundaries and unaligned columns
+static void benchHLine(void) {
+  screen.hline(3, 25, 122);
+  screen.hline(3, 51, 122);
+  sink += frame[3 * FRAMEBUFFER_WIDTH + 64];
+}
+
+static void benchHLinePixels(void) {
+  screen.drawLinePixels(3, 25, 124, 25);
+  screen.drawLinePixels(3, 51, 124, 51);
+  sink += frame[3 * FRAMEBUFFER_WIDTH + 64];
+}
+
+static void benchVLine(void) {
+  screen.vline(82, 3, 58);
+  sink += frame[82];
+}
+
+static void benchVLinePixels(void) {
+  screen.drawLinePixels(82, 3, 82, 60);
+  sink += frame[82];
+}
+
+static void benchFillRect(void) {
+  screen.fillRect(5, 3, 117, 58);
+  screen.clearRect(9, 7, 109, 50);
+  sink += frame[FRAMEBUFFER_SIZE / 2];
+}
+
+static void benchFillRectPixels(void) {
+  screen.fillRectPixels(5, 3, 117, 58);
+  for (int16_t x = 9; x < 9 + 109; x++) {
+    for (int16_t y = 7; y < 7 + 50; y++) screen.clearPixel(x, y);
+  }
+  sink += frame[FRAMEBUFFER_SIZE / 2];
+}
+
+static void initClockAtlas(void) {
+  for (const char *c = "0123456789:"; *c; c++) {
+    screen.clear();
+    screen.fillRect(1, 2, 11, 26);
+    clockAtlas.capture(screen, *c, 13, 13);
+  }
+}
+
+static void benchFormatTime(void) {
+  static uint8_t i = 0;
+  char time[TIME_FORMAT_TIME_SIZE];
+
+  formatTime(FIXED_EPOCHS[i++ & 1], time);
+  sink += time[7];
+}
+
+static void benchFormatDate(void) {
+  static uint8_t i = 0;
+  char date[TIME_FORMAT_DATE_SIZE];
+
+  formatDate(FIXED_EPOCHS[i++ & 1], date);
+  sink += date[9];
+}
+
+// one render per second across a year, so the lookups cross both transitions
+static TimeZone timeZone;
+static uint32_t timeZoneUtc = 0;
+
+static void benchTimeZoneLookup(void) {
+  timeZoneUtc = timeZoneUtc + 1 >= FIXED_EPOCHS[1] ? FIXED_EPOCHS[0] : timeZoneUtc + 1;
+  sink += timeZone.offsetAt(timeZoneUtc);
+}
+
+static void benchTimeZoneRules(void) {
+  timeZoneUtc = timeZoneUtc + 1 >= FIXED_EPOCHS[1] ? FIXED_EPOCHS[0] : timeZoneUtc + 1;
+  sink += timeZone.offsetFromRules(timeZoneUtc);
+}
+
+static void benchParseState(void) {
+  haParseReading((const uint8_t *)IN_SENSOR_RESPONSE,
+                 sizeof(IN_SENSOR_RESPONSE) - 1, HA_SENSOR_TEMPERATURE, reading);
+  sink += reading;
+}
+
+static void benchParseTemperature(void) {
+  haParseReading((const uint8_t *)OUT_SENSOR_RESPONSE,
+                 sizeof(OUT_SENSOR_RESPONSE) - 1, HA_WEATHER_TEMPERATURE,
+                 reading);
+  sink += reading;
+}
+
+static void benchFormatReading(void) {
+  static uint8_t i = 0;
+  char text[HA_READING_TEXT_SIZE];
+
+  haFormatReading(FORMAT_READINGS[i++ % FORMAT_READING_COUNT], HA_SENSOR_TEMPERATURE, text,
+                  sizeof(text));
+  sink += text[1];
+}
+
+// what formatting the readings used to cost
+static void benchFormatReadingPrintf(void) {
+  static uint8_t i = 0;
+  char text[24];
+
+  snprintf(text, sizeof(text), "%g\xB0" "C", FORMAT_READINGS[i++ % FORMAT_READING_COUNT] / 10.0f);
+  sink += text[1];
+}
+
+static void benchTemplateExpansion(void) {
+  for (size_t i = 0; i < sizeof(TEMPLATE_VARS) / sizeof(TEMPLATE_VARS[0]);
+       i++) {
+    sink += settingsTemplateValue(settings, TEMPLATE_VARS[i])[0];
+  }
+}
+
+static size_t writeStore(void *, const uint8_t *data, size_t length) {
+  if (settingsStorePos + length > sizeof(settingsStore)) return 0;
+
+  memcpy(settingsStore + settingsStorePos, data, length);
+  settingsStorePos += length;
+
+  return length;
+}
+
+static size_t readStore(void *, uint8_t *data, size_t length) {
+  if (settingsStorePos + length > sizeof(settingsStore)) return 0;
+
+  memcpy(data, settingsStore + settingsStorePos, length);
+  settingsStorePos += length;
+
+  return length;
+}
+
+// a 3 degree swing over the day with the occasional tenth of noise, and a
+// sample that is a second late now and then
+static uint32_t historyTime(uint32_t i) {
+  return FIXED_EPOCHS[0] + i * 60 + (i % 7 == 0);
+}
+
+static int16_t historyReading(uint32_t i) {
+  uint32_t minute = i % HISTORY_BENCH_SAMPLES;
+  uint32_t swing = minute < 720 ? minute : HISTORY_BENCH_SAMPLES - minute;
+
+  return (int16_t)(200 + swing / 24 + ((i * 2654435761u) >> 30 == 0));
+}
+
+static void initHistory(void) {
+  for (uint32_t i = 0; i < HISTORY_BENCH_SAMPLES; i++) {
+    history.append(historyTime(i), historyReading(i));
+  }
+}
+
+// keeps going past the RAM budget, so block turnover is part of the cost
+static void benchHistoryAppend(void) {
+  appendHistory.append(historyTime(historySample), historyReading(historySample));
+  historySample++;
+  sink += appendHistory.samples();
+}
+
+static void benchHistoryStats(void) {
+  TimeSeriesStats stats;
+  history.stats(0, UINT32_MAX, stats);
+  sink += stats.count;
+}
+
+static void benchHistoryDownsample(void) {
+  int16_t min[FRAMEBUFFER_WIDTH], max[FRAMEBUFFER_WIDTH];
+  sink += history.downsample(historyTime(0),
+                             historyTime(HISTORY_BENCH_SAMPLES), min, max,
+                             FRAMEBUFFER_WIDTH);
+}
+
+static void benchSettingsSave(void) {
+  settingsStorePos = 0;
+  sink += settingsSave(settings, writeStore, nullptr);
+}
+
+static void benchSettingsLoad(void) {
+  settingsStorePos = 0;
+  sink += settingsLoad(settings, readStore, nullptr);
+}
+
+struct BenchCase {
+  const char *name;
+  void (*fn)(void);
+};
+
+static const BenchCase CASES[] = {
+    {"render/frame", benchRenderFrame},
+    {"render/update", benchAppUpdate},
+    {"render/update-same", benchAppUpdateUnchanged},
+    {"render/clockText", benchClockText},
+    {"prim/hline", benchHLine},
+    {"prim/hline-pixels", benchHLinePixels},
+    {"prim/vline", benchVLine},
+    {"prim/vline-pixels", benchVLinePixels},
+    {"prim/fillRect", benchFillRect},
+    {"prim/fillRect-pixels", benchFillRectPixels},
+    {"time/formatTime", benchFormatTime},
+    {"time/formatDate", benchFormatDate},
+    {"time/tzLookup", benchTimeZoneLookup},
+    {"time/tzRules", benchTimeZoneRules},
+    {"json/state", benchParseState},
+    {"json/temperature", benchParseTemperature},
+    {"format/reading", benchFormatReading},
+    {"format/reading-printf", benchFormatReadingPrintf},
+    {"history/append", benchHistoryAppend},
+    {"history/stats-day", benchHistoryStats},
+    {"history/downsample-day", benchHistoryDownsample},
+    {"settings/template", benchTemplateExpansion},
+    {"settings/save", benchSettingsSave},
+    {"settings/load", benchSettingsLoad},
+};
+
+struct BenchResult {
+  char name[48];
+  double nsPerOp;
+  double allocsPerOp;
+  double bytesPerOp;
+};
+
+static double elapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+static BenchResult runCase(const BenchCase &c) {
+  BenchResult result;
+  unsigned long iterations = 1;
+
+  strncpy(result.name, c.name, sizeof(result.name) - 1);
+  result.name[sizeof(result.name) - 1] = '\0';
+
+  // grow the batch until it runs long enough to time reliably
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++) c.fn();
+    if (elapsedNs(start) >= BENCH_MIN_TIME_MS * 1e6 / BENCH_RUNS) break;
+    iterations *= 2;
+  }
+
+  result.nsPerOp = 0;
+  for (uint8_t run = 0; run < BENCH_RUNS; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < iterations; i++) c.fn();
+    double ns = elapsedNs(start) / iterations;
+
+    // the fastest run is the least disturbed by the host
+    if (run == 0 || ns < result.nsPerOp) result.nsPerOp = ns;
+  }
+
+  allocationCount = allocationBytes = 0;
+  countAllocations = true;
+  for (unsigned long i = 0; i < iterations; i++) c.fn();
+  countAllocations = false;
+
+  result.allocsPerOp = (double)allocationCount / iterations;
+  result.bytesPerOp = (double)allocationBytes / iterations;
+
+  return result;
+}
+
+static int loadBaseline(const char *path, BenchResult *baseline) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    perror(path);
+    return -1;
+  }
+
+  int count = 0;
+  while (count < BENCH_MAX_CASES &&
+         fscanf(file, "%47s %lf %lf %lf", baseline[count].name,
+                &baseline[count].nsPerOp, &baseline[count].allocsPerOp,
+                &baseline[count].bytesPerOp) == 4) {
+    count++;
+  }
+
+  fclose(file);
+  return count;
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--filter TEXT] [--save FILE] [--baseline FILE] "
+          "[--threshold PERCENT]\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  const char *filter = nullptr;
+  const char *savePath = nullptr;
+  const char *baselinePath = nullptr;
+  double threshold = BENCH_DEFAULT_THRESHOLD_PERCENT;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+      savePath = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baselinePath = argv[++i];
+    } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+      threshold = atof(argv[++i]);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  BenchResult baseline[BENCH_MAX_CASES];
+  int baselineCount = 0;
+  if (baselinePath && (baselineCount = loadBaseline(baselinePath, baseline)) < 0) {
+    return 1;
+  }
+
+  initClockAtlas();
+  initHistory();
+  initApp();
+  timeZone.set(TIME_ZONE_DEFAULT, FIXED_EPOCHS[0]);
+  timeZoneUtc = FIXED_EPOCHS[0];
+  memset(&settings, 0, sizeof(settings));
+  strcpy(settings.wifiSsid, "desk-display");
+  strcpy(settings.apiUrl, "http://homeassistant.local:8123/api/states/");
+  strcpy(settings.sleepTouchThreshold, defaultSleepTouchThreshold);
+  strcpy(settings.screenBrightness, defaultScreenBrightness);
+  strcpy(settings.httpRequestInterval, defaultHttpRequestInterval);
+  settings.isSetup = true;
+
+  FILE *save = savePath ? fopen(savePath, "w") : nullptr;
+  if (savePath && !save) {
+    perror(savePath);
+    return 1;
+  }
+
+  int regressions = 0;
+
+  printf("%-22s %12s %10s %10s %10s\n", "case", "ns/op", "allocs/op",
+         "bytes/op", "vs base");
+
+  for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+    if (filter && !strstr(CASES[i].name, filter)) continue;
+
+    BenchResult result = runCase(CASES[i]);
+    char delta[16] = "";
+    const char *verdict = "";
+
+    for (int b = 0; b < baselineCount; b++) {
+      if (strcmp(baseline[b].name, result.name) != 0) continue;
+
+      double change = (result.nsPerOp / baseline[b].nsPerOp - 1) * 100;
+      snprintf(delta, sizeof(delta), "%+.1f%%", change);
+
+      if (change > threshold || result.allocsPerOp > baseline[b].allocsPerOp) {
+        verdict = "  REGRESSION";
+        regressions++;
+      }
+    }
+
+    printf("%-22s %12.1f %10.2f %10.1f %10s%s\n", result.name, result.nsPerOp,
+           result.allocsPerOp, result.bytesPerOp, delta, verdict);
+
+    if (save) {
+      fprintf(save, "%s %.1f %.2f %.1f\n", result.name, result.nsPerOp,
+              result.allocsPerOp, result.bytesPerOp);
+    }
+  }
+
+  if (save) fclose(save);
+
+  if (regressions > 0) {
+    printf("%d case(s) regressed more than %.0f%% against %s\n", regressions,
+           threshold, baselinePath);
+    return 1;
+  }
+
+  return 0;
+}
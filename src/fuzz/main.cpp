@@ -0,0 +1,214 @@
+/**
+ * Fuzz driver for the sensor reading pipeline.
+ *
+ * Checks the fixed point parser and formatter against each other and against
+ * a reference, then throws mutated and generated HomeAssistant responses at
+ * haParseReading(). Every response sits in a heap block of exactly its size,
+ * so with the sanitizers (the native_fuzz env) a read past the end aborts.
+ *
+ *   desk_display_fuzz [--iterations N] [--seed N]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "HaSensor.h"
+#include "../native/fixtures.h"
+
+#define FUZZ_DEFAULT_ITERATIONS 200000
+#define FUZZ_MAX_RESPONSE 512
+
+static uint32_t rngState = 1;
+static unsigned long failures = 0;
+
+// xorshift32, the same sequence on every host for a seed
+static uint32_t nextRandom(void) {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static uint32_t randomBelow(uint32_t bound) {
+  return nextRandom() % bound;
+}
+
+static void fail(const char *what, const char *input, size_t length) {
+  if (failures++ < 10) {
+    printf("FAIL %s: '%.*s'\n", what, (int)length, input);
+  }
+}
+
+// every value, every precision: formatting and parsing back is lossless
+static void checkRoundTrip(void) {
+  char text[HA_FIXED_TEXT_SIZE];
+
+  for (int32_t value = INT16_MIN + 1; value <= INT16_MAX; value++) {
+    for (uint8_t decimals = 0; decimals <= HA_MAX_DECIMALS; decimals++) {
+      size_t length = haFormatFixed((int16_t)value, decimals, text, sizeof(text));
+      int16_t parsed;
+
+      if (!haParseFixed(text, length, decimals, parsed) || parsed != value) {
+        fail("round trip", text, length);
+      }
+    }
+  }
+}
+
+// digit by digit on the decimal string, independent of haParseFixed()'s
+// single pass
+static bool referenceFixed(bool negative, const char *whole, const char *fraction,
+                           uint8_t decimals, int16_t &value) {
+  int64_t result = 0;
+
+  for (const char *p = whole; *p; p++) {
+    result = result * 10 + (*p - '0');
+    if (result > 1000000) return false;
+  }
+  for (uint8_t i = 0; i < decimals; i++) {
+    result = result * 10 + (i < strlen(fraction) ? fraction[i] - '0' : 0);
+  }
+  if (strlen(fraction) > decimals && fraction[decimals] >= '5') result++;
+
+  if (result > INT16_MAX) return false;
+  value = (int16_t)(negative ? -result : result);
+  return true;
+}
+
+static void checkParseAgainstReference(unsigned long iterations) {
+  for (unsigned long i = 0; i < iterations; i++) {
+    char whole[8] = "", fraction[8] = "", text[24];
+    uint8_t wholeDigits = randomBelow(7), fractionDigits = randomBelow(7);
+    uint8_t decimals = randomBelow(HA_MAX_DECIMALS + 1);
+    bool negative = randomBelow(2), point = fractionDigits > 0 || randomBelow(2);
+
+    for (uint8_t d = 0; d < wholeDigits; d++) whole[d] = '0' + randomBelow(10);
+    for (uint8_t d = 0; d < fractionDigits; d++) fraction[d] = '0' + randomBelow(10);
+    int length = snprintf(text, sizeof(text), "%s%s%s%s", negative ? "-" : "",
+                          whole, point ? "." : "", fraction);
+
+    int16_t expected = 0, parsed = 0;
+    bool valid = (wholeDigits > 0 || fractionDigits > 0) &&
+                 referenceFixed(negative, whole, fraction, decimals, expected);
+    bool ok = haParseFixed(text, length, decimals, parsed);
+
+    if (ok != valid || (ok && parsed != expected)) fail("parse", text, length);
+  }
+}
+
+static void checkResponse(const char *response, size_t length) {
+  // exactly as large as the response, nothing after it to read by accident
+  char *exact = (char *)malloc(length ? length : 1);
+  memcpy(exact, response, length);
+
+  int16_t value;
+  haParseReading((const uint8_t *)exact, length, HA_SENSOR_TEMPERATURE, value);
+  haParseReading((const uint8_t *)exact, length, HA_WEATHER_TEMPERATURE, value);
+
+  free(exact);
+}
+
+static void checkMutatedResponses(unsigned long iterations) {
+  static const char *const SEEDS[] = {IN_SENSOR_RESPONSE, OUT_SENSOR_RESPONSE};
+  static const char INTERESTING[] = "{}[]\",:\\-.0123456789eEtn ";
+  char buffer[FUZZ_MAX_RESPONSE];
+
+  for (unsigned long i = 0; i < iterations; i++) {
+    const char *seed = SEEDS[randomBelow(2)];
+    size_t length = strlen(seed);
+    memcpy(buffer, seed, length);
+
+    for (uint8_t edits = 1 + randomBelow(4); edits > 0; edits--) {
+      size_t at = randomBelow(length + 1);
+
+      switch (randomBelow(4)) {
+      case 0: // overwrite
+        if (at < length) buffer[at] = INTERESTING[randomBelow(sizeof(INTERESTING) - 1)];
+        break;
+      case 1: // insert
+        if (length < sizeof(buffer)) {
+          memmove(buffer + at + 1, buffer + at, length - at);
+          buffer[at] = INTERESTING[randomBelow(sizeof(INTERESTING) - 1)];
+          length++;
+        }
+        break;
+      case 2: // delete
+        if (at < length) {
+          memmove(buffer + at, buffer + at + 1, length - at - 1);
+          length--;
+        }
+        break;
+      default: // cut
+        length = at;
+        break;
+      }
+    }
+
+    checkResponse(buffer, length);
+  }
+}
+
+// well formed responses with the value somewhere among unrelated members
+static void checkGeneratedResponses(unsigned long iterations) {
+  static const char *const FILLERS[] = {
+      "\"a\":1", "\"b\":\"x\\\"y\"", "\"c\":[1,{\"d\":[]},\"]\"]",
+      "\"e\":{\"temperature\":99}", "\"f\":null", "\"g\":-1.5e3"};
+  char response[FUZZ_MAX_RESPONSE];
+
+  for (unsigned long i = 0; i < iterations; i++) {
+    int16_t expected = (int16_t)(randomBelow(2001) - 1000);
+    bool weather = randomBelow(2);
+    char value[HA_FIXED_TEXT_SIZE];
+    haFormatFixed(expected, 1, value, sizeof(value));
+
+    size_t length = snprintf(response, sizeof(response), "{");
+    for (uint8_t f = randomBelow(4); f > 0; f--) {
+      length += snprintf(response + length, sizeof(response) - length, "%s, ",
+                         FILLERS[randomBelow(6)]);
+    }
+    if (weather) {
+      length += snprintf(response + length, sizeof(response) - length,
+                         "\"attributes\": { %s, \"temperature\" : %s }",
+                         FILLERS[randomBelow(6)], value);
+    } else {
+      length += snprintf(response + length, sizeof(response) - length,
+                         "\"state\":\"%s\"", value);
+    }
+    length += snprintf(response + length, sizeof(response) - length, ", %s}",
+                       FILLERS[randomBelow(6)]);
+
+    int16_t parsed;
+    DeserializationError error = haParseReading(
+        (const uint8_t *)response, length,
+        weather ? HA_WEATHER_TEMPERATURE : HA_SENSOR_TEMPERATURE, parsed);
+    if (error || parsed != expected) fail("generated", response, length);
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [--iterations N] [--seed N]\n", name);
+}
+
+int main(int argc, char **argv) {
+  unsigned long iterations = FUZZ_DEFAULT_ITERATIONS;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      rngState = strtoul(argv[++i], nullptr, 10);
+      if (rngState == 0) rngState = 1;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  checkRoundTrip();
+  checkParseAgainstReference(iterations);
+  checkMutatedResponses(iterations);
+  checkGeneratedResponses(iterations);
+
+  printf("%lu iterations a check, %lu failures\n", iterations, failures);
+  return failures > 0;
+}
@@ -0,0 +1,453 @@
+/**
+ * End-to-end load driver for the HomeAssistant fetch pipeline.
+ *
+ * Polls 1 to 50 entities through the loopback HomeAssistant stand-in with
+ * configurable latency, jitter, payload size, 401/500 error rate, slow-loris
+ * responses and TLS handshake cost. Each request has an arena sized like the
+ * firmware's, holding its URL and then its response, and LoopbackHttp's
+ * callback hands every response to DeskApp::handleSensorResponse(), the
+ * firmware's sensor handler. The AsyncHTTPRequest plumbing around it is only
+ * mimicked. Reports latency percentiles, throughput, peak heap, the largest
+ * request arena and how the failures were handled. Time is virtual, so a ten
+ * minute run takes a moment.
+ *
+ *   desk_display_loadtest [--entities N | --sweep] [--seconds N]
+ *       [--interval-ms N] [--delay-ms N] [--jitter-ms N] [--payload BYTES]
+ *       [--error-rate PERMILLE] [--slow-rate PERMILLE] [--slow-ms N]
+ *       [--tls-ms N] [--timeout-ms N] [--seed N]
+ */
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "DeskApp.h"
+#include "DisplayPipeline.h"
+#include "FetchArena.h"
+#include "Framebuffer.h"
+#include "HaSensor.h"
+#include "Hal.h"
+#include "LoopbackHttp.h"
+#include "PanelFanout.h"
+#include "StockTicker.h"
+#include "TimeSeries.h"
+#include "TimerWheel.h"
+
+#define LOADTEST_MAX_ENTITIES 50
+#define LOADTEST_MAX_SAMPLES 65536
+#define LOADTEST_POLL_MS 1
+#define LOADTEST_URL_SIZE 96
+// the firmware's sensor request arena: API URL and entity id settings, then
+// the response
+#define LOADTEST_ARENA_SIZE (2 * 256 + 4096)
+
+static const char API_URL[] = "http://homeassistant.local:8123/api/states/";
+// 2022-11-02T18:41:09Z, the virtual clock counts from there
+#define LOADTEST_START_EPOCH 1667414469UL
+
+// heap accounting for everything running inside a load run, like the
+// bench's, with every allocation carrying its size in front of it so the
+// peak of what is live can be tracked
+static bool countAllocations = false;
+static size_t heapLive = 0;
+static size_t heapPeak = 0;
+static unsigned long heapAllocations = 0;
+
+#define HEAP_HEADER 16
+// keeps the header arithmetic out of the callers, where it confuses -Warray-bounds
+#define HEAP_HOOK __attribute__((noinline))
+
+HEAP_HOOK void *operator new(size_t size) {
+  uint8_t *p = (uint8_t *)malloc(size + HEAP_HEADER);
+  if (!p) throw std::bad_alloc();
+
+  // allocations from before the run are freed as if they were never counted
+  *(size_t *)p = countAllocations ? size : 0;
+  if (countAllocations) {
+    heapLive += size;
+    heapAllocations++;
+    if (heapLive > heapPeak) heapPeak = heapLive;
+  }
+
+  return p + HEAP_HEADER;
+}
+
+HEAP_HOOK void *operator new[](size_t size) { return operator new(size); }
+
+HEAP_HOOK void operator delete(void *p) noexcept {
+  if (!p) return;
+
+  uint8_t *block = (uint8_t *)p - HEAP_HEADER;
+  heapLive -= *(size_t *)block;
+  free(block);
+}
+
+HEAP_HOOK void operator delete[](void *p) noexcept { operator delete(p); }
+HEAP_HOOK void operator delete(void *p, size_t) noexcept { operator delete(p); }
+HEAP_HOOK void operator delete[](void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+struct LoadConfig {
+  uint8_t entities;
+  uint32_t seconds;
+  uint32_t intervalMs;
+  uint32_t delayMs;
+  uint32_t payloadBytes;
+  uint32_t timeoutMs;
+  LoopbackHttpFaults faults;
+};
+
+struct Entity {
+  char url[LOADTEST_URL_SIZE];
+  // the entity id at the end of url, what the settings hold
+  const char *id;
+  StaticFetchArena<LOADTEST_ARENA_SIZE> arena;
+  char *body;
+  bool weather;
+  bool inFlight;
+  uint32_t sentMs;
+};
+
+struct LoadStats {
+  unsigned long sent;
+  unsigned long ok;
+  unsigned long httpErrors;
+  unsigned long timeouts;
+  unsigned long busySkips;
+  unsigned long parseFailures;
+  unsigned long sampleCount;
+  size_t arenaPeak;
+  uint32_t samples[LOADTEST_MAX_SAMPLES];
+};
+
+static Entity entities[LOADTEST_MAX_ENTITIES];
+static uint8_t entityCount = 0;
+static LoadStats stats;
+static LoopbackHttp *http;
+
+// the firmware's display logic, only its sensor handler is driven here
+class NullTransport : public DisplayTransport {
+  public:
+    void sendFrame(const uint8_t *) override {}
+};
+
+static uint8_t appFrames[2][FRAMEBUFFER_SIZE];
+static Framebuffer appScreen(appFrames[0]);
+static NullTransport appTransport;
+static DisplayPipeline appPipeline(appTransport);
+static PanelFanout appFanout;
+static TimerWheel appScheduler(halMillis);
+static StockTicker appStocks;
+static uint8_t appInsideBuffer[HISTORY_RAM_SIZE];
+static uint8_t appOutsideBuffer[HISTORY_RAM_SIZE];
+static TimeSeries appInsideHistory(appInsideBuffer, sizeof(appInsideBuffer));
+static TimeSeries appOutsideHistory(appOutsideBuffer, sizeof(appOutsideBuffer));
+static DeskApp app(appScreen, appPipeline, appFanout, appScheduler, appStocks,
+                   appInsideHistory, appOutsideHistory);
+
+static uint32_t appUtcEpoch(void) {
+  return LOADTEST_START_EPOCH + halMillis() / 1000;
+}
+
+static uint32_t appMsUntilNextSecond(void) {
+  return 1000 - halMillis() % 1000;
+}
+
+static void appAttachFrame(uint8_t *frame) {
+  appScreen.attach(frame);
+}
+
+static void appPresentFrame(void) {
+  appPipeline.swap();
+  appPipeline.transferPending();
+  appScreen.attach(appPipeline.backBuffer());
+}
+
+static const DeskAppHooks APP_HOOKS = {
+    appUtcEpoch,    appMsUntilNextSecond, nullptr,
+    appAttachFrame, appPresentFrame,      nullptr,
+    nullptr,        nullptr,              nullptr,
+    nullptr,
+};
+
+static char *buildBody(uint8_t index, bool weather, uint32_t payloadBytes) {
+  char head[256];
+  int headLength;
+
+  if (weather) {
+    headLength = snprintf(
+        head, sizeof(head),
+        "{\"entity_id\":\"weather.load_%02u\",\"state\":\"cloudy\","
+        "\"attributes\":{\"temperature\":%d.%u,\"humidity\":81,"
+        "\"friendly_name\":\"Load %u\",\"padding\":\"",
+        index, (index % 30) - 10, index % 10, index);
+  } else {
+    headLength = snprintf(
+        head, sizeof(head),
+        "{\"entity_id\":\"sensor.load_%02u\",\"state\":\"2%u.%u\","
+        "\"attributes\":{\"unit_of_measurement\":\"C\","
+        "\"friendly_name\":\"Load %u\",\"padding\":\"",
+        index, index % 10, (index * 7) % 10, index);
+  }
+
+  static const char TAIL[] =
+      "\"},\"last_changed\":\"2022-11-02T18:41:09.514862+00:00\","
+      "\"last_updated\":\"2022-11-02T18:41:09.514862+00:00\"}";
+  size_t fixed = headLength + sizeof(TAIL) - 1;
+  size_t padding = payloadBytes > fixed ? payloadBytes - fixed : 0;
+
+  char *body = (char *)malloc(fixed + padding + 1);
+  memcpy(body, head, headLength);
+  memset(body + headLength, 'x', padding);
+  memcpy(body + headLength + padding, TAIL, sizeof(TAIL));
+
+  return body;
+}
+
+static void onResponse(void *arg, int status, const char *body, size_t length) {
+  Entity *entity = (Entity *)arg;
+  uint32_t latency = halMillis() - entity->sentMs;
+
+  entity->inFlight = false;
+  if (stats.sampleCount < LOADTEST_MAX_SAMPLES) {
+    stats.samples[stats.sampleCount++] = latency;
+  }
+
+  // readResponse(): a 200 is read into the rest of the arena, a longer body
+  // is cut off
+  size_t spare;
+  uint8_t *response = entity->arena.spare(spare);
+  if (status == 200) {
+    if (length > spare) length = spare;
+    memcpy(response, body, length);
+    entity->arena.commit(length);
+  } else {
+    length = 0;
+  }
+  if (entity->arena.used() > stats.arenaPeak) {
+    stats.arenaPeak = entity->arena.used();
+  }
+
+  // apiSensorReadReqCb()
+  app.setActivity(false);
+  bool taken = app.handleSensorResponse(
+      entity->weather ? DESK_APP_OUTSIDE : DESK_APP_INSIDE, status, response,
+      length);
+
+  if (status == LOOPBACK_HTTP_TIMEOUT) {
+    stats.timeouts++;
+  } else if (status != 200) {
+    stats.httpErrors++;
+  } else if (taken) {
+    stats.ok++;
+  } else {
+    stats.parseFailures++;
+  }
+
+  entity->arena.reset();
+}
+
+static void sendAll(void) {
+  for (uint8_t i = 0; i < entityCount; i++) {
+    Entity &entity = entities[i];
+
+    // one request object per entity, like sendApiRequest()
+    if (entity.inFlight) {
+      stats.busySkips++;
+      continue;
+    }
+
+    // the URL goes into the request's arena like in sendApiRequest(), the
+    // auth header is built once when the settings change
+    entity.arena.reset();
+    char *url = entity.arena.concat(API_URL, entity.id);
+
+    if (http->get(url, onResponse, &entity)) {
+      app.setActivity(true);
+      entity.inFlight = true;
+      entity.sentMs = halMillis();
+      stats.sent++;
+    } else {
+      entity.arena.reset();
+      stats.busySkips++;
+    }
+  }
+}
+
+static int compareSamples(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static uint32_t percentile(uint8_t p) {
+  if (stats.sampleCount == 0) return 0;
+
+  return stats.samples[(stats.sampleCount - 1) * p / 100];
+}
+
+static void runLoad(const LoadConfig &config) {
+  LoopbackHttp loopback;
+  TimerWheel scheduler(halMillis);
+
+  http = &loopback;
+  entityCount = config.entities;
+  memset(&stats, 0, sizeof(stats));
+  halSimSetMillis(0);
+
+  loopback.setFaults(config.faults);
+  loopback.setTimeout(config.timeoutMs);
+
+  for (uint8_t i = 0; i < entityCount; i++) {
+    Entity &entity = entities[i];
+
+    entity.weather = i & 1;
+    snprintf(entity.url, sizeof(entity.url), "%s%s.load_%02u", API_URL,
+             entity.weather ? "weather" : "sensor", i);
+    entity.id = entity.url + strlen(API_URL);
+    entity.body = buildBody(i, entity.weather, config.payloadBytes);
+    entity.inFlight = false;
+
+    loopback.route(entity.url, 200, entity.body, config.delayMs);
+  }
+
+  scheduler.attach("fetch", config.intervalMs, 0, TIMER_WHEEL_PRIORITY_LOW,
+                   sendAll);
+
+  heapLive = heapPeak = 0;
+  heapAllocations = 0;
+  countAllocations = true;
+  auto wallStart = std::chrono::steady_clock::now();
+
+  sendAll();
+
+  uint32_t endMs = config.seconds * 1000;
+  while (halMillis() < endMs) {
+    uint32_t waitMs = scheduler.msUntilNextWake();
+
+    if (loopback.inFlight() > 0 && waitMs > LOADTEST_POLL_MS) {
+      waitMs = LOADTEST_POLL_MS;
+    }
+    if (waitMs > endMs - halMillis()) waitMs = endMs - halMillis();
+
+    halSimAdvance(waitMs);
+    loopback.poll();
+    scheduler.tick();
+  }
+
+  double wallMs = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - wallStart)
+                      .count();
+  countAllocations = false;
+
+  qsort(stats.samples, stats.sampleCount, sizeof(stats.samples[0]),
+        compareSamples);
+
+  unsigned long completed = stats.sampleCount;
+  printf("%8u %7lu %7lu %6lu %6lu %6lu %6lu %7u %7u %7u %7u %9.1f %8zu "
+         "%8zu %7.2f %8.0fx\n",
+         config.entities, stats.sent, stats.ok, stats.httpErrors,
+         stats.timeouts, stats.parseFailures, stats.busySkips, percentile(50),
+         percentile(90), percentile(99),
+         completed ? stats.samples[completed - 1] : 0,
+         stats.ok * 1000.0 / endMs * 60, heapPeak, stats.arenaPeak,
+         completed ? (double)heapAllocations / completed : 0.0,
+         endMs / (wallMs > 0 ? wallMs : 1));
+
+  for (uint8_t i = 0; i < entityCount; i++) {
+    free(entities[i].body);
+  }
+}
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--entities N | --sweep] [--seconds N] [--interval-ms N]\n"
+          "       [--delay-ms N] [--jitter-ms N] [--payload BYTES]\n"
+          "       [--error-rate PERMILLE] [--slow-rate PERMILLE] [--slow-ms N]\n"
+          "       [--tls-ms N] [--timeout-ms N] [--seed N]\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  static const uint8_t SWEEP[] = {1, 5, 10, 25, 50};
+  LoadConfig config = LoadConfig();
+  bool sweep = false;
+
+  config.entities = 2;
+  config.seconds = 600;
+  config.intervalMs = 60000;
+  config.delayMs = 120;
+  config.payloadBytes = 512;
+  // AsyncHTTPRequest default
+  config.timeoutMs = 3000;
+  config.faults.jitterMs = 80;
+  config.faults.slowDelayMs = 10000;
+  config.faults.seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(argv[i], "--sweep") == 0) {
+      sweep = true;
+    } else if (strcmp(argv[i], "--entities") == 0 && hasValue) {
+      config.entities = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && hasValue) {
+      config.seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--interval-ms") == 0 && hasValue) {
+      config.intervalMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--delay-ms") == 0 && hasValue) {
+      config.delayMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--jitter-ms") == 0 && hasValue) {
+      config.faults.jitterMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--payload") == 0 && hasValue) {
+      config.payloadBytes = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--error-rate") == 0 && hasValue) {
+      config.faults.errorPermille = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--slow-rate") == 0 && hasValue) {
+      config.faults.slowPermille = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--slow-ms") == 0 && hasValue) {
+      config.faults.slowDelayMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--tls-ms") == 0 && hasValue) {
+      config.faults.handshakeMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--timeout-ms") == 0 && hasValue) {
+      config.timeoutMs = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+      config.faults.seed = strtoul(argv[++i], nullptr, 10);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (config.entities < 1 || config.entities > LOADTEST_MAX_ENTITIES ||
+      config.intervalMs == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  app.setHooks(APP_HOOKS);
+  appPipeline.attach(appFrames[0], appFrames[1]);
+
+  printf("%u s, every %u ms, %u+%u ms latency, %u B payload, "
+         "%u/1000 errors, %u/1000 slow, %u ms TLS, %u ms timeout\n",
+         config.seconds, config.intervalMs, config.delayMs,
+         config.faults.jitterMs, config.payloadBytes,
+         config.faults.errorPermille, config.faults.slowPermille,
+         config.faults.handshakeMs, config.timeoutMs);
+  printf("%8s %7s %7s %6s %6s %6s %6s %7s %7s %7s %7s %9s %8s %8s %7s %9s\n",
+         "entities", "sent", "ok", "http", "tmout", "parse", "busy", "p50 ms",
+         "p90 ms", "p99 ms", "max ms", "ok/min", "peak B", "arena B",
+         "alloc/r", "speed");
+
+  if (sweep) {
+    for (size_t i = 0; i < sizeof(SWEEP); i++) {
+      config.entities = SWEEP[i];
+      runLoad(config);
+    }
+  } else {
+    runLoad(config);
+  }
+
+  return 0;
+}
@@ -1,8 +1,31 @@
+#include "BootCache.h"
+#include "DeskApp.h"
+#include "DisplayPipeline.h"
+#include "FetchArena.h"
+#include "Framebuffer.h"
+#include "GlyphAtlas.h"
+#include "HaSensor.h"
+#include "Hal.h"
+#include "InputLog.h"
+#include "LiveEvents.h"
+#include "LogPrint.h"
+#include "Logger.h"
 #include "NTPClient.h"
+#include "PanelFanout.h"
+#include "PowerLedger.h"
+#include "Screens.h"
+#include "Settings.h"
+#include "Ssd1306WireTransport.h"
+#include "StockTicker.h"
+#include "TimeFormat.h"
+#include "TimeSeries.h"
+#include "TimeSeriesFileSpill.h"
+#include "TimeZone.h"
+#include "TimerWheel.h"
+#include "TouchGestures.h"
+#include "Widgets.h"
 #include <Arduino.h>
-#define ARDUINOJSON_USE_DOUBLE 0
 #include "SPIFFS.h"
-#include <ArduinoJson.h>
 #include <AsyncHTTPRequest_Generic.h>
 #include <AsyncTCP.h>
 #include <EEPROM.h>
@@ -10,10 +33,13 @@
 #include <FS.h>
 #include <SPI.h>
 #include <SSD1306Wire.h>
-#include <Ticker.h>
 #include <WiFi.h>
 #include <WiFiUdp.h>
 #include <Wire.h>
+#include <atomic>
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <sys/time.h>
 
 #include "srcsecrets.h"
 /**
@@ -34,114 +60,534 @@ RTC_DATA_ATTR int bootCount = 0;
 
 static const unsigned long WIFI_TIMEOUT_MILLIS = 15000;
 
-#define CONFIG_TEXT_MAX_LENGTH 256
 #define CONFIG_FILE_NAME "/.config"
-static const char *defaultHttpRequestInterval = "60";
-static const char *defaultSleepTouchThreshold = "long";
-static const char *defaultScreenBrightness = "dim";
-
-struct DeviceSettings {
-  // internal flags
-  bool isSetup;
-  // wifi settings
-  char wifiSsid[CONFIG_TEXT_MAX_LENGTH];
-  char wifiPassword[CONFIG_TEXT_MAX_LENGTH];
-  // home assistant rest api settings
-  char apiUrl[CONFIG_TEXT_MAX_LENGTH];
-  char authToken[CONFIG_TEXT_MAX_LENGTH];
-  char inSensorId[CONFIG_TEXT_MAX_LENGTH];
-  char outSensorId[CONFIG_TEXT_MAX_LENGTH];
-  // device settings
-  bool displayWifiIndicator;
-  char httpRequestInterval[CONFIG_TEXT_MAX_LENGTH];
-  char sleepTouchThreshold[CONFIG_TEXT_MAX_LENGTH];
-  char screenBrightness[CONFIG_TEXT_MAX_LENGTH];
-  bool invertScreen;
-  bool debugMode;
-};
 
 DeviceSettings deviceSettings;
 
-#define NTP_OFFSET 19800 // In seconds
-
 #define NTP_INTERVAL 60 * 1000 // In miliseconds
 
 #define NTP_ADDRESS "lv.pool.ntp.org"
 
 WiFiUDP ntpUDP;
 
-NTPClient timeClient(ntpUDP, NTP_ADDRESS, NTP_OFFSET, NTP_INTERVAL);
+// local time comes from timeZone, the client itself keeps UTC
+NTPClient timeClient(ntpUDP, NTP_ADDRESS, 0, NTP_INTERVAL);
+
+TimeZone timeZone;
 
 #define OLED_ROTATION 0x3c
 #define OLED_SCL 22
 #define OLED_SDA 21
+// the driver's default, panels that cope can run the bus faster with
+// -DOLED_I2C_FREQUENCY=1000000
+#ifndef OLED_I2C_FREQUENCY
+#define OLED_I2C_FREQUENCY 700000
+#endif
+
+SSD1306Wire display(OLED_ROTATION, OLED_SDA, OLED_SCL, GEOMETRY_128_64,
+                    I2C_ONE, OLED_I2C_FREQUENCY); // ADDRESS, SDA, SCL
+// portable drawing into the display's own buffer, attached in initDisplay()
+Framebuffer screen;
+
+// frames are rendered into one buffer while the other is on the bus, the
+// driver's buffer pointer follows the back buffer, see presentFrame()
+uint8_t secondDisplayBuffer[FRAMEBUFFER_SIZE];
+Ssd1306WireTransport displayTransport(Wire, OLED_ROTATION);
+DisplayPipeline displayPipeline(displayTransport);
+TaskHandle_t displayTransferTask = NULL;
+
+// Panels besides the main one on the same bus, each showing one page for
+// good. Those at the main panel's address sit behind a TCA9548A, on the
+// channel given. The clock page is a copy of the main panel's frame.
+#ifndef EXTRA_PANEL_COUNT
+#define EXTRA_PANEL_COUNT 0
+#endif
+// what setBrightness(32) sets on the main panel
+#define EXTRA_PANEL_CONTRAST 37
+
+struct ExtraPanel {
+  uint8_t address;
+  uint8_t muxChannel;
+  // 0 for the clock, 1 for the first stock and so on, or DESK_APP_HISTORY_PAGE
+  uint8_t page;
+};
 
-SSD1306Wire display(OLED_ROTATION, OLED_SDA, OLED_SCL); // ADDRESS, SDA, SCL
+// the first EXTRA_PANEL_COUNT are used
+const ExtraPanel EXTRA_PANELS[PANEL_FANOUT_MAX_PANELS] = {
+    {OLED_ROTATION, 0, 1},
+    {OLED_ROTATION, 1, DESK_APP_HISTORY_PAGE},
+    {OLED_ROTATION, 2, 2},
+    {OLED_ROTATION, 3, 0},
+};
+static_assert(EXTRA_PANEL_COUNT <= PANEL_FANOUT_MAX_PANELS,
+              "more extra panels than PanelFanout takes");
+
+PanelFanout panelFanout;
+Ssd1306WireTransport *extraTransports[PANEL_FANOUT_MAX_PANELS];
+uint16_t panelBusMs =
+    panelFrameBusMs(OLED_I2C_FREQUENCY, SSD1306_WIRE_CHUNK_SIZE);
+
+// glyphs pre-rasterized once at boot, see initGlyphAtlas()
+#define FONT_PAGES(font) ((font[HEIGHT_POS] + 7) / 8)
+#define DEGREE_SIGN_CODE 0xB0
+static const char CLOCK_GLYPHS[] = "0123456789:-";
+static const char TEXT_GLYPHS[] = "0123456789-.| C";
+static const char *DAY_NAMES[] = {"Sun", "Mon", "Tue", "Wed",
+                                  "Thu", "Fri", "Sat"};
+GlyphAtlas clockAtlas(FONT_PAGES(ArialMT_Plain_24));
+GlyphAtlas textAtlas(FONT_PAGES(ArialMT_Plain_10));
+// day names as whole words, keyed by '0' + day of the week
+GlyphAtlas dayAtlas(FONT_PAGES(ArialMT_Plain_10));
 
 #define _ASYNC_HTTP_LOGLEVEL_ 0
 AsyncHTTPRequest inTempRequest;
 AsyncHTTPRequest outTempRequest;
 AsyncHTTPRequest stockPriceRequest;
+StockTicker stockTicker;
+// symbol the request in flight is for
+uint8_t stockRequestSymbol = 0;
 
-StaticJsonDocument<48> sensorDoc;
-StaticJsonDocument<16> sensorValueFilter;
-
-StaticJsonDocument<96> outSensorDoc;
-StaticJsonDocument<32> outSensorValueFilter;
-
-static const PROGMEM char SENSOR_UNAVAILABLE_STR[] = "unavailable";
-static const PROGMEM char SENSOR_NO_VALUE_STR[] = "-.-";
-
-// Variables to save date and time
-String formattedDateTime;
-String formattedTime;
-String formattedDate;
-String timeStamp;
 // JSON request variables
 #define SENSOR_RESPONSE_BUFFER_SIZE 4096
-uint8_t sensorResponseBuffer[SENSOR_RESPONSE_BUFFER_SIZE];
-RTC_DATA_ATTR char insideTempSensorReading[5] = "-.-";
-RTC_DATA_ATTR char outsideTempSensorReading[5] = "-.-";
-
-#define HTTP_REQUEST_INTERVAL 60
-// poll every 100ms for user interaction
-#define UI_LOOP_INTERVAL 0.1
-#define MAIN_EVENT_LOOP_INTERVAL 0.5
-// API calls every 60 seconds that update the data
-Ticker inTempRequestTicker;
-Ticker outTempRequestTicker;
-Ticker stockPriceRequestTicker;
+// a quote is a flat object of eight numbers
+#define STOCK_RESPONSE_BUFFER_SIZE 512
+// Each request has an arena of its own holding the URL it was opened with and
+// then its response, until the handler is done with both. A sensor URL is
+// the API URL and the entity id, each a settings field.
+#define SENSOR_FETCH_ARENA_SIZE \
+  (2 * CONFIG_TEXT_MAX_LENGTH + SENSOR_RESPONSE_BUFFER_SIZE)
+#define STOCK_FETCH_ARENA_SIZE \
+  (STOCK_QUOTE_URL_SIZE + STOCK_RESPONSE_BUFFER_SIZE)
+StaticFetchArena<SENSOR_FETCH_ARENA_SIZE> inTempArena;
+StaticFetchArena<SENSOR_FETCH_ARENA_SIZE> outTempArena;
+StaticFetchArena<STOCK_FETCH_ARENA_SIZE> stockArena;
+// by requestIndex()
+FetchArena *const fetchArenas[] = {&inTempArena, &outTempArena, &stockArena};
+static const char *FETCH_NAMES[] = {"inTemp", "outTemp", "stock"};
+// the URL each request was opened with, in its arena
+const char *requestUrls[] = {"", "", ""};
+// From send() until the handler has released the arena. readyState() turns
+// done before the callback runs on the AsyncTCP task, so it can't tell
+// whether the arena is still being read.
+std::atomic<bool> requestBusy[] = {{false}, {false}, {false}};
+// built from the settings whenever they change, see buildRequestHeaders()
+char apiAuthHeader[sizeof(" Bearer ") + CONFIG_TEXT_MAX_LENGTH];
+
+// a reading a minute in tenths of a degree, 0.5-1.6KB a day depending on how
+// noisy it is: the RAM blocks hold a day or more, the flash slots a week more
+#define HISTORY_FLASH_SLOTS 64
+static_assert(HISTORY_FLASH_SLOTS <= TIME_SERIES_MAX_SPILL_SLOTS,
+              "TimeSeries only keeps the time ranges of TIME_SERIES_MAX_SPILL_SLOTS slots");
+uint8_t insideHistoryBuffer[HISTORY_RAM_SIZE];
+uint8_t outsideHistoryBuffer[HISTORY_RAM_SIZE];
+TimeSeries insideHistory(insideHistoryBuffer, sizeof(insideHistoryBuffer));
+TimeSeries outsideHistory(outsideHistoryBuffer, sizeof(outsideHistoryBuffer));
+TimeSeriesFileSpill insideHistorySpill(SPIFFS, "/history_in", HISTORY_FLASH_SLOTS);
+TimeSeriesFileSpill outsideHistorySpill(SPIFFS, "/history_out", HISTORY_FLASH_SLOTS);
+
+// last known readings and time, so the first frame after boot needs nothing
+// from the network. RTC memory gets every update, flash only changed readings
+// and at most every 15 minutes.
+#define BOOT_CACHE_FILE_NAME "/.boot"
+#define BOOT_CACHE_UPDATE_INTERVAL_MS 60000
+#define BOOT_CACHE_UPDATE_COALESCE_MS 10000
+#define BOOT_CACHE_SAVE_INTERVAL_MS (15 * 60 * 1000)
+RTC_DATA_ATTR BootSnapshot rtcBootSnapshot;
+BootSnapshot savedBootSnapshot;
+unsigned long bootSnapshotSavedAt = 0;
+// false while there is no time to go by, e.g. after a power loss
+bool clockKnown = true;
+
+// the job timings shared with the simulator are in DeskApp.h
+// scheduler overrun/jitter report in debug mode
+#define SCHEDULER_STATS_INTERVAL_MS 60000
 
 AsyncWebServer server(80);
+// GET /events pushes state changes to at most this many viewers, each one
+// holds a TCP connection and a message queue
+#define LIVE_EVENTS_MAX_CLIENTS 4
+AsyncEventSource liveEvents("/events");
+// last state pushed, also read by the web server's task when a viewer connects
+LiveState liveState;
+uint32_t liveEventId = 0;
+portMUX_TYPE liveStateMux = portMUX_INITIALIZER_UNLOCKED;
+
+// in debug mode every input since the scheduler started is kept in RAM for
+// GET /inputs.bin, the simulator replays it with --replay. Around 20 minutes
+// of sensor and quote responses fit, recording stops when it is full.
+#define INPUT_LOG_BUFFER_SIZE (32 * 1024)
+uint8_t *inputLogBuffer = NULL;
+size_t inputLogLength = 0;
+unsigned long inputLogStartMs = 0;
+// a mutex rather than a critical section: an HTTP record copies its URL and
+// body, up to 4KB, and that must not hold off interrupts or the other core
+SemaphoreHandle_t inputLogMutex = NULL;
+// what was recorded last, touch is recorded when it changes and WiFi when
+// the icon would
+uint16_t recordedTouch = 0;
+bool touchRecorded = false;
+bool recordedWiFiConnected = false;
+uint8_t recordedWiFiBars = 0;
+bool wifiRecorded = false;
+unsigned long recordedClockUpdate = 0;
+
+// called with inputLogMutex held, takes whole pieces only
+size_t appendInputLog(void *ctx, const uint8_t *data, size_t length) {
+  if (length > INPUT_LOG_BUFFER_SIZE - inputLogLength) return 0;
+
+  memcpy(inputLogBuffer + inputLogLength, data, length);
+  inputLogLength += length;
+  return length;
+}
+
+InputLogWriter inputLog(appendInputLog, NULL, INPUT_LOG_BUFFER_SIZE);
 
 #define TOUCH_PIN T0
-#define TOUCH_TRESHOLD 100 // touch is below 100
+#define TOUCH_TRESHOLD 100 // touch is below 100, until a baseline is measured
+
+// the touch interrupt only wakes the scheduler, gestures are recognized by
+// sampling the pad from touchJob while one is in progress
+TouchGestures touchGestures(TOUCH_TRESHOLD * 100 / TOUCH_GESTURES_PRESS_PERCENT,
+                            SLEEP_TOUCH_THRESHOLD_LONG);
+volatile bool touchInterruptPending = false;
+volatile bool touchSampling = false;
+
+// one task runs every periodic job, sleeping until the next due deadline or
+// until an interrupt notifies it
+TimerWheel scheduler(halMillis);
+TaskHandle_t schedulerTask = NULL;
+// set by /save, the scheduler task takes up the new settings on its next pass
+volatile bool settingsSaved = false;
+
+// readings, pages, frames and touch, run by the simulator too. The hooks are
+// set in setup(), see APP_HOOKS.
+DeskApp app(screen, displayPipeline, panelFanout, scheduler, stockTicker,
+            insideHistory, outsideHistory);
+
+// draws on display on every second boundary, twice a second while animating
+int8_t mainEventLoopJob = TIMER_WHEEL_INVALID_JOB;
+// samples the touch pad every 20ms, only while a gesture is in progress
+int8_t touchJob = TIMER_WHEEL_INVALID_JOB;
+int8_t touchBaselineJob = TIMER_WHEEL_INVALID_JOB;
+int8_t inTempRequestJob = TIMER_WHEEL_INVALID_JOB;
+int8_t outTempRequestJob = TIMER_WHEEL_INVALID_JOB;
+int8_t stockRequestJob = TIMER_WHEEL_INVALID_JOB;
+int8_t historyJob = TIMER_WHEEL_INVALID_JOB;
+int8_t bootCacheJob = TIMER_WHEEL_INVALID_JOB;
+
+// records are formatted on the task that logs them and written to the UART by
+// a task of its own, the last few are kept for GET /logs
+#define LOG_HISTORY_RECORDS 16
+// how long going to sleep waits for the log to reach the UART
+#define LOG_DRAIN_TIMEOUT_MS 100
+TaskHandle_t logTask = NULL;
+LogRecord logHistory[LOG_HISTORY_RECORDS];
+uint32_t logHistoryCount = 0;
+portMUX_TYPE logHistoryMux = portMUX_INITIALIZER_UNLOCKED;
+// for the stats, which are printed rather than logged line by line
+LogPrint debugLog(LOG_LEVEL_DEBUG);
+
+// DFS range in power save mode, WiFi needs at least 80MHz
+#define POWER_SAVE_MIN_FREQ_MHZ 80
+#define POWER_SAVE_MAX_FREQ_MHZ 240
+PowerLedger powerLedger;
+portMUX_TYPE powerLedgerMux = portMUX_INITIALIZER_UNLOCKED;
+// PM locks for the ledger's activities, NULL without power management
+esp_pm_lock_handle_t powerLocks[POWER_ACTIVITY_COUNT] = {};
+const char *powerMode = "off";
+bool powerSaveOn = false;
+// one bit per HTTP request holding POWER_ACTIVITY_NETWORK
+uint8_t requestsInFlight = 0;
+
+void powerBegin(uint8_t activity) {
+  if (powerLocks[activity] != NULL) esp_pm_lock_acquire(powerLocks[activity]);
+
+  portENTER_CRITICAL(&powerLedgerMux);
+  powerLedger.begin(activity, esp_timer_get_time());
+  portEXIT_CRITICAL(&powerLedgerMux);
+}
+
+void powerEnd(uint8_t activity) {
+  portENTER_CRITICAL(&powerLedgerMux);
+  powerLedger.end(activity, esp_timer_get_time());
+  portEXIT_CRITICAL(&powerLedgerMux);
+
+  if (powerLocks[activity] != NULL) esp_pm_lock_release(powerLocks[activity]);
+}
+
+// DFS, modem sleep and light sleep as the settings have them, at boot and
+// again after /save
+void applyPowerSave(void) {
+  if (!deviceSettings.powerSave) {
+    WiFi.setSleep(false);
+    if (powerSaveOn) {
+      esp_pm_config_esp32_t config;
+      config.max_freq_mhz = POWER_SAVE_MAX_FREQ_MHZ;
+      config.min_freq_mhz = POWER_SAVE_MAX_FREQ_MHZ;
+      config.light_sleep_enable = false;
+      // back from whichever way it was on
+      if (esp_pm_configure(&config) != ESP_OK) {
+        setCpuFrequencyMhz(POWER_SAVE_MAX_FREQ_MHZ);
+      }
+    }
+    powerSaveOn = false;
+    powerMode = "off";
+    return;
+  }
+  if (powerSaveOn) return;
+
+  // the radio sleeps between DTIM beacons, which light sleep also needs
+  WiFi.setSleep(WIFI_PS_MIN_MODEM);
+
+  esp_pm_config_esp32_t config;
+  config.max_freq_mhz = POWER_SAVE_MAX_FREQ_MHZ;
+  config.min_freq_mhz = POWER_SAVE_MIN_FREQ_MHZ;
+  config.light_sleep_enable = true;
+  powerMode = "80-240MHz, light sleep";
+
+  esp_err_t err = esp_pm_configure(&config);
+  if (err == ESP_ERR_NOT_SUPPORTED) {
+    // a core built without tickless idle can still scale the clock
+    config.light_sleep_enable = false;
+    powerMode = "80-240MHz";
+    err = esp_pm_configure(&config);
+  }
+
+  if (err != ESP_OK) {
+    // no power management in the core at all, the lowest clock WiFi runs at
+    // is the next best thing
+    setCpuFrequencyMhz(POWER_SAVE_MIN_FREQ_MHZ);
+    powerMode = "fixed 80MHz";
+  } else {
+    // jobs race to idle at full speed, I2C is clocked from the APB and has to
+    // keep it while a frame is on the bus, requests keep light sleep away.
+    // Made once, power save may be turned off and on again.
+    if (powerLocks[POWER_ACTIVITY_CPU] == NULL) {
+      esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "cpu",
+                         &powerLocks[POWER_ACTIVITY_CPU]);
+      esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "display",
+                         &powerLocks[POWER_ACTIVITY_DISPLAY]);
+      esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "network",
+                         &powerLocks[POWER_ACTIVITY_NETWORK]);
+    }
+  }
+  powerSaveOn = true;
+}
+
+// works for any Print, Serial as well as a web response
+void printPowerStats(Print &out) {
+  portENTER_CRITICAL(&powerLedgerMux);
+  PowerLedger ledger = powerLedger;
+  portEXIT_CRITICAL(&powerLedgerMux);
+
+  uint64_t now = esp_timer_get_time();
+  out.printf("Power: %s, CPU at %uMHz now\n", powerMode, getCpuFrequencyMhz());
+
+  for (uint8_t state = 0; state < POWER_STATE_COUNT; state++) {
+    uint16_t share = ledger.basisPoints(state, now);
+    out.printf("  %-8s %3u.%02u%% %10llums %8u entries\n", powerStateName(state),
+               share / 100, share % 100,
+               (unsigned long long)(ledger.timeIn(state, now) / 1000),
+               ledger.entries(state));
+  }
+}
+
+void wakeLogTask(void) {
+  if (logTask != NULL) xTaskNotifyGive(logTask);
+}
+
+void logDrainLoop(void *) {
+  uint32_t reportedDrops = 0;
+  LogRecord record;
+  char line[LOG_PREFIX_SIZE + LOG_TEXT_SIZE];
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    // only this task waits when the UART FIFO is full
+    while (logRead(record)) {
+      logFormat(record, line, sizeof(line));
+      Serial.println(line);
+
+      portENTER_CRITICAL(&logHistoryMux);
+      logHistory[logHistoryCount % LOG_HISTORY_RECORDS] = record;
+      logHistoryCount++;
+      portEXIT_CRITICAL(&logHistoryMux);
+    }
+
+    uint32_t drops = logDropped();
+    if (drops != reportedDrops) {
+      Serial.printf("%u log records dropped\n", drops - reportedDrops);
+      reportedDrops = drops;
+    }
+  }
+}
+
+// the log task only runs while every other task waits
+void drainLog(void) {
+  uint32_t drainStarted = millis();
+  while (logPending() && millis() - drainStarted < LOG_DRAIN_TIMEOUT_MS) {
+    delay(1);
+  }
+  Serial.flush();
+}
 
-bool showActivityIndicator = false;
+void printLogHistory(Print &out) {
+  char line[LOG_PREFIX_SIZE + LOG_TEXT_SIZE];
+  LogRecord record;
+
+  portENTER_CRITICAL(&logHistoryMux);
+  uint32_t end = logHistoryCount;
+  portEXIT_CRITICAL(&logHistoryMux);
+
+  for (uint32_t i = end > LOG_HISTORY_RECORDS ? end - LOG_HISTORY_RECORDS : 0;
+       i < end; i++) {
+    portENTER_CRITICAL(&logHistoryMux);
+    // overwritten by newer records while the response was written
+    bool current = logHistoryCount - i <= LOG_HISTORY_RECORDS;
+    if (current) record = logHistory[i % LOG_HISTORY_RECORDS];
+    portEXIT_CRITICAL(&logHistoryMux);
+
+    if (!current) continue;
+    logFormat(record, line, sizeof(line));
+    out.println(line);
+  }
+
+  out.printf("%u records dropped\n", logDropped());
+}
+
+// the settings that are only read when something is set up, applied again on
+// the scheduler task after /save
+void applySettings(void) {
+  static char stockSymbols[sizeof(deviceSettings.stockSymbols)] = "";
+  static char timeZoneRules[sizeof(deviceSettings.timeZone)] = "";
+
+  // the history of every symbol starts over, only when the list changed
+  if (strcmp(stockSymbols, deviceSettings.stockSymbols) != 0) {
+    strcpy(stockSymbols, deviceSettings.stockSymbols);
+    app.setStockSymbols(stockSymbols);
+    scheduler.trigger(stockRequestJob);
+  }
+
+  // /save only keeps a zone that parses, the clock reads it on this task
+  if (strcmp(timeZoneRules, deviceSettings.timeZone) != 0) {
+    strcpy(timeZoneRules, deviceSettings.timeZone);
+    if (timeZone.set(timeZoneRules, timeClient.getUTCEpochTime())) {
+      LOG_INFO("Time zone %s", timeZoneRules);
+    }
+  }
+
+  applyPowerSave();
+}
+
+void schedulerLoop(void *) {
+  while (true) {
+    if (settingsSaved) {
+      settingsSaved = false;
+      applySettings();
+    }
+    if (touchInterruptPending) {
+      touchInterruptPending = false;
+      touchSampling = true;
+      scheduler.trigger(touchJob);
+    }
 
-// counter from 0 to 3 that resets itself
-uint8_t currentStep = 0;
-#define MAX_STEPS 3
-// tracks how long touches are
-unsigned long lastTouchStart = 0;
-// touch interactivity thresholds
-#define SLEEP_TOUCH_THRESHOLD_LONG 5900
-#define SLEEP_TOUCH_THRESHOLD_MEDIUM 4400
-#define SLEEP_TOUCH_THRESHOLD_SHORT 1400
+    powerBegin(POWER_ACTIVITY_CPU);
+    uint32_t nextWakeMs = scheduler.tick();
+    powerEnd(POWER_ACTIVITY_CPU);
 
-// UI elements
-static const uint8_t WIFI_ICON_DOT_X = 12;
-static const uint8_t WIFI_ICON_DOT_Y = 41;
+    // a notification cuts the wait short, nothing to do while no job is due
+    ulTaskNotifyTake(pdTRUE, nextWakeMs == UINT32_MAX
+                                 ? portMAX_DELAY
+                                 : pdMS_TO_TICKS(nextWakeMs));
+  }
+}
 
-// draws on display and updates clock every 0.5s
-Ticker mainEventLoop;
-// updates every 100ms grab user interaction events
-Ticker uiLoop;
+void runScheduler(void) {
+  xTaskCreate(schedulerLoop, "scheduler", 8192, NULL, 1, &schedulerTask);
+}
 
-void updateCurrentStep(void) {
-  // important update step every time
-  currentStep =
-      (currentStep > 0 && currentStep % MAX_STEPS == 0) ? 0 : currentStep + 1;
+void displayTransferLoop(void *) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    powerBegin(POWER_ACTIVITY_DISPLAY);
+    // the main panel first, then one other panel a pass, so the clock never
+    // waits for more than one of them
+    while (displayPipeline.transferPending() | panelFanout.transferNext()) {
+    }
+    powerEnd(POWER_ACTIVITY_DISPLAY);
+  }
+}
+
+// replaces display.display(): queues the frame for the transfer task and
+// moves drawing over to the other buffer
+void presentFrame(void) {
+  // only waits when frames come faster than the bus can take them
+  while (!displayPipeline.swap()) {
+    delay(1);
+  }
+
+  display.buffer = displayPipeline.backBuffer();
+  screen.attach(display.buffer);
+  panelFanout.reserve(millis(), panelBusMs);
+  xTaskNotifyGive(displayTransferTask);
+}
+
+bool allPanelsIdle(void) {
+  for (uint8_t panel = 0; panel < panelFanout.count(); panel++) {
+    if (!panelFanout.pipeline(panel).idle()) return false;
+  }
+
+  return displayPipeline.idle();
+}
+
+// before anything else talks to the panels over the bus
+void waitForDisplayIdle(void) {
+  while (!allPanelsIdle()) {
+    delay(1);
+  }
+}
+
+// a job that isn't attached would never run. That only happens when one is
+// added without raising TIMER_WHEEL_MAX_JOBS, or with a 0ms period, so it
+// stops the device at the first boot rather than leaving it half working.
+int8_t attachJob(const char *name, uint32_t periodMs, uint32_t coalesceMs,
+                 uint8_t priority, TimerWheelCallback callback) {
+  int8_t job = scheduler.attach(name, periodMs, coalesceMs, priority, callback);
+
+  if (job == TIMER_WHEEL_INVALID_JOB) {
+    LOG_ERROR("Can't schedule %s, %u of %u jobs attached", name,
+              scheduler.jobCount(), TIMER_WHEEL_MAX_JOBS);
+    drainLog();
+    abort();
+  }
+  return job;
+}
+
+void printSchedulerStats(void) {
+  debugLog.printf("Scheduler: %u wakeups, %u idle\n", scheduler.wakeups(),
+                  scheduler.idleWakeups());
+
+  for (int8_t job = 0; job < scheduler.jobCount(); job++) {
+    const TimerWheelJobStats *stats = scheduler.jobStats(job);
+    debugLog.printf("  %-10s runs %u overruns %u late max %ums avg %ums "
+                    "run max %ums\n",
+                    scheduler.jobName(job), stats->runs, stats->overruns,
+                    stats->maxLateMs, stats->avgLateMs, stats->maxRunMs);
+  }
+
+  debugLog.printf("Frames: %u rendered, %u skipped, %u sent, %u swaps "
+                  "refused\n",
+                  app.framePacer().framesRendered(),
+                  app.framePacer().framesSkipped(),
+                  displayPipeline.framesSent(), displayPipeline.swapsRefused());
+  for (uint8_t i = 0; i < sizeof(fetchArenas) / sizeof(fetchArenas[0]); i++) {
+    debugLog.printf("Fetch %-8s arena peak %u of %u bytes, %u refused\n",
+                    FETCH_NAMES[i], (unsigned)fetchArenas[i]->peak(),
+                    (unsigned)fetchArenas[i]->size(),
+                    fetchArenas[i]->refusals());
+  }
+  printPowerStats(debugLog);
 }
 
 DeviceSettings getDefaultSettings(void) {
@@ -160,76 +606,73 @@ DeviceSettings getDefaultSettings(void) {
   strcpy(defaultSettings.screenBrightness, defaultScreenBrightness);
   defaultSettings.invertScreen = false;
   defaultSettings.debugMode = false;
+  strcpy(defaultSettings.stockSymbols, "");
+  strcpy(defaultSettings.stockApiUrl, "");
+  defaultSettings.powerSave = false;
+  strcpy(defaultSettings.timeZone, TIME_ZONE_DEFAULT);
 
   return defaultSettings;
 }
 
-void saveSettings(void) {
-  Serial.print("Saving configuration...");
-
-  File file = SPIFFS.open(CONFIG_FILE_NAME, "wb");
-  file.write((byte *)&deviceSettings, sizeof(deviceSettings));
-
-  Serial.println(F("\tOK!"));
+size_t writeSettingsFile(void *ctx, const uint8_t *data, size_t length) {
+  return ((File *)ctx)->write(data, length);
 }
 
-void displayWiFiTimeout(void) {
-  display.clear();
-  display.drawString(64, 32, F("WiFi setup FAILED!"));
-  display.display();
+size_t readSettingsFile(void *ctx, uint8_t *data, size_t length) {
+  return ((File *)ctx)->read(data, length);
 }
 
-void displayWiFiIcon(bool animate = false, uint8_t x = WIFI_ICON_DOT_X,
-                     uint8_t y = WIFI_ICON_DOT_Y) {
-  if (!animate && !deviceSettings.displayWifiIndicator) {
-    return;
-  }
-
-  long rssi = WiFi.RSSI();
+void saveSettings(void) {
+  File file = SPIFFS.open(CONFIG_FILE_NAME, "wb");
 
-  if ((!animate && rssi >= -67) || (animate && currentStep >= 3)) {
-    display.drawLine(x - 6, y - 8, x - 5,
-                     y - 8); // dot top left line
-    display.drawLine(x - 4, y - 9, x + 5,
-                     y - 9); // dot top middle line
-    display.drawLine(x + 6, y - 8, x + 7,
-                     y - 8); // dot top right line
+  if (settingsSave(deviceSettings, writeSettingsFile, &file)) {
+    LOG_INFO("Configuration saved");
+  } else {
+    LOG_ERROR("Configuration could not be saved");
   }
+}
 
-  if ((!animate && rssi >= -70) || (animate && currentStep >= 2)) {
-    display.drawLine(x - 4, y - 5, x - 3,
-                     y - 5); // dot mid left line
-    display.drawLine(x - 2, y - 6, x + 3,
-                     y - 6); // dot mid middle line
-    display.drawLine(x + 4, y - 5, x + 5,
-                     y - 5); // dot mid right line
-  }
+// text goes through the driver's font renderer, where the layout puts it
+void drawLayoutText(const LayoutCommand &text, const String &value) {
+  static const OLEDDISPLAY_TEXT_ALIGNMENT ALIGNMENTS[] = {
+      TEXT_ALIGN_LEFT, TEXT_ALIGN_CENTER, TEXT_ALIGN_RIGHT};
+
+  display.setFont(text.font == LAYOUT_FONT_24 ? ArialMT_Plain_24
+                                              : ArialMT_Plain_10);
+  display.setTextAlignment((text.align & LAYOUT_MIDDLE)
+                               ? TEXT_ALIGN_CENTER_BOTH
+                               : ALIGNMENTS[text.align]);
+  display.drawString(text.x, text.y, value);
+}
 
-  if ((!animate && rssi >= -80) || (animate && currentStep >= 1)) {
-    display.drawLine(x - 3, y - 2, x - 2,
-                     y - 2); // dot lower left line
-    display.drawLine(x - 1, y - 3, x + 2,
-                     y - 3); // dot lower middle line
-    display.drawLine(x + 3, y - 2, x + 4,
-                     y - 2); // dot lower right line
-  }
+void displayMessage(const String &message) {
+  drawLayoutText(MESSAGE_SCREEN[MESSAGE_TEXT], message);
+}
 
-  display.fillRect(x, y, 2, 2); // the dot
+void displayWiFiTimeout(void) {
+  display.clear();
+  displayMessage(F("WiFi setup FAILED!"));
+  presentFrame();
 }
 
+// the animated icon of the screens shown while connecting, DeskApp draws the
+// main screen's
+void displayWiFiIcon(const LayoutCommand &icon) {
+  drawWiFiIcon(screen, app.step(), icon.x, icon.y);
+}
+
+// on the scheduler task when WiFi drops, so it logs rather than waiting for
+// the UART
 void connectToAP(bool quiet = false) {
   WiFi.mode(WIFI_STA);
   WiFi.begin(deviceSettings.wifiSsid, deviceSettings.wifiPassword);
 
-  Serial.print(F("Connecting to WiFi"));
+  LOG_INFO("Connecting to WiFi");
   unsigned long startMillis = millis();
   while (true) {
-    Serial.print('.');
-
     unsigned long nowMillis = millis();
     if ((unsigned long)(nowMillis - startMillis) >= WIFI_TIMEOUT_MILLIS) {
-      Serial.println(F("\tFAIL!"));
-      Serial.println(F("WiFi setup failed, restarting in 5s!"));
+      LOG_ERROR("WiFi setup failed, restarting in 5s!");
       displayWiFiTimeout();
       delay(5000);
       ESP.restart();
@@ -238,20 +681,21 @@ void connectToAP(bool quiet = false) {
     if (WiFi.status() == WL_CONNECTED) {
       if (!quiet) {
         display.clear();
-        display.drawString(64, 32, F("WiFi connected!"));
-        display.display();
+        displayMessage(F("WiFi connected!"));
+        presentFrame();
       }
-      Serial.println(F("\tOK!"));
+      LOG_INFO("WiFi connected after %lums",
+               (unsigned long)(nowMillis - startMillis));
       break;
     } else {
       if (!quiet) {
         display.clear();
-        displayWiFiIcon(true);
-        display.drawString(64, 32, F("WiFi setup..."));
-        display.display();
+        displayWiFiIcon(MESSAGE_SCREEN[MESSAGE_WIFI_ICON]);
+        displayMessage(F("WiFi setup..."));
+        presentFrame();
       }
 
-      updateCurrentStep();
+      app.nextStep();
       delay(500);
     }
   }
@@ -263,30 +707,198 @@ void setupWiFi(bool quiet = false) {
   }
 }
 
+// GET /screen.pbm converts the frame on the panel piece by piece straight out
+// of the display buffer into the response, without a copy of its own
+struct ScreenRead {
+  size_t   offset;
+  uint8_t *out;
+  size_t   length;
+  size_t   written;
+};
+
+void readScreen(const uint8_t *frame, void *ctx) {
+  ScreenRead *read = (ScreenRead *)ctx;
+
+  read->written =
+      framebufferReadPbm(frame, read->offset, read->out, read->length);
+}
+
+void handleScreen(AsyncWebServerRequest *request) {
+  AsyncWebServerResponse *response = request->beginResponse(
+      "image/x-portable-bitmap", FRAMEBUFFER_PBM_SIZE,
+      [shown = (uint32_t)0](uint8_t *out, size_t maxLen,
+                            size_t index) mutable -> size_t {
+        ScreenRead read = {index, out, maxLen, 0};
+        uint32_t frame;
+
+        if (!displayPipeline.readFront(readScreen, &read, frame)) {
+          return RESPONSE_TRY_AGAIN;
+        }
+        if (index == 0) shown = frame;
+        // a new frame came in after the first piece went out, a short
+        // response is better than a torn image
+        if (frame != shown) return 0;
+
+        return read.written;
+      });
+
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
 void handleNotFound(AsyncWebServerRequest *request) {
   request->send(404, "text/plain", "File Not Found");
 }
 
-void sendApiRequest(AsyncHTTPRequest *request, String sensorId) {
-  static bool requestOpenResult;
+uint8_t requestIndex(AsyncHTTPRequest *request) {
+  return request == &inTempRequest ? 0 : request == &outTempRequest ? 1 : 2;
+}
 
-  if (request->readyState() == readyStateUnsent ||
-      request->readyState() == readyStateDone) {
-    String apiAuthHeader =
-        String(" Bearer " + String(deviceSettings.authToken));
-    String apiUrlStr = String(deviceSettings.apiUrl + sensorId);
+// the time is taken inside the lock so records of different tasks stay in
+// order
+uint32_t inputLogMs(void) { return millis() - inputLogStartMs; }
 
-    requestOpenResult = request->open("GET", apiUrlStr.c_str());
-    request->setReqHeader("Accept", "application/json");
-    request->setReqHeader("Authorization", apiAuthHeader.c_str());
+void recordResponse(AsyncHTTPRequest *request, int status,
+                    const uint8_t *body, size_t length) {
+  if (inputLogBuffer == NULL) return;
 
-    if (requestOpenResult) {
-      request->send();
-    } else {
-      Serial.println(F("Can't open Request"));
+  xSemaphoreTake(inputLogMutex, portMAX_DELAY);
+  inputLog.http(inputLogMs(), status, requestUrls[requestIndex(request)], body,
+                length);
+  xSemaphoreGive(inputLogMutex);
+}
+
+void recordClock(void) {
+  unsigned long lastUpdate = timeClient.getLastUpdate();
+  if (inputLogBuffer == NULL || lastUpdate == recordedClockUpdate) return;
+
+  recordedClockUpdate = lastUpdate;
+  uint32_t epoch = timeClient.getUTCEpochTime();
+  uint16_t msIntoSecond = 1000 - timeClient.msUntilNextSecond();
+
+  xSemaphoreTake(inputLogMutex, portMAX_DELAY);
+  inputLog.ntp(inputLogMs(), epoch, msIntoSecond);
+  xSemaphoreGive(inputLogMutex);
+}
+
+void recordWiFi(bool connected, int32_t rssi) {
+  uint8_t bars = connected ? wifiBarsForRSSI(rssi) : 0;
+
+  if (inputLogBuffer == NULL ||
+      (wifiRecorded && connected == recordedWiFiConnected &&
+       bars == recordedWiFiBars)) {
+    return;
+  }
+  recordedWiFiConnected = connected;
+  recordedWiFiBars = bars;
+  wifiRecorded = true;
+
+  xSemaphoreTake(inputLogMutex, portMAX_DELAY);
+  inputLog.wifi(inputLogMs(), connected, connected ? (int8_t)rssi : 0);
+  xSemaphoreGive(inputLogMutex);
+}
+
+uint16_t readTouch(void) {
+  uint16_t level = halTouchRead();
+
+  if (inputLogBuffer != NULL && (!touchRecorded || level != recordedTouch)) {
+    recordedTouch = level;
+    touchRecorded = true;
+
+    xSemaphoreTake(inputLogMutex, portMAX_DELAY);
+    inputLog.touch(inputLogMs(), level);
+    xSemaphoreGive(inputLogMutex);
+  }
+
+  return level;
+}
+
+void handleInputLog(AsyncWebServerRequest *request) {
+  if (inputLogBuffer == NULL) {
+    request->send(404, "text/plain", "Inputs are recorded in debug mode only");
+    return;
+  }
+
+  // records are only ever appended, what is there now stays as it is
+  xSemaphoreTake(inputLogMutex, portMAX_DELAY);
+  size_t length = inputLogLength;
+  xSemaphoreGive(inputLogMutex);
+
+  AsyncWebServerResponse *response = request->beginResponse(
+      "application/octet-stream", length,
+      [length](uint8_t *out, size_t maxLen, size_t index) -> size_t {
+        size_t piece = length - index < maxLen ? length - index : maxLen;
+        memcpy(out, inputLogBuffer + index, piece);
+        return piece;
+      });
+
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+// keeps the chip out of light sleep while request is waiting for its
+// response, so the network part of a wakeup stays short
+void trackRequest(AsyncHTTPRequest *request, bool inFlight) {
+  uint8_t bit = 1 << requestIndex(request);
+
+  portENTER_CRITICAL(&powerLedgerMux);
+  bool changed = ((requestsInFlight & bit) != 0) != inFlight;
+  if (changed) requestsInFlight ^= bit;
+  portEXIT_CRITICAL(&powerLedgerMux);
+
+  if (!changed) return;
+
+  if (inFlight) {
+    powerBegin(POWER_ACTIVITY_NETWORK);
+  } else {
+    powerEnd(POWER_ACTIVITY_NETWORK);
+  }
+}
+
+void buildRequestHeaders(void) {
+  snprintf(apiAuthHeader, sizeof(apiAuthHeader), " Bearer %s",
+           deviceSettings.authToken);
+}
+
+// drops everything the request had in its arena, once its handler is done
+void releaseRequest(AsyncHTTPRequest *request) {
+  uint8_t index = requestIndex(request);
+
+  requestUrls[index] = "";
+  fetchArenas[index]->reset();
+}
+
+void sendApiRequest(AsyncHTTPRequest *request, const char *sensorId) {
+  static bool requestOpenResult;
+  uint8_t index = requestIndex(request);
+
+  if (requestBusy[index]) {
+    LOG_WARN("Can't send Request");
+    return;
+  }
+
+  releaseRequest(request);
+  char *url = fetchArenas[index]->concat(deviceSettings.apiUrl, sensorId);
+  if (!url) {
+    LOG_WARN("Sensor URL too long");
+    return;
+  }
+  requestUrls[index] = url;
+
+  requestOpenResult = request->open("GET", url);
+  request->setReqHeader("Accept", "application/json");
+  request->setReqHeader("Authorization", apiAuthHeader);
+
+  if (requestOpenResult) {
+    // before send(), the response may come in on another task
+    requestBusy[index] = true;
+    trackRequest(request, true);
+    if (!request->send()) {
+      trackRequest(request, false);
+      requestBusy[index] = false;
     }
   } else {
-    Serial.println(F("Can't send Request"));
+    LOG_WARN("Can't open Request");
   }
 }
 
@@ -298,227 +910,451 @@ void sendOutTempSensorApiRequest(void) {
   sendApiRequest(&outTempRequest, deviceSettings.outSensorId);
 }
 
-void handleInSensorOkResponse(void *cbVoidPtr, AsyncHTTPRequest *request) {
-  char *readingStringPtr = (char *)cbVoidPtr;
-
-  request->responseRead(sensorResponseBuffer, SENSOR_RESPONSE_BUFFER_SIZE);
+void sendStockQuoteRequest(void) {
+  uint8_t symbols = stockTicker.symbolCount();
+  if (symbols == 0) return;
 
-  DeserializationError error =
-      deserializeJson(sensorDoc, sensorResponseBuffer,
-                      DeserializationOption::Filter(sensorValueFilter));
+  // every symbol is refreshed once per interval
+  scheduler.setNextRun(stockRequestJob,
+                       stockFetchIntervalMs(timeClient.getUTCEpochTime()) /
+                           symbols);
 
-  if (error) {
-    Serial.print(F("deserializeJson() failed: "));
-    Serial.println(error.f_str());
+  uint8_t index = requestIndex(&stockPriceRequest);
+  if (requestBusy[index]) {
+    LOG_WARN("Can't send Request");
     return;
   }
 
-  auto state = sensorDoc["state"].as<const char *>();
+  releaseRequest(&stockPriceRequest);
+  char *url = (char *)stockArena.allocate(STOCK_QUOTE_URL_SIZE);
+  stockRequestSymbol = app.nextStockFetch();
+  if (!url || !stockQuoteUrl(deviceSettings.stockApiUrl,
+                             stockTicker.symbol(stockRequestSymbol), url,
+                             STOCK_QUOTE_URL_SIZE)) {
+    LOG_WARN("Stock quote URL too long");
+    return;
+  }
 
-  if (state == SENSOR_UNAVAILABLE_STR) {
-    strncpy(readingStringPtr, SENSOR_NO_VALUE_STR, strlen(SENSOR_NO_VALUE_STR));
+  requestUrls[index] = url;
+  if (stockPriceRequest.open("GET", url)) {
+    stockPriceRequest.setReqHeader("Accept", "application/json");
+    requestBusy[index] = true;
+    trackRequest(&stockPriceRequest, true);
+    if (!stockPriceRequest.send()) {
+      trackRequest(&stockPriceRequest, false);
+      requestBusy[index] = false;
+    }
   } else {
-    strncpy(readingStringPtr, state, strlen(state));
+    LOG_WARN("Can't open Request");
   }
 }
 
-void handleOutSensorOkResponse(void *cbVoidPtr, AsyncHTTPRequest *request) {
-  char *readingStringPtr = (char *)cbVoidPtr;
+// reads the body of a finished request into the rest of its arena, only a
+// 200 has one worth reading, and records the response
+const uint8_t *readResponse(AsyncHTTPRequest *request, size_t &length) {
+  FetchArena *arena = fetchArenas[requestIndex(request)];
+  int status = request->responseHTTPcode();
+  size_t spare;
+  uint8_t *body = arena->spare(spare);
+
+  length = 0;
+  if (status == 200) {
+    length = request->responseRead(body, spare);
+    arena->commit(length);
+    // cut off, the parser will find it incomplete
+    if (request->available() > 0) LOG_WARN("Response larger than its arena");
+  }
+  recordResponse(request, status, body, length);
 
-  request->responseRead(sensorResponseBuffer, SENSOR_RESPONSE_BUFFER_SIZE);
+  return body;
+}
 
-  DeserializationError error =
-      deserializeJson(outSensorDoc, sensorResponseBuffer,
-                      DeserializationOption::Filter(outSensorValueFilter));
+void stockQuoteReqCb(void *cbVoidPtr, AsyncHTTPRequest *request,
+                     int readyState) {
+  if (readyState != readyStateDone) return;
 
-  if (error) {
-    Serial.print(F("deserializeJson() failed: "));
-    Serial.println(error.f_str());
-    return;
-  }
+  trackRequest(request, false);
+  size_t length;
+  const uint8_t *body = readResponse(request, length);
 
-  auto tempFloat = outSensorDoc["attributes"]["temperature"].as<float>();
-  char buffer[5]; // xx.y + \0
-  sprintf(buffer, "%1g", tempFloat);
-  strncpy(readingStringPtr, buffer, strlen(buffer));
+  app.handleStockResponse(stockRequestSymbol, request->responseHTTPcode(),
+                          body, length);
+  releaseRequest(request);
+  requestBusy[requestIndex(request)] = false;
 }
 
 void apiSensorReadReqCb(void *cbVoidPtr, AsyncHTTPRequest *request,
                         int readyState) {
   if (readyState == readyStateDone) {
-    showActivityIndicator = false;
+    app.setActivity(false);
+    trackRequest(request, false);
+    size_t length;
+    const uint8_t *body = readResponse(request, length);
+
+    app.handleSensorResponse(request == &inTempRequest ? DESK_APP_INSIDE
+                                                       : DESK_APP_OUTSIDE,
+                             request->responseHTTPcode(), body, length);
+    releaseRequest(request);
+    requestBusy[requestIndex(request)] = false;
+  } else {
+    app.setActivity(true);
+  }
+}
 
-    if (request->responseHTTPcode() == 200) {
-      if (request == &inTempRequest) {
-        handleInSensorOkResponse(cbVoidPtr, request);
-      } else if (request == &outTempRequest) {
-        handleOutSensorOkResponse(cbVoidPtr, request);
-      }
+void displayClockRow(bool draw = false) {
+  char time[TIME_FORMAT_TIME_SIZE] = "--:--:--";
+  if (clockKnown) formatTime(timeClient.getEpochTime(), time);
+
+  const LayoutCommand &clock = MAIN_SCREEN[MAIN_CLOCK];
+  if (clockAtlas.covers(time)) {
+    clockAtlas.drawTextCentered(screen, clock.x, clock.y, time);
+  } else {
+    drawLayoutText(clock, time);
+  }
+}
+
+void displaySensorRow(bool draw = false) {
+  // xx.y°C | xx.y°C in the atlas' Latin-1 encoding
+  char sensorOutputFirstRow[2 * HA_READING_TEXT_SIZE + 3];
+  int16_t insideTemperature = app.reading(DESK_APP_INSIDE);
+  int16_t outsideTemperature = app.reading(DESK_APP_OUTSIDE);
+  size_t length = haFormatReading(insideTemperature, HA_SENSOR_TEMPERATURE,
+                                  sensorOutputFirstRow, HA_READING_TEXT_SIZE);
+  memcpy(sensorOutputFirstRow + length, " | ", 3);
+  haFormatReading(outsideTemperature, HA_WEATHER_TEMPERATURE,
+                  sensorOutputFirstRow + length + 3, HA_READING_TEXT_SIZE);
+  // SYMBOL $123.45 of the first stock symbol
+  char sensorOutputSecondRow[STOCK_SYMBOL_SIZE + 16] = "";
+  if (stockTicker.symbolCount() > 0) {
+    char price[12] = "-.--";
+    if (stockTicker.historyLength(0) > 0) {
+      stockFormatCents(stockTicker.price(0), false, price, sizeof(price));
     }
+    snprintf(sensorOutputSecondRow, sizeof(sensorOutputSecondRow), "%s $%s",
+             stockTicker.symbol(0), price);
+  }
+
+  const LayoutCommand &readings = MAIN_SCREEN[MAIN_READINGS];
+  if (textAtlas.covers(sensorOutputFirstRow)) {
+    textAtlas.drawTextCentered(screen, readings.x, readings.y,
+                               sensorOutputFirstRow);
   } else {
-    showActivityIndicator = true;
+    // the driver's fonts take UTF-8
+    char inside[HA_FIXED_TEXT_SIZE], outside[HA_FIXED_TEXT_SIZE];
+    haFormatFixed(insideTemperature, HA_SENSOR_TEMPERATURE.decimals, inside,
+                  sizeof(inside));
+    haFormatFixed(outsideTemperature, HA_WEATHER_TEMPERATURE.decimals, outside,
+                  sizeof(outside));
+    drawLayoutText(readings, String(inside) + String("°C") + String(" | ") +
+                                 String(outside) + String("°C"));
   }
+  drawLayoutText(MAIN_SCREEN[MAIN_QUOTE], sensorOutputSecondRow);
 }
 
-void displayClockRow(bool draw = false) {
-  formattedTime = timeClient.getFormattedTime();
-  display.setFont(ArialMT_Plain_24);
-  display.setTextAlignment(TEXT_ALIGN_CENTER);
-  display.drawString(64, 0, formattedTime);
+void displayDateRow(bool draw = false) {
+  unsigned long epoch = timeClient.getEpochTime();
+  uint8_t day = dayOfWeek(epoch);
+  char dayCode[2] = {(char)('0' + day), '\0'};
+  char date[TIME_FORMAT_DATE_SIZE];
+  formatDate(epoch, date);
+
+  const LayoutCommand &row = MAIN_SCREEN[MAIN_DATE];
+  if (textAtlas.covers(date) && dayAtlas.covers(dayCode)) {
+    uint16_t width = textAtlas.textWidth(date) + textAtlas.textWidth("  ") +
+                     dayAtlas.textWidth(dayCode);
+    int16_t x = textAtlas.drawText(screen, row.x - width / 2, row.y, date);
+    x = textAtlas.drawText(screen, x, row.y, "  ");
+    dayAtlas.drawText(screen, x, row.y, dayCode);
+  } else {
+    drawLayoutText(row, String(date) + F("  ") + DAY_NAMES[day]);
+  }
 }
 
-void drawl2o4(void) {
-  display.drawLine(10, 36, 10, 40);
-  display.drawLine(118, 36, 118, 40);
+void IRAM_ATTR touchInterruptCb(void) {
+  // fires on every measurement below the threshold, the first one is enough
+  if (touchSampling || schedulerTask == NULL) return;
+
+  BaseType_t woken = pdFALSE;
+  touchInterruptPending = true;
+  vTaskNotifyGiveFromISR(schedulerTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
 }
 
-void drawl3o4(void) {
-  display.drawLine(15, 32, 15, 44);
-  display.drawLine(113, 32, 113, 44);
+// the RTC keeps the system time through deep sleep, so the clock can be
+// estimated on the next boot
+void syncSystemTime(void) {
+  struct timeval now = {(time_t)timeClient.getUTCEpochTime(), 0};
+  settimeofday(&now, nullptr);
 }
 
-void drawl4o4(void) {
-  display.drawLine(20, 28, 20, 48);
-  display.drawLine(108, 28, 108, 48);
+void updateBootSnapshot(bool toFlash) {
+  BootSnapshot snapshot;
+  if (bootCacheValid(rtcBootSnapshot)) {
+    snapshot = rtcBootSnapshot;
+  } else {
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.insideReading = SENSOR_NO_VALUE;
+    snapshot.outsideReading = SENSOR_NO_VALUE;
+  }
+
+  // only what came from the network, a restored value is in there already
+  if (app.timeSynced()) syncSystemTime();
+  app.updateSnapshot(snapshot);
+
+  bootCacheSeal(snapshot);
+  rtcBootSnapshot = snapshot;
+
+  unsigned long now = millis();
+  bool due = bootSnapshotSavedAt == 0 ||
+             now - bootSnapshotSavedAt >= BOOT_CACHE_SAVE_INTERVAL_MS;
+  if (!toFlash && (!due || bootCacheSameContent(snapshot, savedBootSnapshot))) {
+    return;
+  }
+
+  File file = SPIFFS.open(BOOT_CACHE_FILE_NAME, "wb");
+  if (file && bootCacheSave(snapshot, writeSettingsFile, &file)) {
+    savedBootSnapshot = snapshot;
+    bootSnapshotSavedAt = now;
+  }
 }
 
-void animateSideLines(void) {
-  switch (currentStep) {
-  case 0:
-  default:
-    break;
-  case 1:
-    drawl4o4();
-    break;
-  case 2:
-    drawl3o4();
-    drawl4o4();
-    break;
-  case 3:
-    drawl2o4();
-    drawl3o4();
-    drawl4o4();
-    break;
+void refreshBootSnapshot(void) { updateBootSnapshot(false); }
+
+bool restoreBootSnapshot(void) {
+  BootSnapshot snapshot;
+
+  // RTC memory is the newest after deep sleep, flash after anything else
+  if (bootCacheValid(rtcBootSnapshot)) {
+    snapshot = rtcBootSnapshot;
+  } else {
+    if (!SPIFFS.exists(BOOT_CACHE_FILE_NAME)) return false;
+
+    File file = SPIFFS.open(BOOT_CACHE_FILE_NAME, "rb");
+    if (!file || !bootCacheLoad(snapshot, readSettingsFile, &file)) {
+      return false;
+    }
+    savedBootSnapshot = snapshot;
+    rtcBootSnapshot = snapshot;
   }
+
+  app.restoreSnapshot(snapshot);
+
+  // after a power loss the system time starts over from 0
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  clockKnown = snapshot.utcEpoch > 0 && (uint32_t)now.tv_sec >= snapshot.utcEpoch;
+
+  // the estimate stands until the first NTP update, the date of the snapshot
+  // is still right more often than not
+  timeClient.setEpochTime((clockKnown ? (uint32_t)now.tv_sec : snapshot.utcEpoch) -
+                          millis() / 1000);
+
+  return true;
 }
 
-void displaySensorRow(bool draw = false) {
-  String sensorOutputFirstRow = String(insideTempSensorReading) + String("°C") +
-                                String(" | ") +
-                                String(outsideTempSensorReading) + String("°C");
-  String sensorOutputSecondRow = String("WDAY $xxx.yy");
+uint32_t sleepTouchThresholdMs(void) {
+  if (strcmp(deviceSettings.sleepTouchThreshold, "short") == 0) {
+    return SLEEP_TOUCH_THRESHOLD_SHORT;
+  } else if (strcmp(deviceSettings.sleepTouchThreshold, "medium") == 0) {
+    return SLEEP_TOUCH_THRESHOLD_MEDIUM;
+  }
 
-  display.setFont(ArialMT_Plain_10);
-  display.setTextAlignment(TEXT_ALIGN_CENTER);
-  // draw top line
-  display.drawLine(25, 25, 103, 25);
-  display.drawString(64, 26, sensorOutputFirstRow);
-  display.drawString(64, 38, sensorOutputSecondRow);
-  // draw bottom line
-  display.drawLine(25, 51, 103, 51);
-}
-
-String getDow(void) {
-  switch (timeClient.getDay()) {
-  case 0:
-    return F("Sun");
-  case 1:
-    return F("Mon");
-  case 2:
-    return F("Tue");
-  case 3:
-    return F("Wed");
-  case 4:
-    return F("Thu");
-  case 5:
-    return F("Fri");
-  case 6:
-    return F("Sat");
-  default:
-    return F("UNK");
+  return SLEEP_TOUCH_THRESHOLD_LONG;
+}
+
+void goToSleep(void) {
+  display.clear();
+  displayMessage(F("Turning off..."));
+  presentFrame();
+  delay(2000);
+  waitForDisplayIdle();
+  display.displayOff();
+  for (uint8_t panel = 0; panel < panelFanout.count(); panel++) {
+    extraTransports[panel]->displayOff();
+  }
+  insideHistory.flush();
+  outsideHistory.flush();
+  updateBootSnapshot(true);
+  LOG_INFO("Going to sleep now");
+
+  drainLog();
+  esp_deep_sleep_start();
+}
+
+void displayStockPage(uint8_t index) {
+  char text[32];
+  char change[12];
+  char percent[12];
+
+  drawLayoutText(STOCK_SCREEN[STOCK_SYMBOL], stockTicker.symbol(index));
+
+  if (stockTicker.historyLength(index) == 0) {
+    drawLayoutText(STOCK_SCREEN[STOCK_NO_QUOTE], F("No quote yet"));
+    return;
   }
+
+  // +1.23 +0.45%
+  stockFormatCents(stockTicker.change(index), true, change, sizeof(change));
+  stockFormatCents(stockTicker.changeBasisPoints(index), true, percent,
+                   sizeof(percent));
+  snprintf(text, sizeof(text), "%s %s%%", change, percent);
+  drawLayoutText(STOCK_SCREEN[STOCK_CHANGE], text);
+
+  stockFormatCents(stockTicker.price(index), false, text, sizeof(text));
+  drawLayoutText(STOCK_SCREEN[STOCK_PRICE], text);
 }
 
-void displayDateRow(bool draw = false) {
-  formattedDateTime = timeClient.getFormattedDate();
-  int splitT = formattedDateTime.indexOf("T");
-  formattedDate = formattedDateTime.substring(0, splitT);
+// one half of the history page: range and average of the last day, DeskApp
+// draws the graph under them
+void displayHistoryGraph(TimeSeries &history, const char *label,
+                         const LayoutCommand &range,
+                         const LayoutCommand &average) {
+  unsigned long now = timeClient.getUTCEpochTime();
+  unsigned long from = now - HISTORY_GRAPH_SECONDS;
+  TimeSeriesStats stats;
+  char low[HA_FIXED_TEXT_SIZE], high[HA_FIXED_TEXT_SIZE],
+      avg[HA_FIXED_TEXT_SIZE], text[32];
+
+  if (!history.stats(from, now + 1, stats)) {
+    snprintf(text, sizeof(text), "%s: no history yet", label);
+    drawLayoutText(range, text);
+    return;
+  }
 
-  display.setFont(ArialMT_Plain_10);
-  display.setTextAlignment(TEXT_ALIGN_CENTER);
-  display.drawString(64, 51, String(formattedDate + F("  ") + getDow()));
-  // draw separator line
-  display.drawLine(82, 51, 82, 64);
+  // both series are in tenths, like the readings
+  haFormatFixed(stats.min, 1, low, sizeof(low));
+  haFormatFixed(stats.max, 1, high, sizeof(high));
+  haFormatFixed(stats.avg, 1, avg, sizeof(avg));
+  snprintf(text, sizeof(text), "%s %s..%s", label, low, high);
+  drawLayoutText(range, text);
+  snprintf(text, sizeof(text), "avg %s", avg);
+  drawLayoutText(average, text);
 }
 
-void processLongTouch(void) {
-  if (touchRead(TOUCH_PIN) < TOUCH_TRESHOLD) {
-    showActivityIndicator = true;
+void displayHistoryPage(void) {
+  displayHistoryGraph(insideHistory, "In", HISTORY_SCREEN[HISTORY_IN_RANGE],
+                      HISTORY_SCREEN[HISTORY_IN_AVERAGE]);
+  displayHistoryGraph(outsideHistory, "Out", HISTORY_SCREEN[HISTORY_OUT_RANGE],
+                      HISTORY_SCREEN[HISTORY_OUT_AVERAGE]);
+}
 
-    if (lastTouchStart == 0) { // register touch
-      lastTouchStart = millis();
-      currentStep = 0;
-    }
+// the text of a page, DeskApp draws the rest
+void drawPageText(uint8_t page) {
+  if (page == app.historyPage()) {
+    displayHistoryPage();
+  } else if (page > 0) {
+    displayStockPage(page - 1);
+  } else {
+    displayClockRow();
+    displaySensorRow();
+    displayDateRow();
+  }
+}
 
-    unsigned long currMillis = millis();
-    unsigned long touchDuration = currMillis - lastTouchStart;
-
-    if (touchDuration > SLEEP_TOUCH_THRESHOLD_LONG) {
-      display.clear();
-      display.setFont(ArialMT_Plain_10);
-      display.setTextAlignment(TEXT_ALIGN_CENTER_BOTH);
-      display.drawString(64, 32, F("Turning off..."));
-      display.display();
-      delay(2000);
-      display.displayOff();
-      Serial.println(F("Going to sleep now"));
-      esp_deep_sleep_start();
-    }
+void recordHistory(void) {
+  app.recordHistory();
+}
+
+void invertScreen(void) {
+  deviceSettings.invertScreen = !deviceSettings.invertScreen;
+  waitForDisplayIdle();
+  if (deviceSettings.invertScreen) {
+    display.invertDisplay();
   } else {
-    showActivityIndicator = false;
-    lastTouchStart = 0;
+    display.normalDisplay();
   }
 }
 
-void processInteractions(void) { processLongTouch(); }
+void processTouch(void) {
+  // the setting can change from the web UI at any time
+  touchGestures.setLongPressMs(sleepTouchThresholdMs());
+  touchGestures.sample(millis(), readTouch());
+
+  TouchEvent event;
+  while (touchGestures.nextEvent(event)) {
+    app.handleTouchEvent(event);
+  }
+
+  if (!touchGestures.active()) {
+    scheduler.disable(touchJob);
+    touchSampling = false;
+  }
+}
+
+void updateTouchBaseline(void) {
+  if (touchSampling) return;
+
+  touchGestures.sample(millis(), readTouch());
+  // also the level that wakes the chip from deep sleep
+  touchAttachInterrupt(TOUCH_PIN, touchInterruptCb, touchGestures.pressLevel());
+}
+
+// to a single viewer, or to all of them without client
+void sendLiveEvents(AsyncEventSourceClient *client, uint8_t events,
+                    const LiveState &state, uint32_t id) {
+  char data[LIVE_EVENT_DATA_SIZE];
+
+  for (uint8_t event = 1; event & LIVE_EVENT_ALL; event <<= 1) {
+    if (!(events & event)) continue;
+
+    liveFormatEvent(event, state, data, sizeof(data));
+    if (client) {
+      client->send(data, liveEventName(event), id);
+    } else {
+      liveEvents.send(data, liveEventName(event), id);
+    }
+  }
+}
+
+// sending only queues the messages, a slow viewer never holds up a frame
+void publishLiveState(const LiveState &state, uint8_t changes) {
+  portENTER_CRITICAL(&liveStateMux);
+  liveState = state;
+  if (changes) liveEventId++;
+  uint32_t id = liveEventId;
+  portEXIT_CRITICAL(&liveStateMux);
+
+  if (changes && liveEvents.count() > 0) {
+    sendLiveEvents(nullptr, changes, state, id);
+  }
+}
 
 void processMainUI(void) {
   while (WiFi.isConnected() && !timeClient.update()) {
     timeClient.forceUpdate();
   }
+  recordClock();
 
-  display.clear();
+  bool connected = WiFi.isConnected();
+  recordWiFi(connected, WiFi.RSSI());
 
-  displayClockRow();
-  displaySensorRow();
-  displayDateRow();
+  if (connected && !app.timeSynced()) {
+    app.setTimeSynced();
+    clockKnown = true;
+    syncSystemTime();
+  }
 
-  if (showActivityIndicator)
-    animateSideLines();
+  // the setting can change from the web UI at any time
+  app.setShowWiFiIcon(deviceSettings.displayWifiIndicator);
+  if (app.update(connected)) xTaskNotifyGive(displayTransferTask);
 
-  updateCurrentStep();
+  if (!connected) setupWiFi(true);
 
-  if (!WiFi.isConnected()) {
-    displayWiFiIcon(true);
-    setupWiFi(true);
-  } else if (WiFi.isConnected() && !showActivityIndicator) {
-    displayWiFiIcon(false);
-  }
-
-  display.display();
+  app.scheduleNextFrame(app.activity() || !WiFi.isConnected());
 }
 
 void processSetupUI(void) {
   display.clear();
-  display.setFont(ArialMT_Plain_10);
-  display.setTextAlignment(TEXT_ALIGN_LEFT);
-  display.drawString(30, 40, F("SSID: dd_setup"));
-  display.drawString(30, 50, F("PW:   12345"));
+  drawLayoutText(SETUP_SCREEN[SETUP_SSID], F("SSID: dd_setup"));
+  drawLayoutText(SETUP_SCREEN[SETUP_PASSWORD], F("PW:   12345"));
 
-  displayWiFiIcon(true, 64, 26);
-  display.display();
+  displayWiFiIcon(SETUP_SCREEN[SETUP_WIFI_ICON]);
+  presentFrame();
+  // the main screen has to be drawn in full once setup is done
+  app.invalidateFrame();
 
-  updateCurrentStep();
+  app.nextStep();
+  app.scheduleNextFrame(true);
 }
 
 void updateMainLoop(void) {
@@ -529,73 +1365,84 @@ void updateMainLoop(void) {
   }
 }
 
+void captureGlyph(GlyphAtlas &atlas, uint8_t code, const String &text) {
+  uint16_t advance = display.getStringWidth(text);
+
+  display.clear();
+  display.drawString(0, 0, text);
+  atlas.capture(screen, code, advance, advance);
+}
+
+void initGlyphAtlas(void) {
+  display.setTextAlignment(TEXT_ALIGN_LEFT);
+
+  display.setFont(ArialMT_Plain_24);
+  for (const char *c = CLOCK_GLYPHS; *c; c++) {
+    captureGlyph(clockAtlas, *c, String(*c));
+  }
+
+  display.setFont(ArialMT_Plain_10);
+  for (const char *c = TEXT_GLYPHS; *c; c++) {
+    captureGlyph(textAtlas, *c, String(*c));
+  }
+  captureGlyph(textAtlas, DEGREE_SIGN_CODE, F("°"));
+
+  for (uint8_t day = 0; day < 7; day++) {
+    captureGlyph(dayAtlas, '0' + day, DAY_NAMES[day]);
+  }
+
+  display.clear();
+}
+
+// on the bus the OLED driver set up, before the transfer task starts
+void initExtraPanels(void) {
+  for (uint8_t i = 0; i < EXTRA_PANEL_COUNT; i++) {
+    uint8_t *back = (uint8_t *)calloc(1, FRAMEBUFFER_SIZE);
+    uint8_t *front = (uint8_t *)calloc(1, FRAMEBUFFER_SIZE);
+    if (!back || !front) {
+      LOG_ERROR("No memory for panel %u", i + 1);
+      free(back);
+      free(front);
+      return;
+    }
+
+    Ssd1306WireTransport *transport = new Ssd1306WireTransport(
+        Wire, EXTRA_PANELS[i].address, EXTRA_PANELS[i].muxChannel);
+    transport->begin(EXTRA_PANEL_CONTRAST);
+    // the blank front goes out once, there is no frame on the panel yet
+    transport->sendFrame(front);
+
+    DisplayPipeline *pipeline = new DisplayPipeline(*transport);
+    pipeline->attach(back, front);
+    uint8_t panel = panelFanout.addPanel(*pipeline, panelBusMs);
+    extraTransports[panel] = transport;
+    app.setPanelPage(panel, EXTRA_PANELS[i].page);
+  }
+}
+
 void initDisplay(void) {
   Serial.print(F("Initializing display..."));
   display.init();
+  screen.attach(display.buffer);
+  initGlyphAtlas();
   // lower brightness is better
   display.setBrightness(32);
   display.clear();
   display.flipScreenVertically();
   display.setFont(ArialMT_Plain_10);
   display.setTextAlignment(TEXT_ALIGN_CENTER_BOTH);
+
+  initExtraPanels();
+
+  // from here on only the transfer task sends frames
+  displayPipeline.attach(display.buffer, secondDisplayBuffer);
+  xTaskCreate(displayTransferLoop, "display", 2048, NULL, 2,
+              &displayTransferTask);
   Serial.println(F("\tOK!"));
 }
 
 String processor(const String &var) {
-  if (var == "IS_SETUP") {
-    return String(deviceSettings.isSetup ? "checked" : "");
-  } else if (var == "WIFI_SSID") {
-    return String(deviceSettings.wifiSsid);
-  } else if (var == "WIFI_PASSWORD") {
-    return String(deviceSettings.wifiPassword);
-  } else if (var == "HA_API") {
-    return String(deviceSettings.apiUrl);
-  } else if (var == "AUTH_TOKEN") {
-    return String(deviceSettings.authToken);
-  } else if (var == "IN_SENSOR_ID") {
-    return String(deviceSettings.inSensorId);
-  } else if (var == "OUT_SENSOR_ID") {
-    return String(deviceSettings.outSensorId);
-  } else if (var == "WIFI_ICON_STATE") {
-    return String(deviceSettings.displayWifiIndicator ? "checked" : "");
-  } else if (var == "HTTP_REQUEST_INTERVAL") {
-    return String(deviceSettings.httpRequestInterval);
-  } else if (var == "LONG_TOUCH_SELECTED") {
-    return String(strcmp(deviceSettings.sleepTouchThreshold, "long") == 0
-                      ? "selected"
-                      : "");
-  } else if (var == "MEDIUM_TOUCH_SELECTED") {
-    return String(strcmp(deviceSettings.sleepTouchThreshold, "medium") == 0
-                      ? "selected"
-                      : "");
-  } else if (var == "SHORT_TOUCH_SELECTED") {
-    return String(strcmp(deviceSettings.sleepTouchThreshold, "short") == 0
-                      ? "selected"
-                      : "");
-  } else if (var == "HIGH_BRIGHTNESS_SELECTED") {
-    return String(
-        strcmp(deviceSettings.screenBrightness, "high") == 0 ? "selected" : "");
-  } else if (var == "MEDIUM_BRIGHTNESS_SELECTED") {
-    return String(strcmp(deviceSettings.screenBrightness, "medium") == 0
-                      ? "selected"
-                      : "");
-  } else if (var == "DIM_BRIGHTNESS_SELECTED") {
-    return String(
-        strcmp(deviceSettings.screenBrightness, "dim") == 0 ? "selected" : "");
-  } else if (var == "INVERT_SCREEN") {
-    return String(deviceSettings.invertScreen ? "checked" : "");
-  } else if (var == "ENABLE_DEBUG") {
-    return String(deviceSettings.debugMode ? "checked" : "");
-  } else if (var == "SETUP_STATE") {
-    return String(
-        deviceSettings.isSetup
-            ? "is successfully set up!"
-            : "is not set up! Please fill out the form below to start.");
-  } else if (var == "DEBUG_MODE_STYLING") {
-    return String(deviceSettings.debugMode ? "" : " style=\"display:none\"");
-  }
-
-  return String();
+  return String(settingsTemplateValue(deviceSettings, var.c_str()));
 }
 
 void setupWebServer(void) {
@@ -662,6 +1509,37 @@ void setupWebServer(void) {
         strcpy(deviceSettings.outSensorId, "");
       }
 
+      if (request->hasParam("stockSymbols", true)) {
+        AsyncWebParameter *p = request->getParam("stockSymbols", true);
+        String v = p->value();
+
+        strlcpy(deviceSettings.stockSymbols, v.c_str(),
+                sizeof(deviceSettings.stockSymbols));
+      } else {
+        strcpy(deviceSettings.stockSymbols, "");
+      }
+      if (request->hasParam("stockApiUrl", true)) {
+        AsyncWebParameter *p = request->getParam("stockApiUrl", true);
+        String v = p->value();
+
+        strlcpy(deviceSettings.stockApiUrl, v.c_str(),
+                sizeof(deviceSettings.stockApiUrl));
+      } else {
+        strcpy(deviceSettings.stockApiUrl, "");
+      }
+
+      if (request->hasParam("timeZone", true)) {
+        AsyncWebParameter *p = request->getParam("timeZone", true);
+        String v = p->value();
+        TimeZone parsed;
+
+        if (v.length() < sizeof(deviceSettings.timeZone) && parsed.set(v.c_str())) {
+          strcpy(deviceSettings.timeZone, v.c_str());
+        } else {
+          strcpy(deviceSettings.timeZone, TIME_ZONE_DEFAULT);
+        }
+      }
+
       if (request->hasParam("httpRequestInterval", true)) {
         AsyncWebParameter *p = request->getParam("httpRequestInterval", true);
         String v = p->value();
@@ -696,14 +1574,50 @@ void setupWebServer(void) {
           request->hasParam("displayWifiIndicator", true);
       deviceSettings.invertScreen = request->hasParam("invertScreen", true);
       deviceSettings.debugMode = request->hasParam("debugMode", true);
+      deviceSettings.powerSave = request->hasParam("powerSave", true);
       deviceSettings.isSetup = request->hasParam("isSetup", true);
     } 
 
     saveSettings();
+    buildRequestHeaders();
+    logSetLevel(deviceSettings.debugMode ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+    settingsSaved = true;
+    if (schedulerTask != NULL) xTaskNotifyGive(schedulerTask);
 
     request->redirect("/");
   });
 
+  server.on("/logs", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("text/plain");
+    printLogHistory(*response);
+    request->send(response);
+  });
+
+  server.on("/power", HTTP_GET, [](AsyncWebServerRequest *request) {
+    AsyncResponseStream *response = request->beginResponseStream("text/plain");
+    printPowerStats(*response);
+    request->send(response);
+  });
+
+  server.on("/screen.pbm", HTTP_GET, handleScreen);
+  server.on("/inputs.bin", HTTP_GET, handleInputLog);
+
+  liveEvents.onConnect([](AsyncEventSourceClient *client) {
+    // count() includes the new one
+    if (liveEvents.count() > LIVE_EVENTS_MAX_CLIENTS) {
+      client->close();
+      return;
+    }
+
+    portENTER_CRITICAL(&liveStateMux);
+    LiveState state = liveState;
+    uint32_t id = liveEventId;
+    portEXIT_CRITICAL(&liveStateMux);
+
+    sendLiveEvents(client, LIVE_EVENT_ALL, state, id);
+  });
+  server.addHandler(&liveEvents);
+
   server.onNotFound(handleNotFound);
 
   server.begin();
@@ -715,22 +1629,34 @@ void setupWebServer(void) {
   Serial.println(F("********************************"));
 }
 
-void initWifiAndSleep(void) {
+// quiet keeps the boot snapshot on screen while connecting
+void initWifiAndSleep(bool quiet) {
   bool wokeUpFromTouch =
       esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TOUCHPAD;
 
   if (wokeUpFromTouch) {
-    display.drawString(64, 32, F("Waking up..."));
-    displayWiFiIcon(true);
-    display.display();
+    if (!quiet) {
+      displayMessage(F("Waking up..."));
+      displayWiFiIcon(MESSAGE_SCREEN[MESSAGE_WIFI_ICON]);
+      presentFrame();
+    }
     setupWiFi(true);
   } else {
-    setupWiFi(false);
-    delay(2000);
+    setupWiFi(quiet);
+    if (!quiet) delay(2000);
   }
 }
 
-void touchInterruptCb(void) {}
+void initPowerManagement(void) {
+  Serial.print(F("Initializing power management..."));
+  portENTER_CRITICAL(&powerLedgerMux);
+  powerLedger.reset(esp_timer_get_time());
+  portEXIT_CRITICAL(&powerLedgerMux);
+
+  applyPowerSave();
+  Serial.print('\t');
+  Serial.println(powerMode);
+}
 
 void initDeviceSettings(void) {
   // default config does not exist, dump it!
@@ -740,7 +1666,7 @@ void initDeviceSettings(void) {
 
     File file = SPIFFS.open(CONFIG_FILE_NAME, "wb");
 
-    file.write((byte *)&defaultSettings, sizeof(defaultSettings));
+    settingsSave(defaultSettings, writeSettingsFile, &file);
 
     deviceSettings = defaultSettings;
 
@@ -749,42 +1675,118 @@ void initDeviceSettings(void) {
     Serial.print("Device config exists, loading...");
 
     File file = SPIFFS.open(CONFIG_FILE_NAME, "rb");
-    file.read((byte *)&deviceSettings, sizeof(deviceSettings));
+    settingsLoad(deviceSettings, readSettingsFile, &file);
 
     Serial.println(F("\tOK!"));
   }
+  buildRequestHeaders();
+}
+
+void initLogging(void) {
+  logSetWakeup(wakeLogTask);
+  // below everything else, records wait in the ring while there is work
+  xTaskCreate(logDrainLoop, "log", 3072, NULL, tskIDLE_PRIORITY, &logTask);
+}
+
+void initTimeZone(void) {
+  Serial.print(F("Compiling time zone rules..."));
+  if (!timeZone.set(deviceSettings.timeZone, timeClient.getUTCEpochTime())) {
+    Serial.print(F(" invalid, using " TIME_ZONE_DEFAULT));
+    timeZone.set(TIME_ZONE_DEFAULT, timeClient.getUTCEpochTime());
+  }
+  timeClient.setTimeZone(&timeZone);
+  Serial.println(F("\tOK!"));
+}
+
+// starts where the simulator starts, right before the jobs are attached
+void initInputLog(void) {
+  Serial.print(F("Recording inputs..."));
+  // before the buffer, which is what the recorders check
+  inputLogMutex = xSemaphoreCreateMutex();
+  if (inputLogMutex != NULL) {
+    inputLogBuffer = (uint8_t *)malloc(INPUT_LOG_BUFFER_SIZE);
+  }
+  if (inputLogBuffer == NULL) {
+    Serial.println(F("\tout of memory"));
+    return;
+  }
+
+  inputLogStartMs = millis();
+  inputLog.begin();
+  recordWiFi(WiFi.isConnected(), WiFi.RSSI());
+  Serial.println(F("\tOK!"));
 }
 
 void initTimeClient(void) {
   Serial.print(F("Initializing NTP client..."));
-  // set up time client and adjust GMT offset
   timeClient.begin();
-  // GMT +3 = 3600 * 3
-  timeClient.setTimeOffset(3600 * 3);
+  Serial.println(F("\tOK!"));
+}
+
+void initHistory(void) {
+  Serial.print(F("Restoring history..."));
+  // without its file a series still keeps what fits into RAM
+  if (insideHistorySpill.begin()) insideHistory.setSpill(&insideHistorySpill);
+  if (outsideHistorySpill.begin()) outsideHistory.setSpill(&outsideHistorySpill);
+  historyJob = attachJob("history", HISTORY_SAMPLE_INTERVAL_MS,
+                         HISTORY_SAMPLE_COALESCE_MS, TIMER_WHEEL_PRIORITY_LOW,
+                         recordHistory);
   Serial.println(F("\tOK!"));
 }
 
 void initDataFetch(void) {
   Serial.print(F("Fetching data..."));
-  // set up requestJSON filters and request ticker
-  sensorValueFilter["state"] = true;
-  outSensorValueFilter["attributes"]["temperature"] = true;
   // set up the requests we will be making
-  inTempRequest.onReadyStateChange(apiSensorReadReqCb,
-                                   &insideTempSensorReading);
-  inTempRequestTicker.attach(HTTP_REQUEST_INTERVAL, sendInTempSensorApiRequest);
-
-  outTempRequest.onReadyStateChange(apiSensorReadReqCb,
-                                    &outsideTempSensorReading);
-  outTempRequestTicker.attach(HTTP_REQUEST_INTERVAL,
-                              sendOutTempSensorApiRequest);
+  inTempRequest.onReadyStateChange(apiSensorReadReqCb);
+  inTempRequestJob = attachJob(
+      "inTemp", HTTP_REQUEST_INTERVAL_MS, HTTP_REQUEST_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_LOW, sendInTempSensorApiRequest);
+
+  outTempRequest.onReadyStateChange(apiSensorReadReqCb);
+
+  stockQuoteInit();
+  applySettings();
+  stockPriceRequest.onReadyStateChange(stockQuoteReqCb);
+  stockRequestJob = attachJob(
+      "stock", STOCK_FETCH_INTERVAL_MS, STOCK_REQUEST_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_LOW, sendStockQuoteRequest);
+  outTempRequestJob = attachJob(
+      "outTemp", HTTP_REQUEST_INTERVAL_MS, HTTP_REQUEST_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_LOW, sendOutTempSensorApiRequest);
   sendInTempSensorApiRequest();
   sendOutTempSensorApiRequest();
+  sendStockQuoteRequest();
   Serial.println(F("\tOK!"));
 }
 
+uint32_t utcEpoch(void) {
+  return timeClient.getUTCEpochTime();
+}
+
+uint32_t msUntilNextSecond(void) {
+  return timeClient.msUntilNextSecond();
+}
+
+int32_t utcOffset(void) {
+  return timeClient.getTimeOffset();
+}
+
+void attachFrame(uint8_t *frame) {
+  display.buffer = frame;
+  screen.attach(frame);
+}
+
+const DeskAppHooks APP_HOOKS = {
+    utcEpoch,     msUntilNextSecond, utcOffset,
+    attachFrame,  presentFrame,      drawPageText,
+    invertScreen, goToSleep,         nullptr,
+    publishLiveState,
+};
+
 void setup(void) {
+  app.setHooks(APP_HOOKS);
   Serial.begin(115200);
+  initLogging();
   // Increment boot number and print it every reboot
   ++bootCount;
   Serial.println(F("Hello Hacker!"));
@@ -797,6 +1799,8 @@ void setup(void) {
   }
 
   initDeviceSettings();
+  logSetLevel(deviceSettings.debugMode ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO);
+  initTimeZone();
 
   if (esp_sleep_enable_touchpad_wakeup() == ESP_OK) {
     touchAttachInterrupt(TOUCH_PIN, touchInterruptCb, TOUCH_TRESHOLD);
@@ -805,16 +1809,50 @@ void setup(void) {
   }
 
   initDisplay();
-  initWifiAndSleep();
 
-  uiLoop.attach(UI_LOOP_INTERVAL, processInteractions);
-  mainEventLoop.attach(MAIN_EVENT_LOOP_INTERVAL, updateMainLoop);
+  // draw the last known state before anything waits for the network
+  bool instantFrame = deviceSettings.isSetup && restoreBootSnapshot();
+  if (instantFrame) {
+    app.setShowWiFiIcon(deviceSettings.displayWifiIndicator);
+    app.mainFrameChanged(false);
+    app.renderMainFrame(false);
+  }
+
+  initWifiAndSleep(instantFrame);
+  initPowerManagement();
+  if (deviceSettings.debugMode) initInputLog();
+
+  touchJob = attachJob("touch", TOUCH_GESTURES_SAMPLE_INTERVAL_MS,
+                       TOUCH_SAMPLE_COALESCE_MS, TIMER_WHEEL_PRIORITY_HIGH,
+                       processTouch);
+  scheduler.disable(touchJob);
+  touchBaselineJob = attachJob(
+      "touchBase", TOUCH_BASELINE_INTERVAL_MS, TOUCH_BASELINE_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_LOW, updateTouchBaseline);
+  mainEventLoopJob = attachJob(
+      "main", MAIN_EVENT_LOOP_INTERVAL_MS, MAIN_EVENT_LOOP_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_NORMAL, updateMainLoop);
+  app.setMainJob(mainEventLoopJob);
+  // fresh data replaces the boot snapshot's right away
+  scheduler.trigger(mainEventLoopJob);
+  bootCacheJob = attachJob(
+      "bootCache", BOOT_CACHE_UPDATE_INTERVAL_MS, BOOT_CACHE_UPDATE_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_LOW, refreshBootSnapshot);
+
+  if (deviceSettings.debugMode) {
+    attachJob("stats", SCHEDULER_STATS_INTERVAL_MS,
+              SCHEDULER_STATS_INTERVAL_MS / 2, TIMER_WHEEL_PRIORITY_LOW,
+              printSchedulerStats);
+  }
 
   if (deviceSettings.isSetup && WiFi.isConnected()) {
     initTimeClient();
     initDataFetch();
+    initHistory();
     setupWebServer();
   }
+
+  runScheduler();
 }
 
 void loop(void) {}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+// recorded HomeAssistant responses
+static const char IN_SENSOR_URL[] =
+    "http://homeassistant.local:8123/api/states/sensor.indoor_temperature";
+static const char OUT_SENSOR_URL[] =
+    "http://homeassistant.local:8123/api/states/weather.forecast_home";
+static const char IN_SENSOR_RESPONSE[] =
+    "{\"entity_id\":\"sensor.indoor_temperature\",\"state\":\"22.4\","
+    "\"attributes\":{\"unit_of_measurement\":\"\xC2\xB0" "C\","
+    "\"device_class\":\"temperature\",\"friendly_name\":\"Indoor\"},"
+    "\"last_changed\":\"2022-11-02T18:41:09.514862+00:00\","
+    "\"last_updated\":\"2022-11-02T18:41:09.514862+00:00\"}";
+static const char OUT_SENSOR_RESPONSE[] =
+    "{\"entity_id\":\"weather.forecast_home\",\"state\":\"cloudy\","
+    "\"attributes\":{\"temperature\":-3.5,\"humidity\":81,"
+    "\"pressure\":1012.3,\"wind_bearing\":250.1,\"wind_speed\":14.8,"
+    "\"friendly_name\":\"Forecast Home\"},"
+    "\"last_changed\":\"2022-11-02T18:30:00.000000+00:00\","
+    "\"last_updated\":\"2022-11-02T18:41:00.000000+00:00\"}";
+
+// recorded quote in the Finnhub /quote format
+static const char STOCK_QUOTE_URL_TEMPLATE[] =
+    "http://quotes.local/api/v1/quote?symbol={symbol}";
+static const char STOCK_QUOTE_URL[] =
+    "http://quotes.local/api/v1/quote?symbol=WDAY";
+static const char STOCK_QUOTE_RESPONSE[] =
+    "{\"c\":261.74,\"d\":2.29,\"dp\":0.8826,\"h\":263.31,\"l\":260.68,"
+    "\"o\":261.07,\"pc\":259.45,\"t\":1667414469}";
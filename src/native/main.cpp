@@ -0,0 +1,980 @@
+/**
+ * Host simulator for the desk display.
+ *
+ * Runs the firmware's DeskApp with the portable scheduling, drawing and
+ * HomeAssistant parsing code against a virtual clock, scripted touch input and
+ * a loopback HTTP server, as fast as the host allows. Frames go to a mock
+ * panel bus on a transfer thread, the same way they go over I2C on the device,
+ * and every frame that arrives is checked against the one that was queued. The last frame on the mock panel can be
+ * dumped as a PBM image. A viewer thread meanwhile reads the frame on display
+ * in pieces the way GET /screen.pbm does and checks every image it completes.
+ * With a boot cache file the first frame is drawn from
+ * the readings the previous run left in it, the way the device boots.
+ *
+ * Every HTTP response, clock sync, WiFi change and touch reading can be
+ * recorded into an input log. Replaying one, from the simulator or from
+ * GET /inputs.bin of a device, feeds the same inputs through the firmware's
+ * own DeskApp handlers at the same virtual times instead of the loopback
+ * routes and the touch script, so two builds can be compared on one session.
+ *
+ * More panels can share the bus with the main one. Each shows the next page
+ * after the previous panel's, the clock page as a copy of the main panel's
+ * frame, and gets its frames checked the same way.
+ *
+ *   desk_display_sim [--seconds N] [--touch AT_MS:DURATION_MS]... [--offline]
+ *                    [--rssi DBM] [--pbm FILE] [--boot-cache FILE]
+ *                    [--record FILE] [--replay FILE] [--panels N]
+ */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "BootCache.h"
+#include "DeskApp.h"
+#include "DisplayPipeline.h"
+#include "Framebuffer.h"
+#include "HaSensor.h"
+#include "Hal.h"
+#include "InputLog.h"
+#include "LiveEvents.h"
+#include "Logger.h"
+#include "LoopbackHttp.h"
+#include "PanelFanout.h"
+#include "PowerLedger.h"
+#include "StockTicker.h"
+#include "TimeSeries.h"
+#include "TimerWheel.h"
+#include "TouchGestures.h"
+#include "Widgets.h"
+#include "fixtures.h"
+
+#define SIM_HTTP_DELAY_MS 180
+#define SIM_HTTP_POLL_MS 10
+// frames the mock bus can be waiting for, only ever one in practice
+#define DISPLAY_SIM_MAX_QUEUED 4
+// the device's default bus speed, for the frame time flush() plans with
+#define SIM_I2C_FREQUENCY 700000
+#define SIM_I2C_CHUNK_SIZE 64
+// the screen viewer reads a TCP segment's worth at a time
+#define SIM_SCREEN_CHUNK 536
+#define SIM_SCREEN_INTERVAL_MS 2
+
+// stands in for the flash file on the device
+#define HISTORY_SIM_SLOTS 16
+
+// the virtual clock starts at 2022-11-02T18:41:09Z, a trading day
+#define SIM_START_EPOCH 1667414469UL
+
+/**
+ * Stands in for the I2C bus and the panel's RAM. Pages arrive one by one
+ * with the renderer free to run in between, and every frame that completes
+ * must be the next one queued, bit for bit.
+ */
+class MockPanelBus : public DisplayTransport {
+  private:
+    std::mutex _mutex;
+    uint32_t   _expected[DISPLAY_SIM_MAX_QUEUED];
+    uint32_t   _head = 0;
+    uint32_t   _tail = 0;
+
+  public:
+    uint8_t  panel[FRAMEBUFFER_SIZE];
+    uint32_t framesReceived = 0;
+    uint32_t framesMismatched = 0;
+
+    static uint32_t checksum(const uint8_t *frame) {
+      uint32_t hash = 2166136261UL;
+      for (uint16_t i = 0; i < FRAMEBUFFER_SIZE; i++) {
+        hash = (hash ^ frame[i]) * 16777619UL;
+      }
+      return hash;
+    }
+
+    // called by the renderer right before it queues frame
+    void expect(const uint8_t *frame) {
+      std::lock_guard<std::mutex> lock(this->_mutex);
+      this->_expected[this->_head++ % DISPLAY_SIM_MAX_QUEUED] = checksum(frame);
+    }
+
+    // for a frame not queued yet being drawn again, or dropped without frame
+    void replaceLast(const uint8_t *frame) {
+      std::lock_guard<std::mutex> lock(this->_mutex);
+      if (frame) {
+        this->_expected[(this->_head - 1) % DISPLAY_SIM_MAX_QUEUED] =
+            checksum(frame);
+      } else {
+        this->_head--;
+      }
+    }
+
+    void sendFrame(const uint8_t *frame) override {
+      for (uint8_t page = 0; page < FRAMEBUFFER_PAGES; page++) {
+        memcpy(this->panel + page * FRAMEBUFFER_WIDTH,
+               frame + page * FRAMEBUFFER_WIDTH, FRAMEBUFFER_WIDTH);
+        std::this_thread::yield();
+      }
+
+      std::lock_guard<std::mutex> lock(this->_mutex);
+      bool inOrder = this->_tail != this->_head &&
+                     this->_expected[this->_tail++ % DISPLAY_SIM_MAX_QUEUED] ==
+                         checksum(this->panel);
+
+      this->framesReceived++;
+      if (!inOrder) this->framesMismatched++;
+    }
+};
+
+uint8_t frames[2][FRAMEBUFFER_SIZE];
+Framebuffer screen(frames[0]);
+
+MockPanelBus panelBus;
+DisplayPipeline displayPipeline(panelBus);
+
+// the panels besides the main one, see --panels
+MockPanelBus extraBuses[PANEL_FANOUT_MAX_PANELS];
+uint8_t extraFrames[PANEL_FANOUT_MAX_PANELS][2][FRAMEBUFFER_SIZE];
+DisplayPipeline extraPipelines[PANEL_FANOUT_MAX_PANELS] = {
+    extraBuses[0], extraBuses[1], extraBuses[2], extraBuses[3]};
+PanelFanout panelFanout;
+uint16_t panelBusMs = panelFrameBusMs(SIM_I2C_FREQUENCY, SIM_I2C_CHUNK_SIZE);
+
+// PBM checksum of every queued frame by frame number, 0 is the blank front
+// buffer before the first swap
+std::mutex frameChecksumMutex;
+std::vector<uint32_t> frameChecksums;
+std::atomic<bool> viewerStop{false};
+uint32_t screenImages = 0;
+uint32_t screenRetries = 0;
+uint32_t screenRestarts = 0;
+uint32_t screenTorn = 0;
+
+uint32_t imageChecksum(const uint8_t *image) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < FRAMEBUFFER_PBM_SIZE; i++) {
+    hash = (hash ^ image[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+uint32_t pbmChecksum(const uint8_t *frame) {
+  uint8_t image[FRAMEBUFFER_PBM_SIZE];
+  framebufferReadPbm(frame, 0, image, sizeof(image));
+
+  return imageChecksum(image);
+}
+
+struct ScreenRead {
+  size_t   offset;
+  uint8_t *out;
+  size_t   length;
+  size_t   written;
+};
+
+void readScreen(const uint8_t *frame, void *ctx) {
+  ScreenRead *read = (ScreenRead *)ctx;
+
+  read->written =
+      framebufferReadPbm(frame, read->offset, read->out, read->length);
+}
+
+// what the device's GET /screen.pbm response filler does, a piece per call
+void screenViewerLoop(void) {
+  uint8_t image[FRAMEBUFFER_PBM_SIZE];
+
+  while (!viewerStop) {
+    uint32_t shown = 0;
+    size_t offset = 0;
+
+    while (offset < sizeof(image) && !viewerStop) {
+      size_t length = sizeof(image) - offset;
+      ScreenRead read = {offset, image + offset,
+                         length < SIM_SCREEN_CHUNK ? length : SIM_SCREEN_CHUNK,
+                         0};
+      uint32_t frame;
+
+      if (!displayPipeline.readFront(readScreen, &read, frame)) {
+        screenRetries++;
+      } else if (offset > 0 && frame != shown) {
+        break;
+      } else {
+        shown = frame;
+        offset += read.written;
+      }
+      std::this_thread::yield();
+    }
+
+    if (viewerStop) break;
+
+    if (offset < sizeof(image)) {
+      screenRestarts++;
+      continue;
+    }
+
+    uint32_t hash = imageChecksum(image);
+    {
+      std::lock_guard<std::mutex> lock(frameChecksumMutex);
+      if (shown >= frameChecksums.size() || frameChecksums[shown] != hash) {
+        screenTorn++;
+      }
+    }
+    screenImages++;
+
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(SIM_SCREEN_INTERVAL_MS));
+  }
+}
+
+std::mutex transferMutex;
+std::condition_variable transferWakeup;
+bool transferRequested = false;
+bool transferStop = false;
+
+void displayTransferLoop(void) {
+  std::unique_lock<std::mutex> lock(transferMutex);
+
+  while (true) {
+    transferWakeup.wait(lock, [] { return transferRequested || transferStop; });
+    if (transferStop && !transferRequested) return;
+    transferRequested = false;
+
+    lock.unlock();
+    // the main panel first, then one other panel a pass
+    while (displayPipeline.transferPending() | panelFanout.transferNext()) {
+    }
+    lock.lock();
+  }
+}
+
+void wakeTransfer(void) {
+  std::lock_guard<std::mutex> lock(transferMutex);
+  transferRequested = true;
+  transferWakeup.notify_one();
+}
+
+void presentFrame(void) {
+  panelBus.expect(displayPipeline.backBuffer());
+  {
+    std::lock_guard<std::mutex> lock(frameChecksumMutex);
+    frameChecksums.push_back(pbmChecksum(displayPipeline.backBuffer()));
+  }
+  while (!displayPipeline.swap()) {
+    std::this_thread::yield();
+  }
+  screen.attach(displayPipeline.backBuffer());
+  panelFanout.reserve(halMillis(), panelBusMs);
+
+  wakeTransfer();
+}
+
+/**
+ * Spilled history blocks, kept in memory with erased slots like a fresh file
+ */
+class MemorySpill : public TimeSeriesSpill {
+  public:
+    uint8_t slots[HISTORY_SIM_SLOTS][TIME_SERIES_BLOCK_SIZE];
+    uint32_t writes = 0;
+
+    MemorySpill() { memset(this->slots, 0xFF, sizeof(this->slots)); }
+
+    uint16_t slotCount() override { return HISTORY_SIM_SLOTS; }
+
+    bool writeSlot(uint16_t slot, const uint8_t *block) override {
+      memcpy(this->slots[slot], block, TIME_SERIES_BLOCK_SIZE);
+      this->writes++;
+      return true;
+    }
+
+    bool readSlot(uint16_t slot, uint8_t *block) override {
+      memcpy(block, this->slots[slot], TIME_SERIES_BLOCK_SIZE);
+      return true;
+    }
+};
+
+TimerWheel scheduler(halMillis);
+LoopbackHttp http;
+// in virtual time, where jobs take no time at all, so this shows how long
+// requests keep the chip out of light sleep and how often it wakes up
+PowerLedger powerLedger;
+int8_t mainEventLoopJob = TIMER_WHEEL_INVALID_JOB;
+int8_t touchJob = TIMER_WHEEL_INVALID_JOB;
+int8_t stockRequestJob = TIMER_WHEEL_INVALID_JOB;
+
+StockTicker stockTicker;
+
+TouchGestures touchGestures(HAL_TOUCH_UNTOUCHED, SLEEP_TOUCH_THRESHOLD_LONG);
+bool touchSampling = false;
+
+uint8_t insideHistoryBuffer[HISTORY_RAM_SIZE];
+uint8_t outsideHistoryBuffer[HISTORY_RAM_SIZE];
+TimeSeries insideHistory(insideHistoryBuffer, sizeof(insideHistoryBuffer));
+TimeSeries outsideHistory(outsideHistoryBuffer, sizeof(outsideHistoryBuffer));
+MemorySpill insideHistorySpill;
+MemorySpill outsideHistorySpill;
+
+// the firmware's display logic, the hooks are set in main()
+DeskApp app(screen, displayPipeline, panelFanout, scheduler, stockTicker,
+            insideHistory, outsideHistory);
+// what --boot-cache restored, updated with what came in before it is saved
+BootSnapshot bootSnapshot;
+
+uint32_t taps = 0;
+uint32_t doubleTaps = 0;
+bool asleep = false;
+
+uint32_t responsesParsed = 0;
+
+// set by clock syncs like NTPClient, the virtual clock starts synced
+uint32_t ntpEpoch = SIM_START_EPOCH;
+uint32_t ntpSyncedAt = 0;
+
+// inputs of this run for --record, nullptr when not recording
+InputLogWriter *inputRecorder = nullptr;
+uint32_t inputsRecorded = 0;
+uint16_t recordedTouch = 0;
+bool recordedWiFiConnected = false;
+uint8_t recordedWiFiBars = 0;
+bool wifiRecorded = false;
+bool touchRecorded = false;
+
+// the log of --replay and its next record
+std::vector<uint8_t> replayData;
+InputLogReader replay(nullptr, 0);
+InputLogRecord replayNext;
+bool replaying = false;
+bool replayHasNext = false;
+uint32_t inputsReplayed = 0;
+uint32_t replayUnmatched = 0;
+
+// the device drains the log on a task of its own, here it happens after
+// every scheduler tick
+void printLog(void) {
+  LogRecord record;
+  char line[LOG_PREFIX_SIZE + LOG_TEXT_SIZE];
+
+  while (logRead(record)) {
+    logFormat(record, line, sizeof(line));
+    puts(line);
+  }
+}
+
+uint32_t simEpoch(void) {
+  return ntpEpoch + (halMillis() - ntpSyncedAt) / 1000;
+}
+
+uint32_t msUntilNextSecond(void) {
+  return 1000 - (halMillis() - ntpSyncedAt) % 1000;
+}
+
+size_t writeInputLog(void *ctx, const uint8_t *data, size_t length) {
+  return fwrite(data, 1, length, (FILE *)ctx);
+}
+
+void recordResponse(void *ctx, const char *url, int status, const char *body,
+                    size_t length) {
+  InputLogWriter *recorder = (InputLogWriter *)ctx;
+
+  recorder->http(halMillis(), status, url, (const uint8_t *)body, length);
+  inputsRecorded++;
+}
+
+// what NTPClient::forceUpdate() does with a server's answer
+void syncClock(uint32_t epoch, uint16_t msIntoSecond) {
+  ntpEpoch = epoch;
+  ntpSyncedAt = halMillis() - msIntoSecond;
+  app.setTimeSynced();
+
+  if (inputRecorder) {
+    inputRecorder->ntp(halMillis(), epoch, msIntoSecond);
+    inputsRecorded++;
+  }
+}
+
+// touch is recorded when it changes and WiFi when the icon would, which is
+// all a replay needs
+uint16_t readTouch(void) {
+  uint16_t level = halTouchRead();
+
+  if (inputRecorder && (!touchRecorded || level != recordedTouch)) {
+    inputRecorder->touch(halMillis(), level);
+    inputsRecorded++;
+    recordedTouch = level;
+    touchRecorded = true;
+  }
+
+  return level;
+}
+
+void recordWiFi(bool connected, int32_t rssi) {
+  uint8_t bars = connected ? wifiBarsForRSSI(rssi) : 0;
+
+  if (!inputRecorder || (wifiRecorded && connected == recordedWiFiConnected &&
+                         bars == recordedWiFiBars)) {
+    return;
+  }
+
+  inputRecorder->wifi(halMillis(), connected, connected ? (int8_t)rssi : 0);
+  inputsRecorded++;
+  recordedWiFiConnected = connected;
+  recordedWiFiBars = bars;
+  wifiRecorded = true;
+}
+
+bool loadReplay(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return false;
+
+  uint8_t chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    replayData.insert(replayData.end(), chunk, chunk + length);
+  }
+  fclose(file);
+
+  InputLogReader check(replayData.data(), replayData.size());
+  InputLogRecord record;
+  if (!check.begin()) return false;
+  while (check.next(record)) {
+  }
+  // a device stops recording mid-record when its buffer is full
+  if (!check.complete()) {
+    fprintf(stderr, "%s: cut off, replaying the records before\n", path);
+  }
+
+  replay = InputLogReader(replayData.data(), replayData.size());
+  replay.begin();
+  replayHasNext = replay.next(replayNext);
+  replaying = true;
+
+  return true;
+}
+
+// stands in for the touch interrupt, which keeps firing while the pad reads
+// below the press level
+uint32_t msUntilTouch(void) {
+  if (!replaying) return halSimMsUntilTouch();
+
+  return halTouchRead() < touchGestures.pressLevel() ? 0 : UINT32_MAX;
+}
+
+uint32_t msUntilReplay(void) {
+  if (!replayHasNext) return UINT32_MAX;
+  if (replayNext.ms <= halMillis()) return 0;
+
+  return replayNext.ms - halMillis();
+}
+
+// feeds every record that is due through the path the live input takes:
+// responses go to the request waiting for them and from there to DeskApp,
+// touch and WiFi to the HAL
+void applyReplay(void) {
+  while (replayHasNext && replayNext.ms <= halMillis()) {
+    const InputLogRecord &record = replayNext;
+    char url[LOOPBACK_HTTP_MAX_URL];
+
+    switch (record.type) {
+    case INPUT_LOG_HTTP:
+      snprintf(url, sizeof(url), "%.*s", (int)record.urlLength, record.url);
+      if (!http.respond(url, record.status, (const char *)record.body,
+                        record.bodyLength)) {
+        LOG_WARN("Replay: no request for %s waiting", url);
+        replayUnmatched++;
+      }
+      break;
+    case INPUT_LOG_NTP:
+      syncClock(record.epoch, record.msIntoSecond);
+      break;
+    case INPUT_LOG_WIFI:
+      halSimSetWiFi(record.connected, record.rssi);
+      break;
+    case INPUT_LOG_TOUCH:
+      halSimSetTouch(record.touch);
+      break;
+    }
+
+    inputsReplayed++;
+    replayHasNext = replay.next(replayNext);
+  }
+}
+
+void onSensorResponse(void *arg, int status, const char *body,
+                      size_t length) {
+  powerLedger.end(POWER_ACTIVITY_NETWORK, halMillis() * 1000ULL);
+
+  if (app.handleSensorResponse((DeskAppSensor)(uintptr_t)arg, status,
+                               (const uint8_t *)body, length)) {
+    responsesParsed++;
+  }
+}
+
+void onStockQuoteResponse(void *arg, int status, const char *body,
+                          size_t length) {
+  powerLedger.end(POWER_ACTIVITY_NETWORK, halMillis() * 1000ULL);
+
+  if (app.handleStockResponse((uint8_t)(uintptr_t)arg, status,
+                              (const uint8_t *)body, length)) {
+    responsesParsed++;
+  }
+}
+
+// every request holds the network until its callback
+bool sendRequest(const char *url, LoopbackHttpCallback callback, void *arg) {
+  if (!http.get(url, callback, arg)) return false;
+
+  powerLedger.begin(POWER_ACTIVITY_NETWORK, halMillis() * 1000ULL);
+  return true;
+}
+
+void sendStockQuoteRequest(void) {
+  uint8_t symbols = stockTicker.symbolCount();
+  if (symbols == 0) return;
+
+  scheduler.setNextRun(stockRequestJob,
+                       stockFetchIntervalMs(simEpoch()) / symbols);
+
+  char url[STOCK_QUOTE_URL_SIZE];
+  uint8_t index = app.nextStockFetch();
+  if (stockQuoteUrl(STOCK_QUOTE_URL_TEMPLATE, stockTicker.symbol(index), url,
+                    sizeof(url)) &&
+      !sendRequest(url, onStockQuoteResponse, (void *)(uintptr_t)index)) {
+    LOG_WARN("Can't send Request");
+  }
+}
+
+void sendInTempSensorApiRequest(void) {
+  if (!sendRequest(IN_SENSOR_URL, onSensorResponse,
+                   (void *)(uintptr_t)DESK_APP_INSIDE)) {
+    LOG_WARN("Can't send Request");
+  }
+}
+
+void sendOutTempSensorApiRequest(void) {
+  if (!sendRequest(OUT_SENSOR_URL, onSensorResponse,
+                   (void *)(uintptr_t)DESK_APP_OUTSIDE)) {
+    LOG_WARN("Can't send Request");
+  }
+}
+
+void recordHistory(void) {
+  app.recordHistory();
+}
+
+void attachFrame(uint8_t *frame) {
+  screen.attach(frame);
+}
+
+void onDoubleTap(void) {
+  LOG_INFO("Double tap");
+  doubleTaps++;
+}
+
+void onLongPress(void) {
+  LOG_INFO("Going to sleep now");
+  asleep = true;
+}
+
+// every frame an extra panel takes is checked like the main panel's
+void onPanelSubmitted(uint8_t panel, bool pending, bool accepted) {
+  uint8_t *back = panelFanout.backBuffer(panel);
+
+  if (accepted) {
+    if (pending) {
+      extraBuses[panel].replaceLast(back);
+    } else {
+      extraBuses[panel].expect(back);
+    }
+  } else if (pending) {
+    extraBuses[panel].replaceLast(nullptr);
+  }
+}
+
+// logs what a viewer of GET /events would be sent
+void onLiveStateUpdated(const LiveState &state, uint8_t changes) {
+  char data[LIVE_EVENT_DATA_SIZE];
+
+  for (uint8_t event = 1; event & LIVE_EVENT_ALL; event <<= 1) {
+    if (!(changes & event)) continue;
+
+    liveFormatEvent(event, state, data, sizeof(data));
+    LOG_INFO("Event %s: %s", liveEventName(event), data);
+  }
+}
+
+void processTouch(void) {
+  touchGestures.sample(halMillis(), readTouch());
+
+  TouchEvent event;
+  while (touchGestures.nextEvent(event)) {
+    if (event.type == TOUCH_EVENT_TAP) {
+      LOG_INFO("Tap");
+      taps++;
+    }
+    app.handleTouchEvent(event);
+  }
+
+  if (!touchGestures.active()) {
+    scheduler.disable(touchJob);
+    touchSampling = false;
+  }
+}
+
+void updateTouchBaseline(void) {
+  if (!touchSampling) touchGestures.sample(halMillis(), readTouch());
+}
+
+void updateMainLoop(void) {
+  bool connected = halWiFiConnected();
+  recordWiFi(connected, halWiFiRSSI());
+
+  if (app.update(connected)) wakeTransfer();
+
+  app.scheduleNextFrame(app.activity() || !connected);
+}
+
+// panel i shows page i + 1 and so on, the history graphs wherever the stock
+// symbols put them
+void assignPanelPages(void) {
+  for (uint8_t panel = 0; panel < panelFanout.count(); panel++) {
+    uint8_t page = (panel + 1) % (app.historyPage() + 1);
+
+    app.setPanelPage(panel, page == app.historyPage() ? DESK_APP_HISTORY_PAGE
+                                                      : page);
+  }
+}
+
+static const DeskAppHooks SIM_HOOKS = {
+    simEpoch,         msUntilNextSecond, nullptr,
+    attachFrame,      presentFrame,      nullptr,
+    onDoubleTap,      onLongPress,       onPanelSubmitted,
+    onLiveStateUpdated,
+};
+
+void writeToFile(void *ctx, const uint8_t *data, size_t length) {
+  fwrite(data, 1, length, (FILE *)ctx);
+}
+
+size_t writeBootCache(void *ctx, const uint8_t *data, size_t length) {
+  return fwrite(data, 1, length, (FILE *)ctx);
+}
+
+size_t readBootCache(void *ctx, uint8_t *data, size_t length) {
+  return fread(data, 1, length, (FILE *)ctx);
+}
+
+bool restoreBootSnapshot(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return false;
+
+  BootSnapshot snapshot;
+  bool loaded = bootCacheLoad(snapshot, readBootCache, file);
+  fclose(file);
+  if (!loaded) return false;
+
+  app.restoreSnapshot(snapshot);
+  bootSnapshot = snapshot;
+
+  return true;
+}
+
+bool saveBootSnapshot(const char *path) {
+  BootSnapshot snapshot = bootSnapshot;
+  app.updateSnapshot(snapshot);
+
+  FILE *file = fopen(path, "wb");
+  if (!file) return false;
+
+  bool saved = bootCacheSave(snapshot, writeBootCache, file);
+  return fclose(file) == 0 && saved;
+}
+
+void printSchedulerStats(void) {
+  printf("Scheduler: %u wakeups, %u idle\n", scheduler.wakeups(),
+         scheduler.idleWakeups());
+
+  for (int8_t job = 0; job < scheduler.jobCount(); job++) {
+    const TimerWheelJobStats *stats = scheduler.jobStats(job);
+    printf("  %-10s runs %u overruns %u late max %ums avg %ums run max %ums\n",
+           scheduler.jobName(job), stats->runs, stats->overruns,
+           stats->maxLateMs, stats->avgLateMs, stats->maxRunMs);
+  }
+
+  printf("Frames: %u rendered, %u skipped, %u sent, %u swaps refused\n",
+         app.framePacer().framesRendered(), app.framePacer().framesSkipped(),
+         displayPipeline.framesSent(), displayPipeline.swapsRefused());
+
+  uint64_t now = halMillis() * 1000ULL;
+  printf("Power:\n");
+  for (uint8_t state = 0; state < POWER_STATE_COUNT; state++) {
+    uint16_t share = powerLedger.basisPoints(state, now);
+    printf("  %-8s %3u.%02u%% %10llums %8u entries\n", powerStateName(state),
+           share / 100, share % 100,
+           (unsigned long long)(powerLedger.timeIn(state, now) / 1000),
+           powerLedger.entries(state));
+  }
+}
+
+void usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [--seconds N] [--touch AT_MS:DURATION_MS]... "
+          "[--offline] [--rssi DBM] [--pbm FILE] [--boot-cache FILE] "
+          "[--record FILE] [--replay FILE] [--panels N]\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  uint32_t seconds = 120;
+  const char *pbmPath = nullptr;
+  const char *bootCachePath = nullptr;
+  const char *recordPath = nullptr;
+  const char *replayPath = nullptr;
+  int32_t rssi = -60;
+  bool online = true;
+  uint8_t panels = 1;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--touch") == 0 && i + 1 < argc) {
+      unsigned long at, duration;
+      if (sscanf(argv[++i], "%lu:%lu", &at, &duration) != 2 ||
+          !halSimScriptTouch(at, duration)) {
+        usage(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--offline") == 0) {
+      online = false;
+    } else if (strcmp(argv[i], "--rssi") == 0 && i + 1 < argc) {
+      rssi = strtol(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--pbm") == 0 && i + 1 < argc) {
+      pbmPath = argv[++i];
+    } else if (strcmp(argv[i], "--boot-cache") == 0 && i + 1 < argc) {
+      bootCachePath = argv[++i];
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--panels") == 0 && i + 1 < argc) {
+      unsigned long count = strtoul(argv[++i], nullptr, 10);
+      if (count < 1 || count > PANEL_FANOUT_MAX_PANELS + 1) {
+        usage(argv[0]);
+        return 1;
+      }
+      panels = count;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  app.setHooks(SIM_HOOKS);
+  memset(&bootSnapshot, 0, sizeof(bootSnapshot));
+  bootSnapshot.insideReading = SENSOR_NO_VALUE;
+  bootSnapshot.outsideReading = SENSOR_NO_VALUE;
+
+  FILE *recordFile = nullptr;
+  if (recordPath) {
+    recordFile = fopen(recordPath, "wb");
+    if (!recordFile) {
+      perror(recordPath);
+      return 1;
+    }
+  }
+  InputLogWriter recorder(writeInputLog, recordFile);
+  if (recordFile) {
+    inputRecorder = &recorder;
+    recorder.begin();
+    http.setTap(recordResponse, &recorder);
+  }
+
+  halSimSetWiFi(online, rssi);
+
+  if (replayPath) {
+    if (!loadReplay(replayPath)) {
+      fprintf(stderr, "%s: not an input log of version %u\n",
+              replayPath, INPUT_LOG_VERSION);
+      return 1;
+    }
+    // responses, the clock, WiFi and touch all come from the log
+    http.hold(true);
+    applyReplay();
+    online = halWiFiConnected();
+  } else {
+    syncClock(SIM_START_EPOCH, 0);
+    http.route(IN_SENSOR_URL, 200, IN_SENSOR_RESPONSE, SIM_HTTP_DELAY_MS);
+    http.route(OUT_SENSOR_URL, 200, OUT_SENSOR_RESPONSE, SIM_HTTP_DELAY_MS);
+    http.route(STOCK_QUOTE_URL, 200, STOCK_QUOTE_RESPONSE, SIM_HTTP_DELAY_MS);
+  }
+  recordWiFi(halWiFiConnected(), halWiFiRSSI());
+
+  displayPipeline.attach(frames[0], frames[1]);
+  frameChecksums.push_back(pbmChecksum(frames[1]));
+  for (uint8_t panel = 0; panel + 1 < panels; panel++) {
+    extraPipelines[panel].attach(extraFrames[panel][0],
+                                 extraFrames[panel][1]);
+    panelFanout.addPanel(extraPipelines[panel], panelBusMs);
+  }
+  std::thread transferThread(displayTransferLoop);
+  std::thread viewerThread(screenViewerLoop);
+
+  stockQuoteInit();
+  app.setStockSymbols("WDAY");
+  assignPanelPages();
+  insideHistory.setSpill(&insideHistorySpill);
+  outsideHistory.setSpill(&outsideHistorySpill);
+
+  touchJob = scheduler.attach("touch", TOUCH_GESTURES_SAMPLE_INTERVAL_MS,
+                              TOUCH_SAMPLE_COALESCE_MS,
+                              TIMER_WHEEL_PRIORITY_HIGH, processTouch);
+  scheduler.disable(touchJob);
+  scheduler.attach("touchBase", TOUCH_BASELINE_INTERVAL_MS,
+                   TOUCH_BASELINE_COALESCE_MS, TIMER_WHEEL_PRIORITY_LOW,
+                   updateTouchBaseline);
+  mainEventLoopJob = scheduler.attach(
+      "main", MAIN_EVENT_LOOP_INTERVAL_MS, MAIN_EVENT_LOOP_COALESCE_MS,
+      TIMER_WHEEL_PRIORITY_NORMAL, updateMainLoop);
+  app.setMainJob(mainEventLoopJob);
+  // the first frame goes out right away, from the cache when there is one
+  bool fromBootCache = bootCachePath && restoreBootSnapshot(bootCachePath);
+  scheduler.trigger(mainEventLoopJob);
+  if (online) {
+    scheduler.attach("inTemp", HTTP_REQUEST_INTERVAL_MS,
+                     HTTP_REQUEST_COALESCE_MS, TIMER_WHEEL_PRIORITY_LOW,
+                     sendInTempSensorApiRequest);
+    scheduler.attach("outTemp", HTTP_REQUEST_INTERVAL_MS,
+                     HTTP_REQUEST_COALESCE_MS, TIMER_WHEEL_PRIORITY_LOW,
+                     sendOutTempSensorApiRequest);
+    stockRequestJob = scheduler.attach(
+        "stock", STOCK_FETCH_INTERVAL_MS, STOCK_REQUEST_COALESCE_MS,
+        TIMER_WHEEL_PRIORITY_LOW, sendStockQuoteRequest);
+    scheduler.attach("history", HISTORY_SAMPLE_INTERVAL_MS,
+                     HISTORY_SAMPLE_COALESCE_MS, TIMER_WHEEL_PRIORITY_LOW,
+                     recordHistory);
+    sendInTempSensorApiRequest();
+    sendOutTempSensorApiRequest();
+    sendStockQuoteRequest();
+  }
+
+  uint32_t endMs = seconds * 1000;
+
+  while (!asleep && halMillis() < endMs) {
+    uint32_t waitMs = scheduler.msUntilNextWake();
+
+    // wake up in between scheduler deadlines to deliver HTTP responses
+    if (http.inFlight() > 0 && waitMs > SIM_HTTP_POLL_MS) {
+      waitMs = SIM_HTTP_POLL_MS;
+    }
+    // the touch interrupt wakes the scheduler when a finger lands
+    if (!touchSampling && msUntilTouch() < waitMs) {
+      waitMs = msUntilTouch();
+    }
+    if (msUntilReplay() < waitMs) waitMs = msUntilReplay();
+    if (waitMs > endMs - halMillis()) waitMs = endMs - halMillis();
+
+    halSimAdvance(waitMs);
+    http.poll();
+    applyReplay();
+    if (!touchSampling && msUntilTouch() == 0) {
+      touchSampling = true;
+      scheduler.trigger(touchJob);
+    }
+    powerLedger.begin(POWER_ACTIVITY_CPU, halMillis() * 1000ULL);
+    scheduler.tick();
+    powerLedger.end(POWER_ACTIVITY_CPU, halMillis() * 1000ULL);
+    printLog();
+  }
+
+  printf("Simulated %u ms, %u responses parsed, %u taps, %u double taps\n",
+         halMillis(), responsesParsed, taps, doubleTaps);
+  char inside[HA_FIXED_TEXT_SIZE], outside[HA_FIXED_TEXT_SIZE];
+  haFormatFixed(app.reading(DESK_APP_INSIDE), HA_SENSOR_TEMPERATURE.decimals,
+                inside, sizeof(inside));
+  haFormatFixed(app.reading(DESK_APP_OUTSIDE), HA_WEATHER_TEMPERATURE.decimals,
+                outside, sizeof(outside));
+  printf("Readings: %s°C | %s°C\n", inside, outside);
+  for (uint8_t i = 0; i < stockTicker.symbolCount(); i++) {
+    char price[12], change[12], percent[12];
+    stockFormatCents(stockTicker.price(i), false, price, sizeof(price));
+    stockFormatCents(stockTicker.change(i), true, change, sizeof(change));
+    stockFormatCents(stockTicker.changeBasisPoints(i), true, percent,
+                     sizeof(percent));
+    printf("Stock: %s %s %s %s%%, %u samples\n", stockTicker.symbol(i), price,
+           change, percent, stockTicker.historyLength(i));
+  }
+  printf("Boot: first frame at %u ms%s, ", app.firstFrameMs(),
+         fromBootCache ? " from the boot cache" : "");
+  if (app.freshFrameMs() == UINT32_MAX) {
+    printf("no fresh data\n");
+  } else {
+    printf("fresh data at %u ms\n", app.freshFrameMs());
+  }
+  if (bootCachePath && !saveBootSnapshot(bootCachePath)) {
+    perror(bootCachePath);
+  }
+  TimeSeriesStats stats;
+  if (insideHistory.stats(0, UINT32_MAX, stats)) {
+    printf("History: %u samples a sensor, %u + %u bytes in RAM, %u blocks "
+           "spilled, inside %d..%d avg %d tenths\n",
+           stats.count, (unsigned)insideHistory.bytesUsed(),
+           (unsigned)outsideHistory.bytesUsed(),
+           insideHistorySpill.writes + outsideHistorySpill.writes, stats.min,
+           stats.max, stats.avg);
+  }
+  {
+    std::lock_guard<std::mutex> lock(transferMutex);
+    transferStop = true;
+    transferWakeup.notify_one();
+  }
+  transferThread.join();
+  viewerStop = true;
+  viewerThread.join();
+
+  printSchedulerStats();
+  printf("Panel: %u frames received, %u torn or out of order\n",
+         panelBus.framesReceived, panelBus.framesMismatched);
+  uint32_t extraMismatched = 0;
+  for (uint8_t panel = 0; panel < panelFanout.count(); panel++) {
+    printf("Panel %u: %u frames received, %u torn or out of order, %u "
+           "unchanged, %u deferred\n",
+           panel + 1, extraBuses[panel].framesReceived,
+           extraBuses[panel].framesMismatched,
+           panelFanout.framesUnchanged(panel),
+           panelFanout.framesDeferred(panel));
+    extraMismatched += extraBuses[panel].framesMismatched;
+  }
+  if (replaying) {
+    printf("Replay: %u inputs replayed, %u responses with no request waiting\n",
+           inputsReplayed, replayUnmatched);
+  }
+  if (recordFile) {
+    bool written = !recorder.failed();
+    if (fclose(recordFile) != 0) written = false;
+    if (!written) perror(recordPath);
+    printf("Record: %u inputs in %u bytes\n", inputsRecorded,
+           (unsigned)recorder.bytesWritten());
+  }
+  printf("Screen: %u images read, %u pieces retried, %u restarted on a new "
+         "frame, %u torn\n",
+         screenImages, screenRetries, screenRestarts, screenTorn);
+
+  if (pbmPath) {
+    FILE *file = fopen(pbmPath, "wb");
+    if (!file) {
+      perror(pbmPath);
+      return 1;
+    }
+
+    // what the panel shows, not what was rendered last
+    Framebuffer(panelBus.panel).writePbm(writeToFile, file);
+    fclose(file);
+  }
+
+  return panelBus.framesMismatched > 0 || extraMismatched > 0 ||
+                 screenTorn > 0 || replayUnmatched > 0
+             ? 1
+             : 0;
+}
@@ -0,0 +1,195 @@
+/**
+ * Framebuffer fast paths against the pixel at a time reference: every bit
+ * offset within a page, rectangles straddling pages, word alignment of the
+ * column runs and edges clipped on all four sides, on a frame that already
+ * has pixels set.
+ *
+ *   pio test -e native -f test_framebuffer
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "Framebuffer.h"
+
+static uint8_t fastFrame[FRAMEBUFFER_SIZE] __attribute__((aligned(4)));
+static uint8_t referenceFrame[FRAMEBUFFER_SIZE] __attribute__((aligned(4)));
+static Framebuffer fast(fastFrame);
+static Framebuffer reference(referenceFrame);
+
+// what the fast path must leave alone
+static void fillBackground(uint8_t pattern) {
+  for (size_t i = 0; i < FRAMEBUFFER_SIZE; i++) {
+    fastFrame[i] = (uint8_t)(pattern ^ (i * 37));
+  }
+  memcpy(referenceFrame, fastFrame, sizeof(referenceFrame));
+}
+
+static void clearRectPixels(Framebuffer &frame, int16_t x, int16_t y,
+                            int16_t w, int16_t h) {
+  for (int16_t i = x; i < x + w; i++) {
+    for (int16_t j = y; j < y + h; j++) {
+      frame.clearPixel(i, j);
+    }
+  }
+}
+
+static void assertSameFrame(const char *what, int16_t a, int16_t b, int16_t c,
+                            int16_t d) {
+  if (memcmp(fastFrame, referenceFrame, FRAMEBUFFER_SIZE) == 0) return;
+
+  char message[64];
+  snprintf(message, sizeof(message), "%s(%d, %d, %d, %d)", what, a, b, c, d);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(referenceFrame, fastFrame, FRAMEBUFFER_SIZE,
+                                   message);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// heights up to 17 start at every bit of a page and cover up to three pages,
+// x from 0 to 4 shifts the run against the 32-bit words
+void test_fill_rect_matches_pixels_at_every_offset(void) {
+  for (int16_t y = 0; y < FRAMEBUFFER_HEIGHT; y++) {
+    for (int16_t h = 1; h <= 17; h++) {
+      for (int16_t x = 0; x <= 4; x++) {
+        for (int16_t w = 1; w <= 9; w++) {
+          fillBackground(0x00);
+          fast.fillRect(x, y, w, h);
+          reference.fillRectPixels(x, y, w, h);
+          assertSameFrame("fillRect", x, y, w, h);
+        }
+      }
+    }
+  }
+}
+
+void test_clear_rect_matches_pixels_at_every_offset(void) {
+  for (int16_t y = 0; y < FRAMEBUFFER_HEIGHT; y++) {
+    for (int16_t h = 1; h <= 17; h++) {
+      for (int16_t x = 0; x <= 4; x++) {
+        for (int16_t w = 1; w <= 9; w++) {
+          fillBackground(0xFF);
+          fast.clearRect(x, y, w, h);
+          clearRectPixels(reference, x, y, w, h);
+          assertSameFrame("clearRect", x, y, w, h);
+        }
+      }
+    }
+  }
+}
+
+void test_full_width_rect_straddling_pages(void) {
+  for (int16_t y = 0; y < FRAMEBUFFER_HEIGHT; y++) {
+    for (int16_t h = 1; y + h <= FRAMEBUFFER_HEIGHT; h += 3) {
+      fillBackground(0x5A);
+      fast.fillRect(0, y, FRAMEBUFFER_WIDTH, h);
+      reference.fillRectPixels(0, y, FRAMEBUFFER_WIDTH, h);
+      assertSameFrame("fillRect", 0, y, FRAMEBUFFER_WIDTH, h);
+
+      fillBackground(0x5A);
+      fast.clearRect(0, y, FRAMEBUFFER_WIDTH, h);
+      clearRectPixels(reference, 0, y, FRAMEBUFFER_WIDTH, h);
+      assertSameFrame("clearRect", 0, y, FRAMEBUFFER_WIDTH, h);
+    }
+  }
+}
+
+// rectangles hanging over every edge, or entirely outside, or empty
+void test_rects_are_clipped_at_the_edges(void) {
+  static const int16_t xs[] = {-200, -9, -1, 0, 1, 120, 127, 128, 200};
+  static const int16_t ys[] = {-100, -9, -1, 0, 5, 60, 63, 64, 100};
+  static const int16_t ws[] = {-5, 0, 1, 2, 10, 130, 400};
+  static const int16_t hs[] = {-5, 0, 1, 3, 9, 70, 200};
+
+  for (int16_t x : xs) {
+    for (int16_t y : ys) {
+      for (int16_t w : ws) {
+        for (int16_t h : hs) {
+          fillBackground(0x00);
+          fast.fillRect(x, y, w, h);
+          reference.fillRectPixels(x, y, w, h);
+          assertSameFrame("fillRect", x, y, w, h);
+
+          fillBackground(0xFF);
+          fast.clearRect(x, y, w, h);
+          clearRectPixels(reference, x, y, w, h);
+          assertSameFrame("clearRect", x, y, w, h);
+        }
+      }
+    }
+  }
+}
+
+void test_hline_matches_pixels(void) {
+  for (int16_t y = -1; y <= FRAMEBUFFER_HEIGHT; y++) {
+    for (int16_t x = -6; x <= FRAMEBUFFER_WIDTH + 1; x += 3) {
+      for (int16_t w = -1; w <= 12; w++) {
+        fillBackground(0x00);
+        fast.hline(x, y, w);
+        reference.fillRectPixels(x, y, w, 1);
+        assertSameFrame("hline", x, y, w, 1);
+      }
+    }
+  }
+}
+
+void test_vline_matches_pixels(void) {
+  for (int16_t x = -1; x <= FRAMEBUFFER_WIDTH; x += 43) {
+    for (int16_t y = -10; y <= FRAMEBUFFER_HEIGHT; y++) {
+      for (int16_t h = -1; h <= 20; h++) {
+        fillBackground(0x00);
+        fast.vline(x, y, h);
+        reference.fillRectPixels(x, y, 1, h);
+        assertSameFrame("vline", x, y, 1, h);
+      }
+    }
+  }
+}
+
+// horizontal and vertical lines in both directions take the fast paths, the
+// rest must stay the reference itself
+void test_draw_line_matches_pixels(void) {
+  static const int16_t xs[] = {-20, -1, 0, 3, 64, 126, 127, 128, 150};
+  static const int16_t ys[] = {-12, -1, 0, 7, 8, 31, 62, 63, 64, 80};
+
+  for (int16_t x0 : xs) {
+    for (int16_t y0 : ys) {
+      for (int16_t x1 : xs) {
+        for (int16_t y1 : ys) {
+          fillBackground(0x00);
+          fast.drawLine(x0, y0, x1, y1);
+          reference.drawLinePixels(x0, y0, x1, y1);
+          assertSameFrame("drawLine", x0, y0, x1, y1);
+        }
+      }
+    }
+  }
+}
+
+void test_draw_line_endpoints_are_included(void) {
+  fast.clear();
+
+  fast.drawLine(10, 20, 5, 20);
+  fast.drawLine(40, 30, 40, 17);
+  TEST_ASSERT_TRUE(fast.getPixel(5, 20));
+  TEST_ASSERT_TRUE(fast.getPixel(10, 20));
+  TEST_ASSERT_FALSE(fast.getPixel(11, 20));
+  TEST_ASSERT_TRUE(fast.getPixel(40, 17));
+  TEST_ASSERT_TRUE(fast.getPixel(40, 30));
+  TEST_ASSERT_FALSE(fast.getPixel(40, 16));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fill_rect_matches_pixels_at_every_offset);
+  RUN_TEST(test_clear_rect_matches_pixels_at_every_offset);
+  RUN_TEST(test_full_width_rect_straddling_pages);
+  RUN_TEST(test_rects_are_clipped_at_the_edges);
+  RUN_TEST(test_hline_matches_pixels);
+  RUN_TEST(test_vline_matches_pixels);
+  RUN_TEST(test_draw_line_matches_pixels);
+  RUN_TEST(test_draw_line_endpoints_are_included);
+  return UNITY_END();
+}
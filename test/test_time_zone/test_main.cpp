@@ -0,0 +1,120 @@
+/**
+ * TimeZone's transition table against its own rules and against known
+ * transition instants: northern and southern hemisphere zones, DST all year
+ * round, a malformed string and lookups that leave the table.
+ *
+ *   pio test -e native -f test_time_zone
+ */
+#include <unity.h>
+
+#include "TimeZone.h"
+
+#define HOUR 3600L
+// 2020-01-01 and 2040-01-01 00:00 UTC
+#define FROM_2020 1577836800UL
+#define UNTIL_2040 2208988800UL
+
+// every hour of 2020-2039 through the table, the way the clock asks
+static void assertTableFollowsRules(const char *posix) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set(posix, FROM_2020));
+
+  for (uint32_t utc = FROM_2020; utc < UNTIL_2040; utc += HOUR) {
+    TEST_ASSERT_EQUAL_INT32(zone.offsetFromRules(utc), zone.offsetAt(utc));
+  }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_us_eastern_changes_at_2am_local(void) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set("EST5EDT,M3.2.0,M11.1.0", FROM_2020));
+
+  // 2021-03-14 07:00 UTC, 2021-11-07 06:00 UTC
+  TEST_ASSERT_EQUAL_INT32(-5 * HOUR, zone.offsetAt(1615705200UL - 1));
+  TEST_ASSERT_EQUAL_INT32(-4 * HOUR, zone.offsetAt(1615705200UL));
+  TEST_ASSERT_EQUAL_INT32(-4 * HOUR, zone.offsetAt(1636264800UL - 1));
+  TEST_ASSERT_EQUAL_INT32(-5 * HOUR, zone.offsetAt(1636264800UL));
+  TEST_ASSERT_EQUAL_STRING("EDT", zone.abbreviation(1615705200UL));
+  TEST_ASSERT_EQUAL_STRING("EST", zone.abbreviation(1636264800UL));
+}
+
+void test_southern_zone_leaves_dst_first(void) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set("AEST-10AEDT,M10.1.0,M4.1.0/3", FROM_2020));
+
+  // 2021-04-03 16:00 UTC, 2021-10-02 16:00 UTC
+  TEST_ASSERT_EQUAL_INT32(11 * HOUR, zone.offsetAt(1617465600UL - 1));
+  TEST_ASSERT_EQUAL_INT32(10 * HOUR, zone.offsetAt(1617465600UL));
+  TEST_ASSERT_EQUAL_INT32(10 * HOUR, zone.offsetAt(1633190400UL - 1));
+  TEST_ASSERT_EQUAL_INT32(11 * HOUR, zone.offsetAt(1633190400UL));
+}
+
+void test_table_follows_rules(void) {
+  assertTableFollowsRules("EET-2EEST,M3.5.0/3,M10.5.0/4");
+  assertTableFollowsRules("EST5EDT,M3.2.0,M11.1.0");
+  assertTableFollowsRules("AEST-10AEDT,M10.1.0,M4.1.0/3");
+  assertTableFollowsRules("<-03>3<-02>,M3.5.0/-2,M10.5.0/-1");
+  assertTableFollowsRules("IST-1GMT0,M10.5.0,M3.5.0/1");
+  assertTableFollowsRules("WART4WARST,J1/0,J365/25");
+}
+
+// RFC 8536: DST from January 1 00:00 to December 31 24:00 plus the DST
+// shift is DST all year, the new year included
+void test_dst_all_year_round(void) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set("WART4WARST,J1/0,J365/25", FROM_2020));
+
+  TEST_ASSERT_EQUAL_UINT8(0, zone.transitions());
+  for (uint32_t utc = FROM_2020; utc < UNTIL_2040; utc += HOUR) {
+    TEST_ASSERT_EQUAL_INT32(-3 * HOUR, zone.offsetAt(utc));
+    TEST_ASSERT_EQUAL_INT32(-3 * HOUR, zone.offsetFromRules(utc));
+  }
+  TEST_ASSERT_EQUAL_STRING("WARST", zone.abbreviation(FROM_2020));
+}
+
+// a day of standard time is enough to make it an ordinary DST zone again
+void test_dst_with_a_gap_is_not_all_year(void) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set("WART4WARST,J2/0,J365/25", FROM_2020));
+
+  // 2021-01-01 12:00 UTC is on January 1 either way
+  TEST_ASSERT_EQUAL_INT32(-4 * HOUR, zone.offsetAt(1609502400UL));
+  TEST_ASSERT_EQUAL_INT32(-3 * HOUR, zone.offsetAt(1609502400UL + 24 * HOUR));
+  TEST_ASSERT_EQUAL_UINT8(2 * TIME_ZONE_TABLE_YEARS, zone.transitions());
+}
+
+void test_malformed_string_leaves_zone_unchanged(void) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set("EST5EDT,M3.2.0,M11.1.0", FROM_2020));
+
+  TEST_ASSERT_FALSE(zone.set("EST5EDT,M13.2.0,M11.1.0", FROM_2020));
+  TEST_ASSERT_FALSE(zone.set("E5", FROM_2020));
+  TEST_ASSERT_FALSE(zone.set(nullptr, FROM_2020));
+  TEST_ASSERT_EQUAL_INT32(-4 * HOUR, zone.offsetAt(1615705200UL));
+}
+
+void test_lookup_outside_the_table_rebuilds_it(void) {
+  TimeZone zone;
+  TEST_ASSERT_TRUE(zone.set("EET-2EEST,M3.5.0/3,M10.5.0/4", FROM_2020));
+
+  // 2040-07-01 00:00 UTC, past the eight years built from 2020
+  TEST_ASSERT_EQUAL_INT32(3 * HOUR, zone.offsetAt(2224800000UL));
+  TEST_ASSERT_EQUAL_UINT32(1, zone.rebuilds());
+  TEST_ASSERT_EQUAL_INT32(2 * HOUR, zone.offsetAt(2240611200UL));
+  TEST_ASSERT_EQUAL_UINT32(1, zone.rebuilds());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_us_eastern_changes_at_2am_local);
+  RUN_TEST(test_southern_zone_leaves_dst_first);
+  RUN_TEST(test_table_follows_rules);
+  RUN_TEST(test_dst_all_year_round);
+  RUN_TEST(test_dst_with_a_gap_is_not_all_year);
+  RUN_TEST(test_malformed_string_leaves_zone_unchanged);
+  RUN_TEST(test_lookup_outside_the_table_rebuilds_it);
+  return UNITY_END();
+}
@@ -0,0 +1,237 @@
+/**
+ * TimerWheel against a virtual clock: coalescing, priorities, lateness and
+ * overrun statistics, moved runs, millis() wraparound and a full job table.
+ *
+ *   pio test -e native -f test_timer_wheel
+ */
+#include <unity.h>
+
+#include "TimerWheel.h"
+
+static uint32_t nowMs = 0;
+// how long every callback takes, in virtual ms
+static uint32_t runCostMs = 0;
+
+// job ids in the order they ran
+static int8_t ran[32];
+static uint8_t ranCount = 0;
+
+static int8_t jobA = TIMER_WHEEL_INVALID_JOB;
+static int8_t jobB = TIMER_WHEEL_INVALID_JOB;
+static int8_t jobC = TIMER_WHEEL_INVALID_JOB;
+
+// the next run a callback of jobA asks for, 0 for none
+static uint32_t nextRunFromCallback = 0;
+static TimerWheel *wheel = nullptr;
+
+static uint32_t virtualMillis(void) { return nowMs; }
+
+static void run(int8_t job) {
+  if (ranCount < sizeof(ran)) ran[ranCount++] = job;
+  nowMs += runCostMs;
+}
+
+static void runA(void) {
+  run(jobA);
+  if (nextRunFromCallback) wheel->setNextRun(jobA, nextRunFromCallback);
+}
+
+static void runB(void) { run(jobB); }
+
+static void runC(void) { run(jobC); }
+
+void setUp(void) {
+  nowMs = 0;
+  runCostMs = 0;
+  ranCount = 0;
+  nextRunFromCallback = 0;
+  jobA = jobB = jobC = TIMER_WHEEL_INVALID_JOB;
+}
+
+void tearDown(void) {}
+
+// the wheel sleeps until the end of the earliest window, every job that is
+// due by then runs in that one wakeup
+void test_due_jobs_share_a_wakeup(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 1000, 300, TIMER_WHEEL_PRIORITY_LOW, runA);
+  jobB = scheduler.attach("b", 1200, 0, TIMER_WHEEL_PRIORITY_LOW, runB);
+  TEST_ASSERT_EQUAL_UINT32(1200, scheduler.msUntilNextWake());
+
+  nowMs = 1200;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT8(2, ranCount);
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.wakeups());
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.idleWakeups());
+
+  // a's deadline stays on its own period, 2000, and b's window is empty
+  TEST_ASSERT_EQUAL_UINT32(1100, scheduler.msUntilNextWake());
+}
+
+void test_waking_before_any_deadline_is_idle(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 1000, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+
+  nowMs = 999;
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.tick());
+  TEST_ASSERT_EQUAL_UINT8(0, ranCount);
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.idleWakeups());
+}
+
+void test_due_jobs_run_highest_priority_first(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 100, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+  jobB = scheduler.attach("b", 100, 0, TIMER_WHEEL_PRIORITY_HIGH, runB);
+  jobC = scheduler.attach("c", 100, 0, TIMER_WHEEL_PRIORITY_NORMAL, runC);
+
+  nowMs = 100;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT8(3, ranCount);
+  TEST_ASSERT_EQUAL_INT8(jobB, ran[0]);
+  TEST_ASSERT_EQUAL_INT8(jobC, ran[1]);
+  TEST_ASSERT_EQUAL_INT8(jobA, ran[2]);
+}
+
+void test_lateness_is_measured_against_the_deadline(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 100, 50, TIMER_WHEEL_PRIORITY_LOW, runA);
+
+  nowMs = 140;
+  scheduler.tick();
+  const TimerWheelJobStats *stats = scheduler.jobStats(jobA);
+  TEST_ASSERT_EQUAL_UINT32(1, stats->runs);
+  TEST_ASSERT_EQUAL_UINT32(40, stats->maxLateMs);
+  TEST_ASSERT_EQUAL_UINT32(40 >> 3, stats->avgLateMs);
+  TEST_ASSERT_EQUAL_UINT32(0, stats->overruns);
+
+  // phase-locked: the next deadline is 200, not 240
+  nowMs = 200;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT32(2, stats->runs);
+  TEST_ASSERT_EQUAL_UINT32(40, stats->maxLateMs);
+  // an eighth of 0 pulls 5 down by nothing, the average only moves slowly
+  TEST_ASSERT_EQUAL_UINT32(5, stats->avgLateMs);
+}
+
+void test_a_long_run_skips_the_periods_it_covered(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 100, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+
+  nowMs = 100;
+  runCostMs = 250;
+  scheduler.tick();
+  const TimerWheelJobStats *stats = scheduler.jobStats(jobA);
+  TEST_ASSERT_EQUAL_UINT32(250, stats->maxRunMs);
+  // done at 350, the runs due at 200 and 300 are gone
+  TEST_ASSERT_EQUAL_UINT32(2, stats->overruns);
+  TEST_ASSERT_EQUAL_UINT32(50, scheduler.msUntilNextWake());
+}
+
+void test_next_run_can_be_moved(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 1000, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+  scheduler.setNextRun(jobA, 200);
+  TEST_ASSERT_EQUAL_UINT32(200, scheduler.msUntilNextWake());
+
+  nowMs = 200;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT8(1, ranCount);
+  // later runs follow the period from the moved one
+  TEST_ASSERT_EQUAL_UINT32(1000, scheduler.msUntilNextWake());
+}
+
+void test_next_run_can_be_moved_from_the_callback(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  wheel = &scheduler;
+  jobA = scheduler.attach("a", 1000, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+  nextRunFromCallback = 30;
+
+  nowMs = 1000;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT32(30, scheduler.msUntilNextWake());
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.jobStats(jobA)->overruns);
+  wheel = nullptr;
+}
+
+void test_a_disabled_job_runs_again_once_moved(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 1000, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+  scheduler.disable(jobA);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, scheduler.msUntilNextWake());
+
+  scheduler.setNextRun(jobA, 10);
+  nowMs = 10;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT8(1, ranCount);
+}
+
+void test_deadlines_survive_millis_wraparound(void) {
+  nowMs = UINT32_MAX - 100;
+  TimerWheel scheduler(virtualMillis);
+
+  jobA = scheduler.attach("a", 300, 0, TIMER_WHEEL_PRIORITY_LOW, runA);
+  TEST_ASSERT_EQUAL_UINT32(300, scheduler.msUntilNextWake());
+
+  // the deadline is past the wrap, a wakeup before it must not run the job
+  nowMs = UINT32_MAX;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT8(0, ranCount);
+  TEST_ASSERT_EQUAL_UINT32(200, scheduler.msUntilNextWake());
+
+  nowMs += 210;
+  scheduler.tick();
+  TEST_ASSERT_EQUAL_UINT8(1, ranCount);
+  TEST_ASSERT_EQUAL_UINT32(10, scheduler.jobStats(jobA)->maxLateMs);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.jobStats(jobA)->overruns);
+  TEST_ASSERT_EQUAL_UINT32(290, scheduler.msUntilNextWake());
+}
+
+void test_attach_fails_once_the_table_is_full(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  for (uint8_t i = 0; i < TIMER_WHEEL_MAX_JOBS; i++) {
+    TEST_ASSERT_EQUAL_INT8(i, scheduler.attach("job", 1000, 0,
+                                               TIMER_WHEEL_PRIORITY_LOW, runA));
+  }
+  TEST_ASSERT_EQUAL_INT8(TIMER_WHEEL_INVALID_JOB,
+                         scheduler.attach("extra", 1000, 0,
+                                          TIMER_WHEEL_PRIORITY_LOW, runA));
+  TEST_ASSERT_EQUAL_UINT8(TIMER_WHEEL_MAX_JOBS, scheduler.jobCount());
+}
+
+void test_attach_refuses_a_job_that_can_never_run(void) {
+  TimerWheel scheduler(virtualMillis);
+
+  TEST_ASSERT_EQUAL_INT8(TIMER_WHEEL_INVALID_JOB,
+                         scheduler.attach("a", 0, 0, TIMER_WHEEL_PRIORITY_LOW,
+                                          runA));
+  TEST_ASSERT_EQUAL_INT8(TIMER_WHEEL_INVALID_JOB,
+                         scheduler.attach("a", 100, 0,
+                                          TIMER_WHEEL_PRIORITY_LOW, nullptr));
+  TEST_ASSERT_EQUAL_UINT8(0, scheduler.jobCount());
+  TEST_ASSERT_NULL(scheduler.jobStats(TIMER_WHEEL_INVALID_JOB));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_due_jobs_share_a_wakeup);
+  RUN_TEST(test_waking_before_any_deadline_is_idle);
+  RUN_TEST(test_due_jobs_run_highest_priority_first);
+  RUN_TEST(test_lateness_is_measured_against_the_deadline);
+  RUN_TEST(test_a_long_run_skips_the_periods_it_covered);
+  RUN_TEST(test_next_run_can_be_moved);
+  RUN_TEST(test_next_run_can_be_moved_from_the_callback);
+  RUN_TEST(test_a_disabled_job_runs_again_once_moved);
+  RUN_TEST(test_deadlines_survive_millis_wraparound);
+  RUN_TEST(test_attach_fails_once_the_table_is_full);
+  RUN_TEST(test_attach_refuses_a_job_that_can_never_run);
+  return UNITY_END();
+}